@@ -0,0 +1,187 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Priority of acyclic work, lower values are served first.
+ */
+enum class AcyclicPriority : uint8_t { Safety = 0, Diagnostics = 1, Parameter = 2, Size = 3 };
+
+/*!
+ * Returns a readable representation of an acyclic priority.
+ */
+std::string acyclicPriorityToString(AcyclicPriority priority);
+
+/*!
+ * Queueing statistics of the acyclic work of one priority.
+ */
+struct AcyclicStatistics {
+  /// Executed tasks.
+  uint64_t executed{0};
+  /// Task executions which were postponed to a later cycle because the budget was used up.
+  uint64_t deferrals{0};
+  /// Time from a task becoming due to its execution [ns].
+  double meanQueueingDelayNs{0.0};
+  long maxQueueingDelayNs{0};
+  /// Execution time of the tasks [ns].
+  double meanExecutionNs{0.0};
+  long maxExecutionNs{0};
+  /// Tasks which ran longer than the remaining budget they were admitted with.
+  uint64_t budgetOverruns{0};
+};
+
+/*!
+ * Admission of acyclic work which runs in a thread of its own because it waits for datagram round trips, e.g. the
+ * mailbox service and the slave state monitor of the EthercatMaster. Registered with AcyclicScheduler::addService(),
+ * the service is granted a run by the update thread instead of being executed there. The service thread waits for the
+ * grant, runs and reports its execution time, which the scheduler charges to the budget of its next cycle. A service
+ * whose previous run has not finished is not granted again. Without a scheduler running (before the update loop starts,
+ * while it stalls) the service runs on its own after the wait timeout, there is no cycle to protect then.
+ * The grant is an eventfd: the update thread neither locks nor allocates.
+ */
+class AcyclicService {
+ public:
+  AcyclicService();
+  ~AcyclicService();
+
+  AcyclicService(const AcyclicService&) = delete;
+  AcyclicService& operator=(const AcyclicService&) = delete;
+
+  /*!
+   * Service thread: wait for the next run, call finish() after it.
+   * @param[in] timeoutNs longest time to wait [ns].
+   * @return true if the run was granted, or if no scheduler ran during the wait nor during the timeout before it. false
+   * if the scheduler kept deferring the service.
+   */
+  bool waitForGrant(long timeoutNs);
+
+  /*!
+   * Service thread: report the end of a run.
+   * @param[in] executionNs execution time of the run [ns].
+   */
+  void finish(long executionNs);
+
+ private:
+  friend class AcyclicScheduler;
+
+  // scheduler: false while a run has not finished.
+  bool grant();
+  // scheduler: execution time of the last finished run, -1 if none was reported since.
+  long takeExecutionNs() { return executionNs_.exchange(-1, std::memory_order_acquire); }
+
+  int fd_{-1};
+  std::atomic<bool> busy_{false};
+  std::atomic<long> executionNs_{-1};
+  // CLOCK_MONOTONIC time of the last run() of the scheduler, 0 before the first one.
+  std::atomic<long> lastScheduledNs_{0};
+};
+
+/*!
+ * Runs periodic acyclic work (diagnosis datagrams, parameter traffic) in the update thread within a per-cycle time
+ * budget, and grants the runs of the services which do their work in threads of their own (see AcyclicService). Due tasks are executed by priority and then by due time. Safety tasks are executed whenever
+ * they are due, their execution time is taken from the budget of the lower priorities. The other tasks are executed
+ * as long as their expected execution time (a running average of the measured one) fits into the remaining budget,
+ * the rest is deferred to the next cycles. The first of them in a cycle is admitted whenever budget is left, so that
+ * tasks longer than the budget still progress.
+ * Tasks are registered before the update loop starts, run() does not allocate or lock.
+ */
+class AcyclicScheduler {
+ public:
+  using Task = std::function<void()>;
+
+  /*!
+   * Register a periodic task. Not thread safe with respect to run().
+   * @param[in] name name for the statistics and logs.
+   * @param[in] priority priority of the task.
+   * @param[in] periodCycles the task becomes due every periodCycles calls of run().
+   * @param[in] task the work.
+   */
+  void addTask(const std::string& name, AcyclicPriority priority, unsigned int periodCycles, Task task);
+
+  /*!
+   * Register a service running in a thread of its own. Its runs are granted like tasks are executed, with the expected
+   * execution time of the reported runs. Not thread safe with respect to run().
+   * @param[in] service outlives the scheduler or the next clear().
+   */
+  void addService(const std::string& name, AcyclicPriority priority, unsigned int periodCycles, AcyclicService& service);
+
+  /*!
+   * Change the period of the tasks and services of this name, e.g. of a time based service after a change of the time
+   * step. A pending run stays due. Not thread safe with respect to run().
+   * @return false if there is no task or service of this name.
+   */
+  bool setPeriod(const std::string& name, unsigned int periodCycles);
+
+  /*!
+   * Remove all tasks and reset the statistics. Not thread safe with respect to run().
+   */
+  void clear();
+
+  /*!
+   * Advance one cycle and execute the due tasks which fit into the budget.
+   * @param[in] nowNs current CLOCK_MONOTONIC time [ns].
+   * @param[in] budgetNs time available for acyclic work in this cycle [ns], negative: unlimited, 0: defer everything
+   * but the safety tasks.
+   */
+  void run(long nowNs, long budgetNs);
+
+  /*!
+   * Returns the statistics of every priority, indexed by AcyclicPriority. Thread safe, the values are read one by one
+   * while run() updates them and may stem from consecutive cycles.
+   */
+  std::array<AcyclicStatistics, static_cast<size_t>(AcyclicPriority::Size)> getStatistics() const;
+
+  /*!
+   * Reset the statistics. Thread safe.
+   */
+  void resetStatistics();
+
+  /*!
+   * Human readable statistics, e.g. for logging. Thread safe.
+   */
+  std::string statisticsToString() const;
+
+ private:
+  struct Entry {
+    std::string name;
+    AcyclicPriority priority{AcyclicPriority::Parameter};
+    unsigned int periodCycles{1};
+    Task task;
+    AcyclicService* service{nullptr};
+    // a run of the service was granted and not reported yet, with the remaining budget it was admitted with.
+    bool granted{false};
+    long admittedNs{0};
+    // false while the service is busy in the current cycle.
+    bool available{true};
+    unsigned int cycleCount{0};
+    bool due{false};
+    long dueNs{0};
+    double expectedExecutionNs{0.0};
+  };
+
+  // written by run() only, the means are computed when the statistics are read.
+  struct Counters {
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> deferrals{0};
+    std::atomic<long> totalQueueingDelayNs{0};
+    std::atomic<long> maxQueueingDelayNs{0};
+    std::atomic<long> totalExecutionNs{0};
+    std::atomic<long> maxExecutionNs{0};
+    std::atomic<uint64_t> budgetOverruns{0};
+  };
+
+  // statistics of an execution or a reported service run.
+  void recordExecution(Entry& entry, long executionNs, long remainingNs, bool unlimited);
+
+  std::vector<Entry> tasks_;
+  std::array<Counters, static_cast<size_t>(AcyclicPriority::Size)> counters_{};
+};
+
+}  // namespace ecat_master
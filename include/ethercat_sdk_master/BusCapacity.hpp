@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ethercat_sdk_master/CycleStatistics.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace ecat_master {
+
+/*!
+ * Layout of the mapped process image as configured by SOEM.
+ */
+struct ProcessImageInfo {
+  unsigned int slaves{0};
+  /// Outputs (RxPDOs, master to slaves) [bytes].
+  uint32_t outputBytes{0};
+  /// Inputs (TxPDOs, slaves to master) [bytes].
+  uint32_t inputBytes{0};
+  /// Number of frames needed to exchange the process image.
+  unsigned int frames{0};
+  /// true if inputs and outputs are exchanged with separate datagrams instead of a single LRW.
+  bool blockLRW{false};
+  /// true if distributed clocks are used, adds the DC time datagram to the first frame.
+  bool hasDc{false};
+  /// Propagation delay from the first to the last slave as measured by the DC setup, 0 if unknown [ns].
+  long propagationDelayNs{0};
+};
+
+/*!
+ * Utilisation of the bus and the projected capacity for additional slaves.
+ */
+struct BusCapacityEstimate {
+  ProcessImageInfo image;
+
+  /// Time needed to serialize all cyclic frames at 100 MBit/s incl. Ethernet and EtherCAT overhead [ns].
+  double wireTimeNs{0.0};
+  /// Forwarding delay of the frames through all slaves and back [ns].
+  double loopDelayNs{0.0};
+  /// Roundtrip expected from wireTimeNs and loopDelayNs [ns].
+  double estimatedRoundtripNs{0.0};
+  /// Roundtrip measured in the update loop, 0 if no cycle has been measured yet [ns].
+  double measuredRoundtripNs{0.0};
+  double maxMeasuredRoundtripNs{0.0};
+  /// 99th percentile of the roundtrip over the most recent cycles, 0 if no cycle has been measured yet [ns].
+  double recentRoundtripP99Ns{0.0};
+
+  /// Configured cycle time [ns].
+  double cycleTimeNs{0.0};
+  /// Shortest achievable cycle time: the 99th percentile of the recently measured roundtrip if available, otherwise the
+  /// estimated roundtrip [ns].
+  double minCycleTimeNs{0.0};
+  /// Share of the cycle the wire is busy with cyclic frames [0, 1].
+  double busUtilisation{0.0};
+  /// Share of the cycle left after the roundtrip, negative if the cycle does not fit [-, 1].
+  double headroom{0.0};
+
+  /// Projection for the requested additional slaves.
+  unsigned int additionalSlaves{0};
+  double projectedMinCycleTimeNs{0.0};
+  double projectedHeadroom{0.0};
+  /// Number of slaves with the requested PDO sizes which still fit into the configured cycle.
+  unsigned int maxAdditionalSlaves{0};
+
+  /*!
+   * Human readable summary, e.g. for logging.
+   */
+  std::string toString() const;
+};
+
+/*!
+ * Estimate the bus utilisation and the cycle capacity.
+ * Wire time and slave delays are modelled for 100BASE-TX: 80ns per byte incl. preamble, Ethernet header, FCS and
+ * inter frame gap, 12 bytes overhead per datagram and about 1us forwarding delay per slave if no DC propagation
+ * delay is known. The measured roundtrip additionally contains the master network stack latency, projections are
+ * therefore added to the measured roundtrip.
+ * @param[in] image current process image.
+ * @param[in] statistics measured cycle statistics.
+ * @param[in] cycleTimeNs configured cycle time.
+ * @param[in] additionalSlaves number of slaves to project.
+ * @param[in] rxPdoSize output bytes of every additional slave.
+ * @param[in] txPdoSize input bytes of every additional slave.
+ */
+BusCapacityEstimate estimateBusCapacity(const ProcessImageInfo& image, const CycleStatistics& statistics, double cycleTimeNs,
+                                        unsigned int additionalSlaves = 0, uint32_t rxPdoSize = 0, uint32_t txPdoSize = 0);
+
+}  // namespace ecat_master
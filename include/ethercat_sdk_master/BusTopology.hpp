@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * One end of a cable: an ESC port of a slave. Slave 0 is the master NIC.
+ */
+struct PortEndpoint {
+  uint16_t slave{0};
+  uint8_t port{0};
+};
+
+/*!
+ * A physical connection between two ports, upstream is the side closer to the master.
+ */
+struct PortLink {
+  PortEndpoint upstream;
+  PortEndpoint downstream;
+};
+
+/*!
+ * Port connections of the bus, one link per slave (the link through which the slave was reached).
+ */
+struct BusTopology {
+  std::vector<PortLink> links;
+
+  /// Index into links of the link attached to (slave, port), -1 if the port is not connected.
+  int linkAt(uint16_t slave, uint8_t port) const;
+};
+
+/*!
+ * Per port error counters of an ESC.
+ */
+struct PortErrorCounters {
+  static constexpr size_t numberOfPorts{4};
+  /// RX error counters (0x0300 + 2 * port): invalid frame counter in the low byte, physical layer error counter in the high byte.
+  std::array<uint16_t, numberOfPorts> rxErrors{};
+  /// Lost link counters (0x0310 + port).
+  std::array<uint8_t, numberOfPorts> lostLinks{};
+};
+
+/*!
+ * Most likely faulty link, derived from the error counters.
+ */
+struct LinkFaultEstimate {
+  /// false as long as no error counter increase could be attributed to a link.
+  bool valid{false};
+  PortLink link{};
+  /// Decayed error rate attributed to the link (errors per diagnosis update).
+  double score{0.0};
+  /// Share of the total decayed error rate on the bus attributed to this link [0, 1].
+  double confidence{0.0};
+  /// Both ends of the link count receive errors, which points to the cable or both connectors.
+  bool bothDirections{false};
+  /// Human readable description, e.g. for logging.
+  std::string description;
+};
+
+/*!
+ * Localizes the most likely faulty link or connector from the per port error counters of the ESCs.
+ * An ESC only increments the RX error counter of a port for frames which were not already marked as
+ * corrupt by a slave upstream, so an increase is attributed to the link attached to the receiving port.
+ * Counter increases are accumulated with an exponential decay, the estimate therefore follows the bus
+ * incrementally with every diagnosis update.
+ */
+class LinkFaultLocalizer {
+ public:
+  /*!
+   * Set the bus topology, resets the accumulated scores.
+   */
+  void setTopology(const BusTopology& topology);
+
+  /*!
+   * Feed a new set of error counters.
+   * @param[in] counters counters[i] belongs to the slave at bus position i + 1.
+   */
+  void update(const std::vector<PortErrorCounters>& counters);
+
+  /*!
+   * Current estimate. Thread safe.
+   */
+  LinkFaultEstimate getEstimate() const;
+
+ private:
+  /// Decay of the accumulated scores per update.
+  static constexpr double decay_{0.9};
+  /// Minimal score before a link is reported.
+  static constexpr double reportThreshold_{0.5};
+
+  mutable std::mutex mutex_;
+  BusTopology topology_;
+  std::vector<double> upstreamScore_;    // receive errors counted on the upstream port of a link
+  std::vector<double> downstreamScore_;  // receive errors counted on the downstream port of a link
+  std::vector<std::vector<uint32_t>> lastCounters_;
+  LinkFaultEstimate estimate_;
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace ecat_master {
+
+/*!
+ * State of the current update cycle, owned by the EthercatMaster and updated once at the start of every update.
+ * Devices read it through EthercatDevice::getCycleContext() instead of reading the clock themselves, which gives all
+ * devices the same time base. Only valid in the update thread (updateWrite / updateRead and after update()).
+ */
+struct CycleContext {
+  /// Number of the cycle, starting at 0 with the first update.
+  uint64_t cycle{0};
+  /// Start of the cycle, CLOCK_MONOTONIC [ns].
+  int64_t startTimeNs{0};
+  /// Start of the cycle, wall clock time.
+  std::chrono::system_clock::time_point startSystemTime{};
+  /// Time since the start of the previous cycle [ns], 0 in the first cycle.
+  int64_t measuredPeriodNs{0};
+  /// Configured time step [ns].
+  int64_t timeStepNs{0};
+  /// DC system time of the reference clock from the last received frame [ns], 0 without distributed clocks.
+  int64_t dcTimeNs{0};
+  /// The previous cycle ended after its deadline (standalone update modes only).
+  bool overrun{false};
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+namespace ecat_master {
+
+/*!
+ * Performance counters of the update thread over one cycle, see EthercatMasterConfiguration::perfCounters.
+ */
+struct PerfCounterValues {
+  double instructions{0.0};
+  double cpuCycles{0.0};
+  /// Last level cache misses.
+  double cacheMisses{0.0};
+  double contextSwitches{0.0};
+};
+
+/*!
+ * Timing statistics of the cyclic communication, measured by the EthercatMaster in every update.
+ */
+struct CycleStatistics {
+  /// Number of measured cycles.
+  uint64_t cycles{0};
+
+  /// Time between sending the process data frames and receiving them back, without the device callbacks of
+  /// updateWrite and updateRead [ns].
+  long lastRoundtripNs{0};
+  double meanRoundtripNs{0.0};
+  long maxRoundtripNs{0};
+  /// 99th percentile of the roundtrip over the last RoundtripWindow::size cycles [ns].
+  long recentRoundtripP99Ns{0};
+
+  /// Cycles in which the working counter was too low.
+  uint64_t workingCounterErrors{0};
+
+  /// Cycles which ended after their deadline (standalone update modes only).
+  uint64_t overruns{0};
+
+  /// UpdateMode::ExternalTrigger: triggered cycles, cycles run without trigger after a timeout and triggers which were
+  /// missed because the previous cycle took too long.
+  uint64_t triggers{0};
+  uint64_t missedTriggers{0};
+  uint64_t coalescedTriggers{0};
+  /// Time from the trigger to sending the process data [ns].
+  double meanTriggerLatencyNs{0.0};
+  long maxTriggerLatencyNs{0};
+  /// Interval between triggers, its standard deviation and largest deviation from the mean [ns].
+  double meanTriggerIntervalNs{0.0};
+  double triggerJitterNs{0.0};
+  long maxTriggerJitterNs{0};
+  /// Triggers with an interval and sum of the squared interval deviations, for the jitter.
+  uint64_t triggerIntervals{0};
+  double triggerIntervalSquaredDeviations{0.0};
+
+  /// Cycles with performance counter values, see EthercatMasterConfiguration::perfCounters.
+  uint64_t counterCycles{0};
+  /// Cycles whose measured period exceeded the time step by more than 10%, a subset of counterCycles.
+  uint64_t outlierCycles{0};
+  /// Mean counters of the regular and of the outlier cycles, to tell e.g. cache misses from preemption.
+  PerfCounterValues meanCounters;
+  PerfCounterValues meanOutlierCounters;
+  /// Counters of the longest cycle and its period [ns].
+  PerfCounterValues longestCycleCounters;
+  long longestCycleNs{0};
+
+  /*!
+   * Add a roundtrip measurement.
+   */
+  void addRoundtrip(long roundtripNs) {
+    cycles++;
+    lastRoundtripNs = roundtripNs;
+    meanRoundtripNs += (static_cast<double>(roundtripNs) - meanRoundtripNs) / static_cast<double>(cycles);
+    if (roundtripNs > maxRoundtripNs) {
+      maxRoundtripNs = roundtripNs;
+    }
+  }
+
+  /*!
+   * Add a triggered cycle.
+   * @param[in] latencyNs time from the trigger to sending the process data.
+   * @param[in] intervalNs time since the previous trigger, 0 if unknown.
+   * @param[in] coalesced triggers missed since the previous cycle.
+   */
+  void addTrigger(long latencyNs, long intervalNs, uint64_t coalesced) {
+    triggers++;
+    coalescedTriggers += coalesced;
+    meanTriggerLatencyNs += (static_cast<double>(latencyNs) - meanTriggerLatencyNs) / static_cast<double>(triggers);
+    maxTriggerLatencyNs = std::max(maxTriggerLatencyNs, latencyNs);
+    if (intervalNs <= 0) {
+      return;
+    }
+    triggerIntervals++;
+    const double deviation = static_cast<double>(intervalNs) - meanTriggerIntervalNs;
+    meanTriggerIntervalNs += deviation / static_cast<double>(triggerIntervals);
+    triggerIntervalSquaredDeviations += deviation * (static_cast<double>(intervalNs) - meanTriggerIntervalNs);
+    triggerJitterNs = std::sqrt(triggerIntervalSquaredDeviations / static_cast<double>(triggerIntervals));
+    maxTriggerJitterNs = std::max(maxTriggerJitterNs, static_cast<long>(std::abs(static_cast<double>(intervalNs) - meanTriggerIntervalNs)));
+  }
+
+  /*!
+   * Add the performance counters of a cycle.
+   * @param[in] periodNs measured period of the cycle.
+   * @param[in] outlier the cycle took too long.
+   */
+  void addCounters(const PerfCounterValues& counters, long periodNs, bool outlier) {
+    counterCycles++;
+    PerfCounterValues& mean = outlier ? meanOutlierCounters : meanCounters;
+    const double count = static_cast<double>(outlier ? ++outlierCycles : counterCycles - outlierCycles);
+    mean.instructions += (counters.instructions - mean.instructions) / count;
+    mean.cpuCycles += (counters.cpuCycles - mean.cpuCycles) / count;
+    mean.cacheMisses += (counters.cacheMisses - mean.cacheMisses) / count;
+    mean.contextSwitches += (counters.contextSwitches - mean.contextSwitches) / count;
+    if (periodNs > longestCycleNs) {
+      longestCycleNs = periodNs;
+      longestCycleCounters = counters;
+    }
+  }
+};
+
+/*!
+ * Roundtrips of the most recent cycles, e.g. for a percentile which is not dominated by a single outlier in the past.
+ * add() is called by the update thread only and never blocks, percentile() may be called from any thread.
+ */
+class RoundtripWindow {
+ public:
+  static constexpr size_t size{1024};
+
+  /*!
+   * Writer: add the roundtrip of a cycle, replacing the oldest one once the window is full.
+   */
+  void add(long roundtripNs) {
+    const uint64_t count = count_.load(std::memory_order_relaxed);
+    samples_[count % size].store(roundtripNs, std::memory_order_relaxed);
+    count_.store(count + 1, std::memory_order_release);
+  }
+
+  /*!
+   * Writer: drop all roundtrips.
+   */
+  void clear() { count_.store(0, std::memory_order_release); }
+
+  /*!
+   * Roundtrip not exceeded by the given share of the cycles in the window, 0 if the window is empty.
+   * @param[in] quantile share of the cycles [0, 1].
+   */
+  long percentile(double quantile) const {
+    const auto count = static_cast<size_t>(std::min<uint64_t>(count_.load(std::memory_order_acquire), size));
+    if (count == 0) {
+      return 0;
+    }
+    std::array<long, size> sorted{};
+    for (size_t i = 0; i < count; i++) {
+      sorted[i] = samples_[i].load(std::memory_order_relaxed);
+    }
+    const auto rank = static_cast<size_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count)));
+    const auto nth = sorted.begin() + static_cast<long>(std::max<size_t>(rank, 1) - 1);
+    std::nth_element(sorted.begin(), nth, sorted.begin() + static_cast<long>(count));
+    return *nth;
+  }
+
+ private:
+  std::array<std::atomic<long>, size> samples_{};
+  std::atomic<uint64_t> count_{0};
+};
+
+}  // namespace ecat_master
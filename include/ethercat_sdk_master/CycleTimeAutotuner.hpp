@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Options of EthercatMaster::autotuneTimeStep.
+ */
+struct AutotuneOptions {
+  /// Shortest time step to try [s].
+  double minTimeStep{0.00025};
+  /// Longest time step to try [s], 0: the current time step (see EthercatMaster::setTimeStep).
+  double maxTimeStep{0.0};
+  /// Number of time steps tried between maxTimeStep and minTimeStep (geometrically spaced).
+  unsigned int steps{8};
+  /// Number of update cycles per time step.
+  unsigned int cyclesPerStep{2000};
+
+  /// Acceptance criteria of a time step.
+  double maxOverrunRatio{0.001};
+  uint64_t maxWorkingCounterErrors{0};
+  /// Maximal absolute DC system time difference of the slaves, ignored on buses without DC [ns].
+  long maxDcSyncErrorNs{1000};
+
+  /// The recommended time step is the shortest safe one increased by this ratio.
+  double margin{0.2};
+  /// Use the recommended time step for the remainder of the session.
+  bool apply{false};
+};
+
+/*!
+ * Measurements of a single time step.
+ */
+struct AutotuneStepResult {
+  double timeStep{0.0};
+  uint64_t cycles{0};
+  uint64_t overruns{0};
+  double meanRoundtripNs{0.0};
+  long maxRoundtripNs{0};
+  uint64_t workingCounterErrors{0};
+  /// -1 if no slave uses distributed clocks.
+  long maxDcSyncErrorNs{-1};
+  bool passed{false};
+};
+
+/*!
+ * Result of EthercatMaster::autotuneTimeStep.
+ */
+struct AutotuneResult {
+  /// false if not even the longest time step passed or the autotuning was refused.
+  bool success{false};
+  /// Reason why the autotuning was refused (invalid options, concurrent update thread), empty otherwise.
+  std::string error;
+  std::vector<AutotuneStepResult> steps;
+  double shortestSafeTimeStep{0.0};
+  double recommendedTimeStep{0.0};
+  bool applied{false};
+
+  /*!
+   * Human readable summary, e.g. for logging.
+   */
+  std::string toString() const;
+};
+
+}  // namespace ecat_master
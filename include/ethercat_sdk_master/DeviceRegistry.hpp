@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ethercat_sdk_master/EthercatDevice.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Devices attached to an EthercatMaster, indexed by name (hashed), by bus segment and address (dense) and by type.
+ * Every device keeps the index of its attachment for the lifetime of the registry, cyclic consumers can hold these
+ * indices instead of looking devices up by name. Iteration is in attachment order.
+ */
+class DeviceRegistry {
+ public:
+  static constexpr size_t npos{std::numeric_limits<size_t>::max()};
+  using Container = std::vector<EthercatDevice::SharedPtr>;
+
+  /*!
+   * Add a device.
+   * @param[in] device the device, its address must be set.
+   * @param[in] segment bus segment of the device.
+   * @return index of the device, npos if a device of the same name exists.
+   */
+  size_t add(const EthercatDevice::SharedPtr& device, unsigned int segment = 0);
+
+  /*!
+   * Remove all devices, invalidates all indices.
+   */
+  void clear();
+
+  bool contains(const std::string& name) const { return nameIndex_.find(name) != nameIndex_.end(); }
+
+  /*!
+   * Returns the index of the device, npos if there is none of this name.
+   */
+  size_t find(const std::string& name) const;
+
+  /*!
+   * Returns the indices of the devices at an address of a segment, several devices may share a slave.
+   */
+  const std::vector<size_t>& findAt(unsigned int segment, uint32_t address) const;
+
+  /*!
+   * Returns the device of this name casted to the concrete type, nullptr if there is none or the type differs.
+   */
+  template <typename Device>
+  std::shared_ptr<Device> get(const std::string& name) const {
+    const size_t index = find(name);
+    return index == npos ? nullptr : std::dynamic_pointer_cast<Device>(devices_[index]);
+  }
+
+  /*!
+   * Returns all devices of the type or derived from it, in attachment order.
+   * One cast per attached dynamic type decides which types match, only the devices of these types are casted.
+   */
+  template <typename Device>
+  std::vector<std::shared_ptr<Device>> getAll() const {
+    std::vector<size_t> indices;
+    for (const auto& type : typeIndex_) {
+      if (std::dynamic_pointer_cast<Device>(devices_[type.second.front()])) {
+        indices.insert(indices.end(), type.second.begin(), type.second.end());
+      }
+    }
+    std::sort(indices.begin(), indices.end());
+    std::vector<std::shared_ptr<Device>> devices;
+    devices.reserve(indices.size());
+    for (const size_t index : indices) {
+      devices.push_back(std::dynamic_pointer_cast<Device>(devices_[index]));
+    }
+    return devices;
+  }
+
+  const EthercatDevice::SharedPtr& operator[](size_t index) const { return devices_[index]; }
+  unsigned int getSegment(size_t index) const { return segments_[index]; }
+  size_t size() const { return devices_.size(); }
+  bool empty() const { return devices_.empty(); }
+  Container::const_iterator begin() const { return devices_.begin(); }
+  Container::const_iterator end() const { return devices_.end(); }
+
+ private:
+  Container devices_;
+  std::vector<unsigned int> segments_;
+  std::unordered_map<std::string, size_t> nameIndex_;
+  // [segment][address] -> indices
+  std::vector<std::vector<std::vector<size_t>>> addressIndex_;
+  // dynamic type -> indices, in attachment order.
+  std::unordered_map<std::type_index, std::vector<size_t>> typeIndex_;
+};
+
+}  // namespace ecat_master
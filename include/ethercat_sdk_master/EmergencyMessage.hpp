@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace ecat_master {
+
+/*!
+ * CoE emergency (EMCY) message of a slave.
+ */
+struct EmergencyMessage {
+  /// Segment of the slave, 1 for the second segment of a split bus.
+  unsigned int segment{0};
+  /// Bus position of the slave.
+  uint16_t slave{0};
+  /// Reception time.
+  std::chrono::system_clock::time_point stamp{};
+  /// CiA 301 error code, e.g. 0x2310 continuous over current.
+  uint16_t errorCode{0};
+  /// Error register (object 0x1001).
+  uint8_t errorRegister{0};
+  /// Manufacturer specific error field.
+  std::array<uint8_t, 5> data{};
+
+  /*!
+   * Human readable message, e.g. for logging.
+   */
+  std::string toString() const;
+};
+
+using EmergencySubscriber = std::function<void(const EmergencyMessage&)>;
+
+}  // namespace ecat_master
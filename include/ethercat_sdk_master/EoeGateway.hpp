@@ -0,0 +1,138 @@
+#pragma once
+
+#include "ethercat_sdk_master/EthercatBus.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Traffic of the Ethernet over EtherCAT tunnels.
+ */
+struct EoeStatistics {
+  /// Ethernet frames and bytes sent to the slaves, and the mailbox fragments they were split into.
+  uint64_t txFrames{0};
+  uint64_t txBytes{0};
+  uint64_t txFragments{0};
+  /// Ethernet frames and bytes received from the slaves, and the mailbox fragments they were reassembled from.
+  uint64_t rxFrames{0};
+  uint64_t rxBytes{0};
+  uint64_t rxFragments{0};
+  /// Frames dropped because the transmit queue of the slave was full.
+  uint64_t droppedTxFrames{0};
+  /// Frames dropped because of a reassembly error or because the TAP interface did not take them.
+  uint64_t droppedRxFrames{0};
+  /// Frames waiting for transmission, now and at most.
+  size_t queuedFrames{0};
+  size_t maxQueuedFrames{0};
+  /// Cycles which ended with frames still queued, the tunnel sends one fragment per cycle.
+  uint64_t throttledCycles{0};
+
+  /*!
+   * Human readable statistics, e.g. for logging.
+   */
+  std::string toString() const;
+};
+
+/*!
+ * Tunnels Ethernet frames between TAP interfaces of the host and the EoE slaves of a bus, e.g. to reach the web
+ * interface of a drive. Every slave gets its own TAP interface. Frames read from the interface are queued, split
+ * into mailbox fragments of at most a byte budget and sent one fragment per mailbox service round, so the tunnel
+ * cannot load the bus. Fragments received by the mailbox service are reassembled and written to the interface.
+ * transmit() and receive() are called by the mailbox service thread of the EthercatMaster, never by the update thread.
+ */
+class EoeGateway {
+ public:
+  /// Largest Ethernet frame without FCS, with a VLAN tag.
+  static constexpr size_t maxFrameSize{1518};
+  /// Frames queued per slave.
+  static constexpr size_t queueCapacity{16};
+  /// Fragments other than the last one of a frame are a multiple of this size.
+  static constexpr size_t fragmentAlignment{32};
+
+  EoeGateway() = default;
+  ~EoeGateway();
+
+  EoeGateway(const EoeGateway&) = delete;
+  EoeGateway& operator=(const EoeGateway&) = delete;
+
+  /*!
+   * Create a TAP interface <interfacePrefix><slave> for every EoE slave of the bus. Requires CAP_NET_ADMIN. The
+   * interfaces are left down and need to be configured by the system (address, link up), the IP settings of the
+   * slaves are not changed. Call after the bus startup.
+   * @return number of tunnels.
+   */
+  unsigned int open(EthercatBus& bus, const std::string& interfacePrefix);
+
+  /*!
+   * Remove all TAP interfaces.
+   */
+  void close();
+
+  /*!
+   * Returns true if at least one tunnel is open.
+   */
+  bool isOpen() const { return !tunnels_.empty(); }
+
+  /*!
+   * Queue the frames from the TAP interfaces and send a single fragment of at most budgetBytes. The slaves with queued
+   * frames are served round robin.
+   */
+  void transmit(size_t budgetBytes);
+
+  /*!
+   * Reassemble a mailbox received from a slave, the frame is written to the TAP interface once it is complete.
+   * @return true if the mailbox was EoE traffic of a tunneled slave.
+   */
+  bool receive(uint16_t slave, const ec_mbxbuft& mailbox);
+
+  EoeStatistics getStatistics() const;
+
+ private:
+  struct Frame {
+    std::array<uint8_t, maxFrameSize> data;
+    size_t size{0};
+  };
+
+  struct Tunnel {
+    uint16_t slave{0};
+    int fd{-1};
+    size_t fragmentSize{0};
+    // ring of queued frames, the head is being sent.
+    std::vector<Frame> queue;
+    size_t queueHead{0};
+    size_t queueSize{0};
+    size_t txOffset{0};
+    uint8_t txFragment{0};
+    uint8_t txFrameNumber{0};
+    // reassembly state of ecx_EOEreadfragment.
+    Frame rxFrame;
+    uint8 rxFragment{0};
+    uint16 rxFrameSize{0};
+    uint16 rxFrameOffset{0};
+    uint16 rxFrameNumber{0};
+  };
+
+  EthercatBus* bus_{nullptr};
+  std::vector<Tunnel> tunnels_;
+  size_t nextTunnel_{0};
+
+  // statistics, written by transmit() and receive(), read by getStatistics() from any thread.
+  std::atomic<uint64_t> txFrames_{0};
+  std::atomic<uint64_t> txBytes_{0};
+  std::atomic<uint64_t> txFragments_{0};
+  std::atomic<uint64_t> rxFrames_{0};
+  std::atomic<uint64_t> rxBytes_{0};
+  std::atomic<uint64_t> rxFragments_{0};
+  std::atomic<uint64_t> droppedTxFrames_{0};
+  std::atomic<uint64_t> droppedRxFrames_{0};
+  std::atomic<size_t> queuedFrames_{0};
+  std::atomic<size_t> maxQueuedFrames_{0};
+  std::atomic<uint64_t> throttledCycles_{0};
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,441 @@
+#pragma once
+
+#include "ethercat_sdk_master/BusCapacity.hpp"
+#include "ethercat_sdk_master/BusTopology.hpp"
+#include "ethercat_sdk_master/InputChangeDetector.hpp"
+#include "ethercat_sdk_master/ProcessImageLayout.hpp"
+#include "ethercat_sdk_master/RedundancyState.hpp"
+#include "ethercat_sdk_master/SlaveStateTracker.hpp"
+
+#include <soem_interface_rsl/EthercatBusBase.hpp>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+class EthercatDevice;
+
+/*!
+ * EtherCAT bus used by the EthercatMaster.
+ * Extends soem_interface_rsl::EthercatBusBase with the low level queries the master needs
+ * on top of the cyclic PDO exchange. All calls lock the SOEM context mutex of the base class.
+ */
+class EthercatBus : public soem_interface_rsl::EthercatBusBase {
+ public:
+  explicit EthercatBus(const std::string& name) : soem_interface_rsl::EthercatBusBase(name) {}
+
+  /*!
+   * Use cable redundancy: the end of the line is connected to a second network interface, frames are sent on
+   * both interfaces and merged by SOEM, a single line break is bridged within the same cycle.
+   * Needs to be set before startup().
+   * @param[in] networkInterface secondary network interface, empty to disable redundancy.
+   */
+  void setRedundantInterface(const std::string& networkInterface) { redundantInterface_ = networkInterface; }
+
+  /*!
+   * Startup of the bus, see soem_interface_rsl::EthercatBusBase::startup.
+   * With a redundant interface the secondary interface is set down during the slave discovery and configuration,
+   * which lets the last slave close its port, and is set up again afterwards to close the ring.
+   * Setting the interface state requires CAP_NET_ADMIN (SIOCSIFFLAGS) in addition to the CAP_NET_RAW of the sockets.
+   * Without it, or if the redundant port cannot be opened, startup fails and a bus which was already started is shut
+   * down again, the slaves are back in INIT.
+   */
+  bool startup(std::atomic<bool>& abortFlag, const bool sizeCheck = true, unsigned int maxDiscoverRetries = 10);
+
+  /*!
+   * Send the process data, see soem_interface_rsl::EthercatBusBase::updateWrite. The send time is taken after the
+   * updateWrite() of the slaves, right before the frames are sent.
+   */
+  void updateWrite();
+
+  /*!
+   * Receive the process data, see soem_interface_rsl::EthercatBusBase::updateRead. The receive time is taken right after
+   * the frames were received, then the input changes are detected (see enableInputChangeDetection()) before the
+   * updateRead() of the slaves.
+   */
+  void updateRead();
+
+  /*!
+   * Send and receive time of the process data in the last cycle, CLOCK_MONOTONIC [ns]. Their difference is the
+   * roundtrip of the frames without the slave callbacks. Call from the update thread.
+   */
+  int64_t getSendTimeNs() const { return sendTimeNs_; }
+  int64_t getReceiveTimeNs() const { return receiveTimeNs_; }
+
+  /*!
+   * Read the state of the cable redundancy. Sends one datagram per slave if redundancy is enabled.
+   * The context mutex is not locked, so the datagrams are interleaved with the cyclic frames of the update thread
+   * (SOEM datagrams are thread safe). Do not call it from the update thread.
+   */
+  RedundancyState readRedundancyState();
+
+  /*!
+   * Bring a single slave back into OPERATIONAL, e.g. after it lost power, while the other slaves keep cycling.
+   * A slave which does not answer on its configured address anymore is recovered first (ecx_recover_slave).
+   * The slave is then set to INIT, its sync managers are programmed as configured at startup, preOpConfiguration is
+   * executed in PRE_OP (e.g. the PDO mapping of the device), and the FMMUs and SYNC0 of DC slaves are programmed before
+   * SAFE_OP and OPERATIONAL. updateRead() / updateWrite() skip the devices of the slave meanwhile.
+   * The context mutex is locked for the address recovery and the slave list accesses, not while waiting for state
+   * changes. Do not call it from the update thread.
+   * @param[in] slave bus position of the slave.
+   * @param[in] preOpConfiguration configuration executed in PRE_OP, the recovery fails if it returns false.
+   * @return true if the slave reached OPERATIONAL.
+   */
+  bool recoverSlave(uint16_t slave, const std::function<bool()>& preOpConfiguration);
+
+  /*!
+   * Change the process data sizes of a single slave for a different PDO mapping while the other slaves keep cycling.
+   * The slave is set to PRE_OP, preOpConfiguration writes the new PDO assignment, the lengths of the process data sync
+   * managers and FMMUs are adapted and the slave is set to SAFE_OP. The logical process image is not changed: the new
+   * sizes must fit into the window mapped for the slave at startup, and a single sync manager per direction is supported.
+   * The context mutex is not locked while waiting for state changes and during preOpConfiguration. If the change fails
+   * after the slave left SAFE_OP, the startup lengths are restored and the slave is set back to SAFE_OP.
+   * Do not call it from the update thread.
+   * @param[in] slave bus position of the slave.
+   * @param[in] outputBytes size of the outputs with the new mapping.
+   * @param[in] inputBytes size of the inputs with the new mapping.
+   * @param[in] preOpConfiguration configuration executed in PRE_OP, the change fails if it returns false.
+   * @return true if the slave reached SAFE_OP with the new sizes.
+   */
+  bool changeProcessDataSize(uint16_t slave, uint32_t outputBytes, uint32_t inputBytes, const std::function<bool()>& preOpConfiguration);
+
+  /*!
+   * Size of the outputs and inputs mapped for a slave at startup [bytes].
+   * @return false if the slave does not exist.
+   */
+  bool getProcessDataSize(uint16_t slave, uint32_t& outputBytes, uint32_t& inputBytes) const;
+
+  using MailboxHandler = std::function<void(uint16_t slave, const ec_mbxbuft& mailbox)>;
+
+  /*!
+   * Map the SM0 (mailbox out) and SM1 (mailbox in) status registers of every mailbox slave into a logical area behind
+   * the process image, using a spare FMMU of the slave (0x0805 - 0x080D, 9 bytes per slave). A single LRD then tells
+   * which slaves have pending mailbox data instead of one FPRD per slave, and which ones did not take the last mailbox
+   * of the master yet (see sendEoeFragment()). Slaves without a spare FMMU are polled. Call after startup() in SAFE_OP.
+   * @return number of slaves whose mailbox status is mapped.
+   */
+  unsigned int mapMailboxStatus();
+
+  /*!
+   * Determine the slaves with a full input mailbox: one LRD for the mapped slaves, one FPRD per remaining mailbox slave.
+   * Before mapMailboxStatus() every mailbox slave is polled.
+   * @param[out] pendingSlaves bus positions of the slaves with pending mailbox data.
+   * @return false if a slave did not respond.
+   */
+  bool readMailboxStatus(std::vector<uint16_t>& pendingSlaves);
+
+  /*!
+   * Receive the unsolicited mailbox data of all slaves, routed by the mailbox type: CoE emergencies are pushed to the
+   * SOEM error list, EoE fragments are passed to the handler. The header of a pending mailbox is read first, any other
+   * mailbox (e.g. the response of an SDO or FoE transfer) is left to the transfer which clears it. Slaves with an active
+   * FoE transfer are skipped. Like readSlaveStates() the datagrams are sent without the context mutex, it is only locked
+   * to read the slave list and to push the emergencies: the mutex is not priority inheriting, a thread holding it for a
+   * round trip would hold back the update thread. SDO transfers are not registered as mailbox transfers (the devices
+   * send them through soem_interface_rsl): one starting between the two reads may answer the second read with its
+   * response, which is discarded and counted, see getDiscardedMailboxes().
+   * Sends datagrams of its own, do not call it from the update thread.
+   * @param[in] handler called for every received EoE mailbox, may be empty.
+   * @return false if a slave did not respond.
+   */
+  bool serviceMailboxes(const MailboxHandler& handler);
+
+  /*!
+   * Number of mailboxes read by serviceMailboxes() which turned out to be the response of a mailbox transfer.
+   */
+  uint64_t getDiscardedMailboxes() const { return discardedMailboxes_; }
+
+  /*!
+   * Pop the CoE emergencies at the front of the SOEM error list and pass them to the handler, oldest first.
+   * SOEM collects the emergencies received by any mailbox transfer (serviceMailboxes(), SDO and FoE transfers) there.
+   * The oldest entry is inspected before it is popped: the other entries (e.g. SDO aborts, packet errors) are left to
+   * their owners, which read them with ecx_poperror() / ecx_elist2string(). The emergencies behind such an entry are
+   * passed once it was read.
+   * Never blocks on the context mutex: returns false if it is held.
+   */
+  bool popEmergencies(const std::function<void(const ec_errort& error)>& handler);
+
+  /*!
+   * Bus positions of the slaves supporting Ethernet over EtherCAT. Valid after startup().
+   */
+  std::vector<uint16_t> getEoeSlaves() const;
+
+  /*!
+   * Largest EoE fragment of a slave fitting its mailbox, a multiple of 32 bytes as required for all but the last
+   * fragment of a frame. 0 if the mailbox is too small.
+   */
+  size_t getEoeFragmentSize(uint16_t slave) const;
+
+  /*!
+   * Send a single EoE fragment of an Ethernet frame without waiting: fails if the slave did not read the previous
+   * mailbox yet. The mailbox is written with a single datagram: a slave whose mapped SM0 status was full at the last
+   * readMailboxStatus() is skipped, otherwise the ESC rejects the write to a full mailbox. The context mutex is only
+   * locked to take the mailbox counter, not for the datagram. Call it from the thread of serviceMailboxes(), it sends
+   * datagrams of its own. Fragments other than the last must be a multiple of 32 bytes.
+   * @param[in] frame complete Ethernet frame.
+   * @param[in] offset start of the fragment in the frame.
+   * @param[in] size size of the fragment.
+   * @param[in] fragmentNumber number of the fragment in the frame, starting at 0.
+   * @param[in] frameNumber 4 bit frame counter.
+   * @return true if the fragment was written to the mailbox of the slave.
+   */
+  bool sendEoeFragment(uint16_t slave, const uint8_t* frame, size_t frameSize, size_t offset, size_t size, uint8_t fragmentNumber,
+                       uint8_t frameNumber);
+
+  using FirmwareProgressCallback = std::function<void(size_t remainingBytes)>;
+
+  /*!
+   * Set a slave to BOOT for a firmware update, as the firm_update example of SOEM: the slave is set to INIT, the boot
+   * mailbox of its SII (words 0x0014 - 0x0017) is programmed into SM0 / SM1 and replaces the standard mailbox in the
+   * slave list, then BOOT is requested. The context mutex is not locked while waiting for state changes.
+   * Do not call it from the update thread.
+   * @param[in] slave bus position of the slave.
+   * @return true if the slave reached BOOT, false if it has no boot mailbox or refused the state.
+   */
+  bool enterBootState(uint16_t slave);
+
+  /*!
+   * Set a slave from BOOT to INIT and restore its standard mailbox in the slave list and the sync managers.
+   * recoverSlave() restores it as well. Do not call it from the update thread.
+   * @param[in] slave bus position of the slave.
+   * @return true if the slave reached INIT.
+   */
+  bool leaveBootState(uint16_t slave);
+
+  /*!
+   * Write a file to a slave with FoE, the slave is expected in BOOT (see enterBootState()). Transfers to different
+   * slaves may run concurrently from different threads, the context mutex is not locked: the mailbox service skips the
+   * slave during the transfer, which leaves the mailbox of the slave to the transfer. The transfers share the context
+   * through per slave fields of the slave list and the FoE hook, which startup() sets once and which reports the
+   * progress to the callback registered by the calling thread. The errors of a transfer (e.g. emergencies received
+   * meanwhile) are collected in an error list of its own and moved to the shared SOEM error list under the context mutex.
+   * @param[in] slave bus position of the slave.
+   * @param[in] fileName FoE file name expected by the slave.
+   * @param[in] password FoE password, 0 if none.
+   * @param[in] image file content.
+   * @param[in] progress called after every acknowledged packet, may be empty.
+   * @param[in] timeoutUs timeout of a single packet [us].
+   * @return true if the slave acknowledged the complete file.
+   */
+  bool writeFirmware(uint16_t slave, const std::string& fileName, uint32_t password, const std::vector<char>& image,
+                     const FirmwareProgressCallback& progress, int timeoutUs);
+
+  /*!
+   * Read a file from a slave with FoE, e.g. to verify a firmware image.
+   * @param[in,out] image sized to the expected file size, resized to the received size.
+   * @return true if the file was received.
+   */
+  bool readFirmware(uint16_t slave, const std::string& fileName, uint32_t password, std::vector<char>& image, int timeoutUs);
+
+  /*!
+   * Physical port connections as discovered by SOEM during startup.
+   * Only valid after a successful startup().
+   */
+  BusTopology getTopology() const;
+
+  /*!
+   * Read the AL status and AL status code of all slaves.
+   * A single broadcast datagram is sent, the slaves are only read individually if they are not all in the same state
+   * or one of them signals an error. Unlike ecx_readstate the context mutex is not locked and the slave list is not
+   * written, the datagrams are interleaved with the cyclic frames of the update thread. Do not call it from the update thread.
+   * @param[out] states AL status of every slave, states[i] belongs to the slave at bus position i + 1, 0 if it did not respond.
+   * @return lowest state on the bus.
+   */
+  uint16_t readSlaveStates(std::vector<SlaveAlStatus>& states);
+
+  /*!
+   * Read the RX error and lost link counters of every port of every slave, two datagrams per slave. Like
+   * readSlaveStates() the context mutex is not locked. Do not call it from the update thread.
+   * @param[out] counters counters[i] belongs to the slave at bus position i + 1, zero if it did not respond.
+   */
+  void readPortErrorCounters(std::vector<PortErrorCounters>& counters);
+
+  /*!
+   * DC system time of the reference clock as received with the last process data frame [ns], 0 without DC slaves.
+   * Does not lock the context mutex.
+   */
+  int64_t getDcTime() const { return ecatContext_.DCtime ? *ecatContext_.DCtime : 0; }
+
+  /*!
+   * Layout of the process image mapped by SOEM. Only valid after a successful startup().
+   */
+  ProcessImageInfo getProcessImageInfo() const;
+
+  /*!
+   * Read the DC system time difference (0x092C) of every slave using distributed clocks.
+   * Sends one datagram per DC slave, do not use in the update loop.
+   * @return largest absolute difference to the reference clock in ns, -1 if no slave uses DC.
+   */
+  long readMaxDcSyncErrorNs();
+
+  /*!
+   * Change the SYNC0 cycle time of every slave with active distributed clocks while the bus is running.
+   * SYNC0 is stopped, restarted startDelayNs after the current local DC time on a multiple of the new cycle time plus the
+   * slave's configured shift (as ecx_dcsync0, which waits 100ms), and the activation bits are restored. SYNC1 is not changed.
+   * Sends five datagrams per DC slave, the context mutex is locked for the slave list accesses only. Do not call it
+   * from the update thread.
+   * @return false if a slave did not respond.
+   */
+  bool setSync0CycleTime(uint32_t cycleTimeNs, int64_t startDelayNs);
+
+  /*!
+   * Location of every slave's process data in the logical process image. Only valid after a successful startup().
+   */
+  ProcessImageLayout getProcessImageLayout() const;
+
+  /*!
+   * Relocate the process data of the slaves in the logical process image by rewriting their FMMUs: the slaves in
+   * hotSlaves are grouped at the start of the outputs and inputs, every slave is aligned to its natural boundary and the
+   * inputs to a cache line (see planProcessImageLayout()). The alignment is dropped if it would need more frames than the
+   * layout of SOEM, the layout is kept if neither fits. Bit oriented slaves sharing bytes are moved together.
+   * Call after startup() and before mapMailboxStatus(), while no process data is exchanged.
+   * @param[in] hotSlaves bus positions of the slaves whose process data is accessed first.
+   * @return true if the process image was relocated.
+   */
+  bool optimizeProcessImageLayout(const std::vector<uint16_t>& hotSlaves);
+
+  /*!
+   * Returns the inputs of a slave in the process image, size 1 for slaves with less than 8 input bits (the byte is
+   * shared with other slaves). {nullptr, 0} for slaves without inputs. Valid after startup().
+   */
+  InputChangeDetector::Region getInputRegion(uint16_t slave) const;
+
+  /*!
+   * Returns the complete input process image of the bus. Valid after startup().
+   */
+  InputChangeDetector::Region getInputImage() const;
+
+  /*!
+   * Compare the inputs of every attached EthercatDevice with the previous cycle in updateRead(), after the frames were
+   * received and before the updateRead() of the slaves, see EthercatDevice::inputsChanged(). Call after startup() and
+   * before the update loop starts.
+   */
+  void enableInputChangeDetection();
+
+ private:
+  /*!
+   * Switch the port to redundant mode once the ring is closed.
+   */
+  bool enableRedundancy();
+
+  /*!
+   * Read the DL status register of every slave, 0 for slaves which did not answer. Does not lock the context mutex.
+   */
+  std::vector<uint16_t> readDlStatus();
+
+  /*!
+   * Mark a mailbox transfer of another thread (FoE) to a slave, the mailbox service leaves the slave alone meanwhile.
+   */
+  void beginMailboxTransfer(uint16_t slave);
+  void endMailboxTransfer(uint16_t slave);
+  bool hasMailboxTransfer(uint16_t slave) const;
+
+  /*!
+   * Register the FoE transfer of the calling thread to a slave, the mailbox transfer included.
+   * @return false if a transfer to the slave is in progress.
+   */
+  bool beginFoeTransfer(uint16_t slave, const FirmwareProgressCallback& progress);
+  void endFoeTransfer(uint16_t slave);
+
+  /*!
+   * Run an FoE transfer on a copy of the context with its own SOEM error list, the errors of the transfer are moved to
+   * the shared list under the context mutex afterwards.
+   * @return working counter of the transfer.
+   */
+  int runFoeTransfer(const std::function<int(ecx_contextt* context)>& transfer);
+
+  /*!
+   * recoverSlave() without marking the slave as recovering.
+   */
+  bool reconfigureSlave(uint16_t slave, const std::function<bool()>& preOpConfiguration);
+
+  /*!
+   * Mark the devices of a slave as being recovered, they are skipped by updateRead() / updateWrite(). Setting the mark
+   * waits for device updates in progress.
+   */
+  void setSlaveRecovering(uint16_t slave, bool recovering);
+  bool isSlaveRecovering(uint32_t slave) const { return slave < EC_MAXSLAVE && recovering_[slave].load(); }
+
+  /*!
+   * Request an AL state of a slave and wait for it like ecx_statecheck, but poll the AL status without the context mutex
+   * and write the slave list only with it held.
+   * @param[in] state requested state, with EC_STATE_ACK to acknowledge an error.
+   * @return true if the slave reached the state.
+   */
+  bool requestSlaveState(uint16_t slave, uint16_t state);
+
+  /*!
+   * Restore the standard mailbox of a slave after BOOT, if it was replaced by enterBootState(). Requires the context mutex.
+   */
+  void restoreStandardMailbox(uint16_t slave);
+
+  // the mailbox sync managers of a slave, see getMailboxArea().
+  struct MailboxArea {
+    uint16_t configuredAddress{0};
+    uint16_t writeOffset{0};
+    uint16_t writeLength{0};
+    uint16_t readOffset{0};
+    uint16_t readLength{0};
+  };
+
+  /*!
+   * Copy of the mailbox configuration of a slave from the slave list, read with the context mutex held. The mailbox
+   * datagrams are sent with the copy, without the mutex.
+   */
+  MailboxArea getMailboxArea(uint16_t slave) const;
+
+  /*!
+   * Push a CoE emergency read by serviceMailboxes() to the SOEM error list like ecx_mbxreceive() does.
+   */
+  void pushEmergency(uint16_t slave, const ec_mbxbuft& mailbox);
+
+  // see enableInputChangeDetection(), the devices in the order of the regions.
+  InputChangeDetector inputChangeDetector_;
+  std::vector<EthercatDevice*> inputChangeDevices_;
+
+  // see setSlaveRecovering(), indexed by bus position.
+  std::array<std::atomic<bool>, EC_MAXSLAVE> recovering_{};
+  std::atomic<bool> updatingDevices_{false};
+
+  // CLOCK_MONOTONIC around the process data exchange, see updateWrite() / updateRead().
+  int64_t sendTimeNs_{0};
+  int64_t receiveTimeNs_{0};
+
+  std::string redundantInterface_;
+  ecx_redportt redundantPort_{};
+  BusTopology redundantTopology_;
+  /// Port of the last slave connected to the secondary interface.
+  PortEndpoint secondaryEndpoint_{};
+
+  // mailbox status mapping, see mapMailboxStatus().
+  uint32_t mailboxStatusLogicalAddress_{0};
+  std::vector<uint16_t> mailboxStatusSlaves_;
+  std::vector<uint16_t> polledMailboxSlaves_;
+  std::vector<uint8_t> mailboxStatus_;
+  std::vector<uint16_t> pendingMailboxes_;
+  // mapped SM0 status by bus position, written by readMailboxStatus() in the mailbox service thread.
+  std::vector<uint8_t> outMailboxFull_;
+  // active mailbox transfers per slave, see beginMailboxTransfer().
+  mutable std::mutex mailboxTransferMutex_;
+  std::map<uint16_t, unsigned int> mailboxTransfers_;
+  // see getDiscardedMailboxes().
+  std::atomic<uint64_t> discardedMailboxes_{0};
+
+  // standard mailbox of the slaves in BOOT, see enterBootState(). Protected by the context mutex.
+  struct StandardMailbox {
+    ec_smt rxSyncManager;
+    ec_smt txSyncManager;
+    uint16 rxOffset;
+    uint16 rxSize;
+    uint16 txOffset;
+    uint16 txSize;
+  };
+  std::map<uint16_t, StandardMailbox> standardMailboxes_;
+};
+
+}  // namespace ecat_master
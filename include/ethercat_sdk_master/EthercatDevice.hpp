@@ -22,14 +22,24 @@
 
 #pragma once
 
+#include "ethercat_sdk_master/CycleContext.hpp"
+#include "ethercat_sdk_master/PdoMappingProfile.hpp"
+
 #include <soem_interface_rsl/EthercatBusBase.hpp>
 #include <soem_interface_rsl/EthercatSlaveBase.hpp>
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 namespace ecat_master {
 
 /*!
@@ -81,6 +91,56 @@ class EthercatDevice : public soem_interface_rsl::EthercatSlaveBase {
    */
   virtual void setName(const std::string& name) { name_ = name; }
 
+  /*!
+   * Returns true if the inputs of the device changed in the last update cycle, requires
+   * EthercatMasterConfiguration::detectInputChanges (always true otherwise).
+   * The flag is set by the bus right before updateRead() of the device, read it in updateRead() or from the update
+   * thread after EthercatMaster::update(), e.g. to skip the processing of unchanged inputs. false in cycles with an
+   * incomplete working counter.
+   */
+  bool inputsChanged() const { return inputsChanged_; }
+
+  /*!
+   * Set by the EthercatBus in every updateRead().
+   */
+  void setInputsChanged(bool changed) { inputsChanged_ = changed; }
+
+  /*!
+   * Context of the current update cycle (cycle counter, cycle start, measured period, DC time, overrun), updated by
+   * the EthercatMaster once per cycle before updateWrite(). Use it in updateWrite() / updateRead() instead of reading
+   * the clock. nullptr if the device is not attached to an EthercatMaster.
+   */
+  const CycleContext* getCycleContext() const { return cycleContext_; }
+
+  /*!
+   * Set by the EthercatMaster when the device is attached, the context must outlive the device's use of it.
+   */
+  void setCycleContext(const CycleContext* cycleContext) { cycleContext_ = cycleContext; }
+
+  /*!
+   * Declare an alternative PDO mapping before the startup of the master, see EthercatMaster::switchPdoMappingProfile.
+   * The process image of the slave is reserved with the mapping configured by startup(), so configure the largest
+   * mapping there. Profile 0 is expected to be the one configured by startup().
+   */
+  void addPdoMappingProfile(const PdoMappingProfile& profile) { pdoMappingProfiles_.push_back(profile); }
+
+  const std::vector<PdoMappingProfile>& getPdoMappingProfiles() const { return pdoMappingProfiles_; }
+
+  /*!
+   * Index of the active PDO mapping profile, use it in updateRead() / updateWrite() to interpret the process data.
+   * Changed by the EthercatMaster between two update cycles, reset to 0 when the slave is recovered.
+   */
+  size_t getActivePdoMappingProfile() const { return activePdoMappingProfile_.load(std::memory_order_relaxed); }
+
+  void setActivePdoMappingProfile(size_t profile) { activePdoMappingProfile_.store(profile, std::memory_order_relaxed); }
+
+  /*!
+   * Write the PDO assignment of a profile (0x1C12, 0x1C13) through the object dictionary cache, called by the
+   * EthercatMaster in PRE_OP. Override it to configure the PDO mapping objects (0x16xx, 0x1Axx) as well.
+   * @return true if the slave accepted the assignment.
+   */
+  virtual bool configurePdoMappingProfile(const PdoMappingProfile& profile);
+
  public:
   /*!
    * Send a write SDO of type Value to the device and confirm by reading
@@ -103,9 +163,120 @@ class EthercatDevice : public soem_interface_rsl::EthercatSlaveBase {
     return (success & (value == testVal));
   }
 
+  /*!
+   * Read an object through the object dictionary cache.
+   * Use it for read-only and static objects (identity, firmware version, limits, PDO assignment): the object is
+   * read once by SDO, later reads are served from memory. With the disk cache enabled, the cache is loaded from
+   * ~/.ethercat_master/sdo_cache, keyed by the identity object (0x1018) of the slave, and new objects are written back
+   * with flushSdoCache(). Slaves without a serial number get no disk cache, identical slaves could not be told apart.
+   * @param[in] index index of the SDO (16 bit).
+   * @param[in] subindex sub index of the SDO (8 bit).
+   * @param[in] completeAccess true if all subindices are read.
+   * @param[out] value value of the object.
+   * @return true if the value was cached or read successfully.
+   */
+  template <typename Value>
+  bool cachedSdoRead(const uint16_t index, const uint8_t subindex, const bool completeAccess, Value& value) {
+    static_assert(std::is_trivially_copyable<Value>::value, "Only trivially copyable values can be cached.");
+    std::lock_guard<std::recursive_mutex> lock(sdoCacheMutex_);
+    if (sdoDiskCacheEnabled_ && !sdoDiskCacheLoaded_) {
+      loadSdoCache();
+    }
+    const SdoCacheKey key{index, subindex, completeAccess};
+    const auto entry = sdoCache_.find(key);
+    if (entry != sdoCache_.end() && entry->second.data.size() == sizeof(Value)) {
+      std::memcpy(&value, entry->second.data.data(), sizeof(Value));
+      return true;
+    }
+    if (!sendSdoRead(index, subindex, completeAccess, value)) {
+      return false;
+    }
+    SdoCacheEntry& newEntry = sdoCache_[key];
+    newEntry.data.resize(sizeof(Value));
+    std::memcpy(newEntry.data.data(), &value, sizeof(Value));
+    newEntry.persistent = true;
+    sdoDiskCacheDirty_ |= sdoDiskCacheEnabled_;
+    return true;
+  }
+
+  /*!
+   * Write an object and update the object dictionary cache on success (write-through).
+   * Written objects are kept in memory only, the device may not store them permanently.
+   * @return true if the SDO write was successful.
+   */
+  template <typename Value>
+  bool cachedSdoWrite(const uint16_t index, const uint8_t subindex, const bool completeAccess, const Value value) {
+    static_assert(std::is_trivially_copyable<Value>::value, "Only trivially copyable values can be cached.");
+    std::lock_guard<std::recursive_mutex> lock(sdoCacheMutex_);
+    const SdoCacheKey key{index, subindex, completeAccess};
+    if (!sendSdoWrite(index, subindex, completeAccess, value)) {
+      // the state of the object is unknown.
+      invalidateSdoCache(index, subindex);
+      return false;
+    }
+    SdoCacheEntry& entry = sdoCache_[key];
+    const bool wasPersistent = entry.persistent;
+    entry.data.resize(sizeof(Value));
+    std::memcpy(entry.data.data(), &value, sizeof(Value));
+    entry.persistent = false;
+    sdoDiskCacheDirty_ |= wasPersistent && sdoDiskCacheEnabled_;
+    return true;
+  }
+
+  /*!
+   * Remove an object (all access types) from the object dictionary cache, the next cachedSdoRead reads it by SDO.
+   */
+  void invalidateSdoCache(const uint16_t index, const uint8_t subindex);
+
+  /*!
+   * Clear the object dictionary cache including its disk copy, e.g. after a firmware update.
+   */
+  void invalidateSdoCache();
+
+  /*!
+   * Enable the disk copy of the object dictionary cache. The cache is loaded with the next cachedSdoRead.
+   */
+  void setSdoDiskCacheEnabled(bool enabled);
+
+  /*!
+   * Write the changes of the object dictionary cache to its disk copy, once for a batch of cached reads. Called by the
+   * EthercatMaster after the startup and after a recovery of the device.
+   * @return false if the disk copy could not be written.
+   */
+  bool flushSdoCache();
+
+ protected:
+  // index, subindex, complete access
+  using SdoCacheKey = std::tuple<uint16_t, uint8_t, bool>;
+  struct SdoCacheEntry {
+    std::vector<uint8_t> data;
+    // read-only / static object, stored in the disk cache.
+    bool persistent{false};
+  };
+
+  /*!
+   * Path of the disk cache, identified by vendor id, product code, revision and serial number. Empty if the
+   * identity object cannot be read or the serial number is 0.
+   */
+  std::string getSdoCacheFile();
+  bool loadSdoCache();
+  bool saveSdoCache();
+
  protected:
   std::string name_;
   double timeStep_{0.0};
+  bool inputsChanged_{true};
+  const CycleContext* cycleContext_{nullptr};
+  std::vector<PdoMappingProfile> pdoMappingProfiles_;
+  std::atomic<size_t> activePdoMappingProfile_{0};
+
+  std::recursive_mutex sdoCacheMutex_;
+  std::map<SdoCacheKey, SdoCacheEntry> sdoCache_;
+  bool sdoDiskCacheEnabled_{false};
+  bool sdoDiskCacheLoaded_{false};
+  // persistent objects changed since the last flushSdoCache().
+  bool sdoDiskCacheDirty_{false};
+  std::string sdoCacheFile_;
 };
 
 }  // namespace ecat_master
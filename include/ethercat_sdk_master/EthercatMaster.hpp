@@ -22,16 +22,44 @@
 
 #pragma once
 
+#include "ethercat_sdk_master/AcyclicScheduler.hpp"
+#include "ethercat_sdk_master/BusCapacity.hpp"
+#include "ethercat_sdk_master/BusTopology.hpp"
+#include "ethercat_sdk_master/CycleContext.hpp"
+#include "ethercat_sdk_master/CycleStatistics.hpp"
+#include "ethercat_sdk_master/CycleTimeAutotuner.hpp"
+#include "ethercat_sdk_master/DeviceRegistry.hpp"
+#include "ethercat_sdk_master/EmergencyMessage.hpp"
+#include "ethercat_sdk_master/EoeGateway.hpp"
+#include "ethercat_sdk_master/EthercatBus.hpp"
 #include "ethercat_sdk_master/EthercatDevice.hpp"
 #include "ethercat_sdk_master/EthercatMasterConfiguration.hpp"
+#include "ethercat_sdk_master/ExternalTrigger.hpp"
+#include "ethercat_sdk_master/FirmwareUpdate.hpp"
+#include "ethercat_sdk_master/InputChangeDetector.hpp"
+#include "ethercat_sdk_master/InputSnapshot.hpp"
+#include "ethercat_sdk_master/NumaPlacement.hpp"
+#include "ethercat_sdk_master/PdoMappingProfile.hpp"
+#include "ethercat_sdk_master/PerfCounters.hpp"
+#include "ethercat_sdk_master/PeriodicityDetector.hpp"
+#include "ethercat_sdk_master/ProcessImageLayout.hpp"
+#include "ethercat_sdk_master/SlaveRecovery.hpp"
+#include "ethercat_sdk_master/SeqLock.hpp"
+#include "ethercat_sdk_master/SlaveStateTracker.hpp"
+#include "ethercat_sdk_master/SpscQueue.hpp"
+#include "ethercat_sdk_master/StallWatchdog.hpp"
 #include "ethercat_sdk_master/UpdateMode.hpp"
 
 #include <soem_interface_rsl/EthercatBusBase.hpp>
 
+#include <array>
 #include <chrono>
+#include <condition_variable>
 #include <ctime>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <thread>
 #include <vector>
 
 namespace ecat_master {
@@ -65,6 +93,29 @@ class EthercatMaster {
    */
   bool attachDevice(EthercatDevice::SharedPtr device);
 
+  /*!
+   * Attach an EtherCAT device to a bus segment.
+   * @param[in] device std::shared_ptr to object derive from ecat_master::EthercatDevice
+   * @param[in] segment 0: networkInterface, 1: segmentNetworkInterface. The address of the device is its position
+   * on the segment.
+   * @return true if a device of the given name does not yet exist and the segment is configured
+   */
+  bool attachDevice(EthercatDevice::SharedPtr device, unsigned int segment);
+
+  /*!
+   * Returns the attached devices, indexed by name, address and type. Indices are stable until the next
+   * loadEthercatMasterConfiguration(), cyclic consumers can keep them instead of looking devices up by name.
+   */
+  const DeviceRegistry& getDevices() const { return devices_; }
+
+  /*!
+   * Returns the device of this name casted to its concrete type, nullptr if there is none or the type differs.
+   */
+  template <typename Device = EthercatDevice>
+  std::shared_ptr<Device> getDevice(const std::string& name) const {
+    return devices_.get<Device>(name);
+  }
+
   /*!
    * Start the EtherCAT communication.
    * The startup() method of each attached EtherCAT device is called.
@@ -108,6 +159,8 @@ class EthercatMaster {
    *   3. use updateMode == UpdateMode::StandaloneEnforceStep if the call shall
    *      create the necessary timeout such that the update time step corresponds
    *      to the configured time step.
+   *   4. use updateMode = UpdateMode::ExternalTrigger if the call shall wait for the
+   *      trigger set with setTriggerFd() before the communication.
    * @param[in] updateMode select the update mode.
    */
   void update(UpdateMode updateMode);
@@ -136,11 +189,265 @@ class EthercatMaster {
    */
   long getUpdateTimeNs();
 
+  /*!
+   * Returns the timing statistics of the cyclic communication, as published by the update thread after the process data
+   * exchange and at the end of every update. Thread safe, never blocks the update thread.
+   */
+  CycleStatistics getCycleStatistics();
+
+  /*!
+   * Reset the timing statistics. Thread safe, applied by the update thread before the next process data exchange.
+   */
+  void resetCycleStatistics();
+
+  /*!
+   * Estimate the bus utilisation, the minimal achievable cycle time and the headroom for additional slaves,
+   * based on the mapped process image and the measured roundtrip. Thread safe, call after startup().
+   * On a split bus the estimate of the segment with the lower headroom is returned, the projection adds the slaves to it.
+   * @param[in] additionalSlaves number of slaves to add to the projection.
+   * @param[in] rxPdoSize RxPDO (output) size of every additional slave in bytes.
+   * @param[in] txPdoSize TxPDO (input) size of every additional slave in bytes.
+   */
+  BusCapacityEstimate estimateBusCapacity(unsigned int additionalSlaves = 0, uint32_t rxPdoSize = 0, uint32_t txPdoSize = 0);
+
+  /*!
+   * Set the trigger of UpdateMode::ExternalTrigger: an eventfd or a timerfd on CLOCK_MONOTONIC. The file descriptor is
+   * not closed by the master.
+   * update() waits for the trigger up to two time steps and runs the cycle untriggered after a timeout (missed trigger).
+   * The trigger latency and jitter are reported in the cycle statistics, measured from the expiration of a periodic
+   * timerfd, otherwise from the wakeup. Call before the update loop starts.
+   * @param[in] fd file descriptor, -1 to disable.
+   */
+  void setTriggerFd(int fd);
+
+  /*!
+   * Trigger UpdateMode::ExternalTrigger with the cycle notification of another started master, the trigger latency is
+   * measured from its send time. The notification has a single consumer, see getCycleNotificationFd().
+   * Call before the update loop starts.
+   */
+  void setTrigger(const EthercatMaster& master);
+
+  /*!
+   * Returns an eventfd which is signalled in every update after the process data was sent, e.g. to trigger another
+   * master. Created by startup(), -1 before or if it cannot be created. Reading the eventfd consumes the notifications:
+   * it must have a single consumer.
+   */
+  int getCycleNotificationFd() const;
+
+  /*!
+   * Change the update time step of the running master without restarting the bus.
+   * Applied by the update thread at the start of the next update(): the time step of the master and the devices
+   * (EthercatDevice::setTimeStep) is changed. A thread of its own then restarts the SYNC0 cycle of the DC slaves with
+   * the new period, aligned to the configured shift, so the DC writes do not delay the cycle. The first SYNC0 pulse
+   * with the new period follows within a few milliseconds. Can be called from any thread.
+   * @param[in] timeStep new update time step [s].
+   * @return false if the time step is not positive.
+   */
+  bool setTimeStep(double timeStep);
+
+  /*!
+   * Find the shortest safe update time step on the running bus.
+   * Steps from the longest to the shortest time step, runs options.cyclesPerStep updates in StandaloneEnforceStep mode for each
+   * and measures overruns, roundtrip, working counter errors and the DC sync error. The recommended time step is the shortest one
+   * meeting all criteria, increased by options.margin.
+   * @warning Blocks and calls update() itself: call it after activate() from the thread which otherwise calls update(),
+   * instead of update(). It is refused (AutotuneResult::error) while another thread keeps calling update(), e.g. the spin
+   * thread of the EthercatMasterSingleton, and if the time step bounds are not positive.
+   * @param[in] options time steps to try and acceptance criteria.
+   * @return measurements and recommendation. The configured time step is restored unless options.apply is set.
+   */
+  AutotuneResult autotuneTimeStep(const AutotuneOptions& options = AutotuneOptions{});
+
+  /*!
+   * Returns the location of every slave's process data in the logical process image, call after startup().
+   */
+  ProcessImageLayout getProcessImageLayout();
+
   /*!
    * Returns a raw pointer to the bus_ object.
    */
   soem_interface_rsl::EthercatBusBase* getBusPtr() { return bus_.get(); }
 
+  /*!
+   * Returns the input process image of the first segment, valid after startup().
+   */
+  InputChangeDetector::Region getInputImage() const { return bus_->getInputImage(); }
+
+  /*!
+   * Returns the input samples of a segment. Once enabled, update() publishes the input process image of the segment right
+   * after the process data exchange, stamped with the cycle start. loadEthercatMasterConfiguration() replaces the
+   * buffers, readers created before a reload keep the buffers of the previous configuration.
+   * @param[in] segment 0 for the first segment, 1 for the second one (see getNumberOfSegments()).
+   */
+  std::shared_ptr<InputSnapshotBuffer> getInputSnapshotBuffer(unsigned int segment = 0) const { return inputSnapshots_.at(segment); }
+
+  /*!
+   * Returns a raw pointer to the bus of the second segment, nullptr if it is not configured.
+   */
+  soem_interface_rsl::EthercatBusBase* getSegmentBusPtr() { return segmentBus_.get(); }
+
+  /*!
+   * Returns 2 if the bus is split into two segments, otherwise 1.
+   */
+  unsigned int getNumberOfSegments() const { return segmentBus_ ? 2 : 1; }
+
+  /*!
+   * Returns the most likely faulty link or connector of a segment. Thread safe.
+   * The estimate is built from the per port error counters, which the slave state monitor reads every 100ms after
+   * activate() if doBusDiagnosis is set, independent of logErrorCounters.
+   * @param[in] segment 0 for the first segment, 1 for the second one.
+   */
+  LinkFaultEstimate getLinkFaultEstimate(unsigned int segment = 0) const { return linkFaultLocalizers_.at(segment).getEstimate(); }
+
+  /*!
+   * Returns the latest AL status of every slave of a segment, index i belongs to the slave at bus position i + 1. Thread
+   * safe. The states are read every 100ms by a low priority monitor thread after activate(), which requires doBusDiagnosis
+   * or slaveRecovery.
+   * @param[in] segment 0 for the first segment, 1 for the second one.
+   */
+  std::vector<SlaveStateSample> getSlaveStates(unsigned int segment = 0) const { return slaveStateTrackers_.at(segment).getCurrentStates(); }
+
+  /*!
+   * Returns the timestamped AL state changes of a slave, oldest first. Thread safe.
+   * @param[in] address bus position of the slave.
+   * @param[in] segment 0 for the first segment, 1 for the second one.
+   */
+  std::vector<SlaveStateSample> getSlaveStateHistory(uint16_t address, unsigned int segment = 0) const
+  {
+    return slaveStateTrackers_.at(segment).getHistory(address);
+  }
+
+  /*!
+   * Read the state of the cable redundancy and the location of a line break. State changes are logged.
+   * Sends one datagram per slave, interleaved with the cyclic frames. Do not call it from the update thread.
+   */
+  RedundancyState getRedundancyState();
+
+  /*!
+   * Reconfigure a slave which left OPERATIONAL and bring it back while the rest of the bus keeps cycling.
+   * Reruns the startup() of the devices at this address in PRE_OP. Used by the slave recovery (see
+   * EthercatMasterConfiguration::slaveRecovery), may also be called manually. Do not call it from the update thread.
+   * @param[in] address bus position of the slave.
+   * @param[in] segment 0 for the first segment, 1 for the second one.
+   * @return true if the slave reached OPERATIONAL.
+   */
+  bool recoverSlave(uint16_t address, unsigned int segment = 0);
+
+  /*!
+   * Returns the recovery attempts of every slave which was recovered at least once. Thread safe.
+   */
+  std::vector<SlaveRecoveryStatistics> getSlaveRecoveryStatistics();
+
+  /*!
+   * Set the callback of the stall watchdog (see EthercatMasterConfiguration::stallTimeout), e.g. to bring another bus
+   * into a safe state. It is called from the low priority monitor thread after the stall report was logged.
+   * Call before activate().
+   */
+  void setStallCallback(StallWatchdog::StallCallback callback) { stallCallback_ = std::move(callback); }
+
+  /*!
+   * Number of update thread stalls detected since activate().
+   */
+  uint64_t getStallCount() const { return stallWatchdog_.getStallCount(); }
+
+  /*!
+   * Stop the stall watchdog before the update loop ends, e.g. before the update thread is joined. It is also stopped by
+   * deactivate(), preShutdown() and shutdown() and disarmed when the update thread exits.
+   */
+  void stopStallWatchdog();
+
+  /*!
+   * Subscribe to the CoE emergencies of all slaves (see EthercatMasterConfiguration::collectEmergencies).
+   * The subscriber is called from the emergency dispatch thread, never from the update thread. Thread safe.
+   */
+  void addEmergencySubscriber(EmergencySubscriber subscriber);
+
+  /*!
+   * Number of emergencies dropped because the queue was full.
+   */
+  uint64_t getDroppedEmergencies() const { return droppedEmergencies_; }
+
+  /*!
+   * Update the firmware of several slaves with FoE, up to options.maxConcurrentTransfers transfers run concurrently.
+   * Each slave is set to INIT and BOOT with its boot mailbox (EthercatBus::enterBootState()), the image is written (and
+   * read back if options.verify) and the slave is set back to INIT with its standard mailbox, also if the transfer
+   * failed. The object dictionary caches of the devices at an updated slave are cleared. Identical images are loaded
+   * from disk once. The slave recovery is paused during the update.
+   * @warning Blocks until all transfers ended. The updated slaves leave the process data, stop the devices first.
+   * @param[in] jobs slaves and images.
+   * @param[in] options concurrency, verification and timeouts.
+   * @param[in] progressCallback called on every progress of a slave, from the transfer threads. May be empty.
+   * @return final state of every job, in the order of jobs.
+   */
+  std::vector<FirmwareUpdateProgress> updateFirmware(const std::vector<FirmwareUpdateJob>& jobs,
+                                                     const FirmwareUpdateOptions& options = FirmwareUpdateOptions{},
+                                                     const FirmwareUpdateProgressCallback& progressCallback = nullptr);
+
+  /*!
+   * Returns the progress of the running or last firmware update, in the order of the jobs. Thread safe.
+   */
+  std::vector<FirmwareUpdateProgress> getFirmwareUpdateProgress();
+
+  /*!
+   * Switch a device to one of its PDO mapping profiles (see EthercatDevice::addPdoMappingProfile) while the rest of the
+   * bus keeps cycling. The slave takes a short SAFE_OP detour: the PDO assignment of the profile is written in PRE_OP,
+   * the sync manager and FMMU lengths precomputed at startup are applied, the active profile of the device is swapped
+   * between two update cycles and the slave is set back to OPERATIONAL. The slave recovery is paused during the switch.
+   * If the switch fails, the slave is left in SAFE_OP with the startup lengths and the slave recovery (if configured)
+   * brings it back with the startup profile.
+   * @warning The slave does not exchange process data during the detour (working counter errors), and the update
+   * thread must be running for the swap. Do not call it from the update thread.
+   * @return true if the device is OPERATIONAL with the new profile.
+   */
+  bool switchPdoMappingProfile(const std::string& deviceName, const std::string& profileName);
+
+  /*!
+   * Add periodic acyclic work executed in the update thread within the acyclic budget (see
+   * EthercatMasterConfiguration::acyclicBudget), e.g. parameter traffic of a device.
+   * Call after loadEthercatMasterConfiguration() and before the update loop starts.
+   * @param[in] name name of the task.
+   * @param[in] priority safety before diagnostics before parameter work, safety tasks are never deferred.
+   * @param[in] periodCycles the task is due every periodCycles update cycles.
+   * @param[in] task the work, must not block.
+   */
+  void addAcyclicTask(const std::string& name, AcyclicPriority priority, unsigned int periodCycles, AcyclicScheduler::Task task) {
+    acyclicScheduler_.addTask(name, priority, periodCycles, std::move(task));
+  }
+
+  /*!
+   * Returns the execution and queueing statistics of the acyclic work, indexed by AcyclicPriority. Thread safe.
+   */
+  std::array<AcyclicStatistics, static_cast<size_t>(AcyclicPriority::Size)> getAcyclicStatistics() const {
+    return acyclicScheduler_.getStatistics();
+  }
+
+  /*!
+   * Returns the input change flag of every device in the order of attachment, see
+   * EthercatMasterConfiguration::detectInputChanges. Call from the update thread.
+   */
+  std::vector<uint8_t> getInputChanges() const;
+
+  /*!
+   * Returns the NUMA placement done at startup, see EthercatMasterConfiguration::numaPlacement.
+   */
+  const NumaPlacement& getNumaPlacement() const { return numaPlacement_; }
+
+  /*!
+   * Returns the periodicity analysis of the cycle lateness, see EthercatMasterConfiguration::periodicityWindow. Thread safe.
+   */
+  PeriodicityReport getPeriodicityReport() const { return periodicityDetector_.getReport(); }
+
+  /*!
+   * Returns the traffic of the Ethernet over EtherCAT tunnel, see EthercatMasterConfiguration::eoeInterfacePrefix.
+   */
+  EoeStatistics getEoeStatistics() const { return eoeGateway_.getStatistics(); }
+
+  /*!
+   * Context of the current update cycle, the devices get the same context, see EthercatDevice::getCycleContext().
+   * Call from the update thread.
+   */
+  const CycleContext& getCycleContext() const { return cycleContext_; }
+
   // Configuration
  public:
   /*!
@@ -150,7 +457,7 @@ class EthercatMaster {
   void loadEthercatMasterConfiguration(const EthercatMasterConfiguration& configuration);
 
   /*!
-   * Return the active configuration.
+   * Return the active configuration, with the time step set by setTimeStep().
    * @return configuration_
    */
   EthercatMasterConfiguration getConfiguration();
@@ -181,30 +488,293 @@ class EthercatMaster {
 
 
  protected:
-  std::unique_ptr<soem_interface_rsl::EthercatBusBase> bus_{nullptr};
-  std::vector<EthercatDevice::SharedPtr> devices_;
+  std::unique_ptr<EthercatBus> bus_{nullptr};
+  // second segment of a split bus, see EthercatMasterConfiguration::segmentNetworkInterface.
+  std::unique_ptr<EthercatBus> segmentBus_{nullptr};
+  DeviceRegistry devices_;
   EthercatMasterConfiguration configuration_{};
   unsigned int rateTooLowCounter_{0};
   long accumulatedDelayNs_{0};
 
   timespec sleepEnd_{0, 0};
   timespec lastWakeup_{0, 0};
-  long int timestepNs_{0};
+  // wakeup of the last heartbeat after sleepEnd_.
+  long wakeupLatenessNs_{0};
+  // current time step, read by the service threads. configuration_.timeStep keeps the configured one.
+  std::atomic<long> timestepNs_{0};
+  std::atomic<double> timeStep_{0.0};
+  // set by setTimeStep(), applied by the update thread, 0 if none.
+  std::atomic<double> pendingTimeStep_{0.0};
+  // SYNC0 cycle time handed from the update thread to the SYNC0 update thread, 0 if none.
+  std::atomic<long> pendingSync0CycleTimeNs_{0};
+  std::thread sync0UpdateThread_;
+  std::atomic<bool> sync0UpdateRunning_{false};
+  std::mutex sync0UpdateMutex_;
+  std::condition_variable sync0UpdateCondition_;
+  // last thread which called update() and the number of updates, see isUpdatedByOtherThread().
+  std::atomic<std::thread::id> updateThread_{};
+  std::atomic<uint64_t> updateCount_{0};
 
   std::mutex timeStepMutex_;
   long timeStepNsMeasured_{0};
 
+  // written by the update thread only and published with a sequence lock, a reset is requested from any thread.
+  CycleStatistics cycleStatistics_;
+  SeqLock<CycleStatistics> cycleStatisticsPublished_;
+  RoundtripWindow roundtripWindow_;
+  std::atomic<bool> cycleStatisticsResetRequested_{false};
+
   std::mutex logFileStreamMutex_{};  // only for creation destruction needed, used in different thread, therefore make sure buildup before
                                      // ecat updadte thread is started.
-  size_t busDiagDecimationCount_{0};
+  AcyclicScheduler acyclicScheduler_;
+  timespec cycleStart_{0, 0};
+  // passed to the devices, updated at the start of every update.
+  CycleContext cycleContext_;
+  bool cycleOverrun_{false};
+  // opened by the update thread, see EthercatMasterConfiguration::perfCounters.
+  PerfCounters perfCounters_;
+  EoeGateway eoeGateway_;
+  NumaPlacement numaPlacement_;
+  bool numaThreadPinned_{false};
+  // fed by the update thread, see EthercatMasterConfiguration::periodicityWindow.
+  PeriodicityDetector periodicityDetector_;
+  // published by the update thread, one per segment, see getInputSnapshotBuffer().
+  std::array<std::shared_ptr<InputSnapshotBuffer>, 2> inputSnapshots_{std::make_shared<InputSnapshotBuffer>(),
+                                                                      std::make_shared<InputSnapshotBuffer>()};
+  std::array<InputChangeDetector::Region, 2> inputImages_;
+  // UpdateMode::ExternalTrigger, trigger times are 0 without trigger.
+  ExternalTrigger externalTrigger_;
+  CycleNotification cycleNotification_;
+  int64_t sendTimeNs_{0};
+  int64_t triggerTimeNs_{0};
+  int64_t previousTriggerTimeNs_{0};
+  long triggerIntervalNs_{0};
+  uint64_t coalescedTriggers_{0};
+  bool perfCountersOpened_{false};
   std::fstream busDiagnosisLogFile_{nullptr};
   std::chrono::time_point<std::chrono::system_clock> logStartTime_;
-  soem_interface_rsl::BusDiagnosisLog busDiagnosisLog_{};
+  // the diagnosis log, the link fault localizers, the slave state trackers and the slave states exist per segment.
+  std::array<soem_interface_rsl::BusDiagnosisLog, 2> busDiagnosisLogs_{};
+  std::array<LinkFaultLocalizer, 2> linkFaultLocalizers_;
+  std::array<std::string, 2> lastLinkFaultDescriptions_;
+  std::mutex redundancyStateMutex_;
+  RedundancyState redundancyState_;
+  std::array<SlaveStateTracker, 2> slaveStateTrackers_;
+  // AL status of every slave (state << 16 | AL status code), written by the slave state monitor, read by the bus diagnosis.
+  std::array<std::vector<std::atomic<uint32_t>>, 2> slaveStates_;
+  std::thread slaveStateMonitorThread_;
+  std::atomic<bool> slaveStateMonitorRunning_{false};
+  // granted by the acyclic scheduler of the update thread.
+  AcyclicService slaveStateMonitorService_;
+
+  std::thread slaveRecoveryThread_;
+  std::atomic<bool> slaveRecoveryRunning_{false};
+  // set by the update thread if the working counter is too low or a slave is not OPERATIONAL.
+  std::atomic<bool> slaveRecoveryRequested_{false};
+  std::mutex slaveRecoveryMutex_;
+  // see inhibitSlaveRecovery(), held by the slave recovery thread during an attempt.
+  std::mutex slaveRecoveryInhibitMutex_;
+  unsigned int slaveRecoveryInhibits_{0};
+  // by segment and bus position.
+  std::map<std::pair<unsigned int, uint16_t>, SlaveRecoveryStatistics> slaveRecoveryStatistics_;
+
+  StallWatchdog stallWatchdog_;
+  StallWatchdog::StallCallback stallCallback_;
+
+  std::unique_ptr<SpscQueue<EmergencyMessage>> emergencyQueue_;
+  std::atomic<uint64_t> droppedEmergencies_{0};
+  std::thread emergencyDispatchThread_;
+  std::atomic<bool> emergencyDispatchRunning_{false};
+  std::mutex emergencySubscribersMutex_;
+  std::vector<EmergencySubscriber> emergencySubscribers_;
+  // names of the devices by segment and bus position, snapshot for the dispatch thread taken at its start.
+  std::array<std::vector<std::string>, 2> emergencyDeviceNames_;
+
+  std::thread mailboxServiceThread_;
+  std::atomic<bool> mailboxServiceRunning_{false};
+  // granted by the acyclic scheduler of the update thread.
+  AcyclicService mailboxService_;
+
+  // PDO mapping profiles of every device (by index in devices_), precomputed at startup.
+  std::vector<std::vector<PdoMappingLayout>> pdoMappingLayouts_;
+  std::mutex pdoMappingMutex_;
+  // profile swap handed to the update thread, see switchPdoMappingProfile().
+  size_t pendingPdoMappingDevice_{0};
+  size_t pendingPdoMappingProfile_{0};
+  std::atomic<bool> pdoMappingSwitchPending_{false};
+
+  FirmwareImageCache firmwareImageCache_;
+  std::mutex firmwareUpdateMutex_;
+  std::vector<FirmwareUpdateProgress> firmwareUpdateProgress_;
 
 
  protected:
   bool deviceExists(const std::string& name);
 
+  /*!
+   * Names of the devices at a bus position of a segment, "unknown" if there is none.
+   */
+  std::string getDeviceName(uint16_t address, unsigned int segment);
+
+  /*!
+   * Returns the bus of a segment, nullptr if the segment is not configured.
+   */
+  EthercatBus* getSegmentBus(unsigned int segment);
+
+  /*!
+   * Move the buses and the master state to the NUMA node of the network interface, see
+   * EthercatMasterConfiguration::numaPlacement.
+   */
+  void placeOnNumaNode();
+
+  /*!
+   * Pin the calling update thread to the CPUs of the NUMA node.
+   */
+  void pinUpdateThread();
+
+  /*!
+   * Wait for the external trigger, see setTriggerFd().
+   */
+  void waitForTrigger();
+
+  /*!
+   * Add the trigger of the current cycle to the cycle statistics, after the process data was sent.
+   */
+  void recordTrigger();
+
+  /*!
+   * Fill the cycle context from the cycle start, called once at the start of every update.
+   */
+  void updateCycleContext();
+
+  /*!
+   * Add the performance counters of the previous cycle to the cycle statistics, opens the counters in the first call.
+   */
+  void samplePerfCounters();
+
+  /*!
+   * Add the lateness of the cycle start to the periodicity analysis: the wakeup lateness of the heartbeat in the standalone
+   * modes, the delay after the trigger with UpdateMode::ExternalTrigger, the deviation of the measured period otherwise.
+   */
+  void samplePeriodicity(UpdateMode updateMode);
+
+  /*!
+   * Compute the process data sizes of the PDO mapping profiles of all devices and check them against the process
+   * image mapped at startup.
+   */
+  void precomputePdoMappingLayouts();
+
+  /*!
+   * Swap the active PDO mapping profile of a device if requested, called by the update thread at the cycle start.
+   */
+  void applyPendingPdoMappingProfile();
+
+  /*!
+   * true if another thread than the calling one keeps calling update(). Waits three time steps for an update if
+   * another thread called update() before.
+   */
+  bool isUpdatedByOtherThread();
+
+  /*!
+   * Apply a new time step from the update thread, see setTimeStep(). The SYNC0 cycle time is changed by the SYNC0
+   * update thread, the period of the slave state monitor is adapted.
+   */
+  void applyTimeStep(double timeStep);
+
+  /*!
+   * Period of the slave state monitor in update cycles of the time step.
+   */
+  unsigned int getSlaveStateMonitorCycles(double timeStep) const;
+
+  /*!
+   * Start / stop the thread which restarts SYNC0 of the DC slaves after a time step change, see setTimeStep().
+   */
+  void startSync0Update();
+  void stopSync0Update();
+
+  /*!
+   * SYNC0 update thread: writes the pending SYNC0 cycle time to the DC slaves of all segments.
+   */
+  void sync0UpdateLoop();
+
+  /*!
+   * Send and receive the process data and measure the roundtrip.
+   */
+  void exchangeProcessData();
+
+  /*!
+   * Start / stop the slave state monitor, start has no effect if neither doBusDiagnosis nor slaveRecovery is configured.
+   */
+  void startSlaveStateMonitor();
+  void stopSlaveStateMonitor();
+
+  /*!
+   * Slave state monitor thread: reads the AL status of all slaves outside the update thread, records and logs changes,
+   * requests the slave recovery and publishes the states to the bus diagnosis.
+   */
+  void slaveStateMonitorLoop();
+
+  /*!
+   * Read the bus state and the error counters, write the diagnosis log and update the link fault estimate.
+   */
+  void doBusDiagnosis();
+
+  /*!
+   * Receive the pending unsolicited mailboxes of all slaves, send the next EoE fragment and forward the emergencies.
+   */
+  void serviceMailboxes();
+
+  /*!
+   * Start / stop the mailbox service thread, start has no effect if neither mapMailboxStatus, collectEmergencies nor
+   * the EoE tunnel is configured.
+   */
+  void startMailboxService();
+  void stopMailboxService();
+
+  /*!
+   * Mailbox service thread: services the mailboxes outside the update thread, every MAILBOX_SERVICE_DECIMATION time
+   * steps.
+   */
+  void mailboxServiceLoop();
+
+  /*!
+   * Move the emergencies received by SOEM into the emergency queue, called from the mailbox service thread.
+   */
+  void collectEmergencies();
+
+  /*!
+   * Start / stop the thread publishing the queued emergencies to the subscribers.
+   */
+  void startEmergencyDispatch();
+  void stopEmergencyDispatch();
+  void emergencyDispatchLoop();
+
+  /*!
+   * Start / stop the slave recovery thread, start has no effect if slaveRecovery is not configured.
+   */
+  void startSlaveRecovery();
+  void stopSlaveRecovery();
+
+  /*!
+   * Pause the slave recovery while slaves leave OPERATIONAL on purpose (PDO mapping switch, firmware update), without
+   * stopping its thread. Waits for a running attempt, counted: the recovery resumes once every inhibit is released.
+   * Thread safe.
+   */
+  void inhibitSlaveRecovery();
+  void releaseSlaveRecovery();
+
+  /*!
+   * Slave recovery thread: waits for a request of the update thread or the slave state monitor and recovers every
+   * slave which the monitor did not find OPERATIONAL. The pause between the attempts of a slave doubles with every
+   * failed attempt.
+   */
+  void slaveRecoveryLoop();
+
+  /*!
+   * Start the stall watchdog, no effect if stallTimeout is not configured.
+   */
+  void startStallWatchdog();
+
   /*!
    * Let the update thread sleep such that the desired update rate is created.
    * - If enforceRate is true:
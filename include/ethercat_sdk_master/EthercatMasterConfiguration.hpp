@@ -15,6 +15,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace ecat_master{
 
@@ -34,6 +35,24 @@ struct EthercatMasterConfiguration{
    */
   std::string networkInterface{""};
 
+  /*!
+   * Secondary network interface for cable redundancy, empty to disable.
+   * The last slave of the line is connected to this interface, frames are sent on both interfaces and a single
+   * line break is bridged within the same cycle. Requires CAP_NET_ADMIN to toggle the interface during startup, the
+   * startup of the master fails without it.
+   */
+  std::string redundantNetworkInterface{""};
+
+  /*!
+   * Network interface of a second bus segment, empty to disable.
+   * A long line can be split into two segments on two interfaces, which are driven as one set of devices in the same
+   * cycle: the frames of both segments are sent before the frames of either segment are received, which roughly
+   * halves the roundtrip. Devices are attached to a segment with EthercatMaster::attachDevice(device, 1).
+   * The bus diagnosis, slave state monitor, slave recovery and mailbox service cover both segments, the firmware update
+   * covers the first segment. EoE is not supported on a split bus.
+   */
+  std::string segmentNetworkInterface{""};
+
   /// Communication update time step.
   double timeStep{0.0};
 
@@ -80,6 +99,103 @@ struct EthercatMasterConfiguration{
   bool logErrorCounters{false};
 
 
+  /*!
+   * Background recovery of slaves which dropped out of OPERATIONAL (e.g. after a brown-out), detected from the
+   * working counter and the slave AL status. The slave is reconfigured and brought back to OPERATIONAL while the
+   * rest of the bus keeps cycling. Active between activate() and deactivate() / preShutdown(). Starts the slave state
+   * monitor, failed attempts are retried with an exponential back off per slave.
+   */
+  bool slaveRecovery{false};
+
+  /*!
+   * Stall watchdog of the update thread [s]: a stall is reported if update() was not called for this time, 0 disables it.
+   * Active between activate() and deactivate() / preShutdown(). See EthercatMaster::setStallCallback.
+   */
+  double stallTimeout{0.0};
+
+  /*!
+   * Map the mailbox status of the slaves into a logical area read with a single LRD (one spare FMMU per slave) and
+   * service pending mailboxes (e.g. emergencies) from a low priority thread, only for slaves which have data.
+   */
+  bool mapMailboxStatus{false};
+
+  /*!
+   * Collect the CoE emergencies of all slaves from the mailbox service thread into a lock-free queue and publish them to the
+   * subscribers (EthercatMaster::addEmergencySubscriber) from a separate thread. Services the mailboxes like
+   * mapMailboxStatus, with polling of the mailbox status if it is not mapped.
+   */
+  bool collectEmergencies{false};
+
+  /*!
+   * Time per update cycle for acyclic work in the update thread (bus diagnosis, tasks added with
+   * EthercatMaster::addAcyclicTask) [s]. The work is further limited to the time left until the end of the cycle and
+   * served by priority, the rest is deferred. Safety tasks always run and use up budget of the lower priorities.
+   * The mailbox service (emergencies, EoE tunnel) and the slave state monitor run in threads of their own, their runs
+   * are granted within the same budget and their execution time is charged to it. The mailbox service has safety
+   * priority, the slave state monitor diagnostics priority. Not scheduled: the slave recovery and
+   * the firmware update, which run on demand, and the emergency dispatch to the subscribers, which sends no datagrams.
+   * 0: no budget, all due work runs in the cycle.
+   */
+  double acyclicBudget{0.0};
+
+  /*!
+   * Compare the inputs of every device with the previous cycle when the process data was received, before the devices
+   * read it, see EthercatDevice::inputsChanged().
+   */
+  bool detectInputChanges{false};
+
+  /*!
+   * Sample the performance counters of the update thread (instructions, CPU cycles, cache misses, context switches)
+   * in every update and add them to the cycle statistics, separately for cycles which took more than 10% longer than
+   * the time step. Requires perf_event_open permissions (kernel.perf_event_paranoid), unavailable counters read as 0.
+   */
+  bool perfCounters{false};
+
+  /*!
+   * Ethernet over EtherCAT tunnel: every EoE slave gets a TAP interface <eoeInterfacePrefix><slave>,
+   * e.g. eoe3 for the web interface of a drive at bus position 3. Empty disables the tunnel. Requires CAP_NET_ADMIN, the
+   * interfaces need to be configured by the system. Received fragments are read by the regular mailbox service. Not
+   * supported together with segmentNetworkInterface.
+   */
+  std::string eoeInterfacePrefix{""};
+
+  /*!
+   * Largest EoE fragment sent per mailbox service round (every 10 update cycles), the tunnel sends at most one fragment
+   * per round from the mailbox service thread. Limits the mailbox traffic the tunnel adds to the bus, see
+   * EthercatMaster::getEoeStatistics(). Fragments are sent in blocks of 32 bytes, smaller budgets are raised to one
+   * block.
+   */
+  unsigned int eoeBytesPerRound{256};
+
+  /*!
+   * Layout pass at startup: the process data of every slave is moved to its natural boundary in the logical process
+   * image and the inputs to a cache line by rewriting the FMMUs, the devices in hotDevices are grouped at the start of
+   * the outputs and inputs. The alignment is dropped if it would need more frames. The chosen layout is logged.
+   */
+  bool optimizeProcessImageLayout{false};
+
+  /*!
+   * Names of the devices grouped at the start of the process image by optimizeProcessImageLayout, e.g. the drives
+   * accessed in every cycle.
+   */
+  std::vector<std::string> hotDevices{};
+
+  /*!
+   * Place the master on the NUMA node of the network interface (from sysfs): at startup the process image, the SOEM
+   * slave tables, the master state and the devices are moved to the node (the second segment to the node of its
+   * interface), the first update pins the update thread to the CPUs of the node unless the application placed it
+   * elsewhere. No effect on single node systems.
+   */
+  bool numaPlacement{true};
+
+  /*!
+   * Periodicity analysis of the cycle lateness in windows of this many update cycles, to find periodic interference
+   * (SMIs, cron jobs, interrupt storms) which disappears in the cycle statistics, see EthercatMaster::getPeriodicityReport().
+   * The window covers at least two periods of the slowest interference of interest, e.g. 16384 for 16s at 1kHz.
+   * 0 disables the analysis.
+   */
+  unsigned int periodicityWindow{0};
+
   /**
    * Scheduler priority of the update thread
    */
@@ -88,12 +204,26 @@ struct EthercatMasterConfiguration{
    * Comparison operator
   */
   bool operator==(const EthercatMasterConfiguration& o) const{
-    return o.name == name && o.networkInterface == networkInterface && 
+    return o.name == name && o.networkInterface == networkInterface && o.redundantNetworkInterface == redundantNetworkInterface &&
+           o.segmentNetworkInterface == segmentNetworkInterface &&
                   o.timeStep == timeStep && o.pdoSizeCheck == pdoSizeCheck && 
                   o.slaveDiscoverRetries == slaveDiscoverRetries && o.updateRateTooLowWarnThreshold == updateRateTooLowWarnThreshold &&
                   o.rateCompensationCoefficient == rateCompensationCoefficient &&
                   o.doBusDiagnosis == doBusDiagnosis &&
-                  o.logErrorCounters == logErrorCounters;
+                  o.logErrorCounters == logErrorCounters &&
+                  o.slaveRecovery == slaveRecovery &&
+                  o.stallTimeout == stallTimeout &&
+                  o.mapMailboxStatus == mapMailboxStatus &&
+                  o.collectEmergencies == collectEmergencies &&
+                  o.acyclicBudget == acyclicBudget &&
+                  o.detectInputChanges == detectInputChanges &&
+                  o.perfCounters == perfCounters &&
+                  o.eoeInterfacePrefix == eoeInterfacePrefix &&
+                  o.eoeBytesPerRound == eoeBytesPerRound &&
+                  o.optimizeProcessImageLayout == optimizeProcessImageLayout &&
+                  o.hotDevices == hotDevices &&
+                  o.numaPlacement == numaPlacement &&
+                  o.periodicityWindow == periodicityWindow;
   }
 
   bool operator!=(const EthercatMasterConfiguration& o) const{
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ethercat_sdk_master/EthercatMaster.hpp>
+#include <ethercat_sdk_master/InputSnapshot.hpp>
 #include <map>
 
 namespace ecat_master
@@ -157,6 +158,34 @@ namespace ecat_master
             return handles_.find(networkInterface) != handles_.end();
         }
 
+        /**
+         * @brief create a reader of consistent input snapshots across several buses, e.g. both arms of a robot
+         * Every master publishes the input process image of its bus within update(), right after the process data exchange, into a small
+         * ring of samples (EthercatMaster::getInputSnapshotBuffer). A read takes
+         * from every bus the sample closest to the newest cycle start all buses have published, with its age and offset, without locks.
+         * The second segment of a split bus is a bus of its own in the snapshot, named by its segment network interface.
+         */
+        InputSnapshotReader createInputSnapshotReader(const std::vector<std::string> &network_interfaces)
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            std::vector<InputSnapshotReader::Source> sources;
+            for (const auto &network_interface : network_interfaces)
+            {
+                if (!hasMaster(network_interface))
+                {
+                    throw std::logic_error("EthercatMaster for interface: " + network_interface + " is not handled by this singleton");
+                }
+                const auto &master = handles_.at(network_interface).ecat_master;
+                for (unsigned int segment = 0; segment < master->getNumberOfSegments(); segment++)
+                {
+                    const auto buffer = master->getInputSnapshotBuffer(segment);
+                    buffer->enable();
+                    sources.emplace_back(segment == 0 ? network_interface : master->getConfiguration().segmentNetworkInterface, buffer);
+                }
+            }
+            return InputSnapshotReader(std::move(sources));
+        }
+
         /**
          * @brief releaseMaster - release your handle obtain via aquireMaster
          * This method decrements the internal reference counter for the given EthercatMaster and performs the shutdown if no references are living anymore
@@ -231,9 +260,10 @@ namespace ecat_master
         EthercatMasterSingleton() = default;
         ~EthercatMasterSingleton()
         {
-            // Tell every update thread to stop spinning
+            // Tell every update thread to stop spinning, the end of the update loop is not a stall
             for (auto &[interface, handle] : handles_)
             {
+                handle.ecat_master->stopStallWatchdog();
                 handle.abort_signal = true;
             }
             // Wait for the threads to end
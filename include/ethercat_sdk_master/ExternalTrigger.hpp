@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace ecat_master {
+
+class CycleNotification;
+
+/*!
+ * Waits for the trigger of UpdateMode::ExternalTrigger on a file descriptor: an eventfd, a timerfd or the cycle
+ * notification of another EthercatMaster. Does not own the file descriptor.
+ */
+class ExternalTrigger {
+ public:
+  /*!
+   * Set the file descriptor to wait on, -1 to disable. A timerfd needs to run on CLOCK_MONOTONIC.
+   * @param[in] notification cycle notification the file descriptor belongs to, its notify time is the trigger time.
+   */
+  void setFd(int fd, const CycleNotification* notification = nullptr);
+
+  int getFd() const { return fd_; }
+
+  /*!
+   * Wait for the next trigger and consume it.
+   * Without file descriptor the call sleeps for the timeout.
+   * @param[in] timeoutNs longest time to wait.
+   * @param[out] triggerTimeNs time of the trigger (CLOCK_MONOTONIC): the notify time of a cycle notification, the
+   * expiration of a periodic timerfd, otherwise the wakeup.
+   * @param[out] triggers number of triggers since the previous wait, more than one if triggers were missed.
+   * @return false on timeout or error.
+   */
+  bool wait(long timeoutNs, int64_t& triggerTimeNs, uint64_t& triggers);
+
+ private:
+  int fd_{-1};
+  bool timer_{false};
+  const CycleNotification* notification_{nullptr};
+};
+
+/*!
+ * Cycle notification of an EthercatMaster: an eventfd signalled once per update after the process data was sent,
+ * e.g. the trigger of a second master in UpdateMode::ExternalTrigger. Reading the eventfd consumes the notifications,
+ * so it has a single consumer: only one master or thread may wait on it.
+ */
+class CycleNotification {
+ public:
+  CycleNotification() = default;
+  ~CycleNotification();
+
+  CycleNotification(const CycleNotification&) = delete;
+  CycleNotification& operator=(const CycleNotification&) = delete;
+
+  /*!
+   * Create the eventfd, no effect if it exists. Call before the update thread runs.
+   * @return false if it cannot be created.
+   */
+  bool open();
+
+  /*!
+   * Returns the eventfd, -1 before open().
+   */
+  int getFd() const { return fd_; }
+
+  /*!
+   * Store the notify time and signal the eventfd if it was created.
+   * @param[in] timeNs time of the notification (CLOCK_MONOTONIC), e.g. the send time of the process data.
+   */
+  void notify(int64_t timeNs);
+
+  /*!
+   * Time of the last notification (CLOCK_MONOTONIC), 0 before the first one. Thread safe.
+   */
+  int64_t getNotifyTimeNs() const { return notifyTimeNs_.load(std::memory_order_acquire); }
+
+ private:
+  int fd_{-1};
+  std::atomic<int64_t> notifyTimeNs_{0};
+};
+
+}  // namespace ecat_master
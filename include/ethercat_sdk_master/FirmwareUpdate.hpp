@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Firmware update of a single slave.
+ */
+struct FirmwareUpdateJob {
+  /// Bus position of the slave.
+  uint16_t slave{0};
+  /// Firmware image on disk.
+  std::string imagePath;
+  /// FoE file name expected by the slave, empty: the file name of imagePath.
+  std::string fileName;
+  /// FoE password, 0 if none.
+  uint32_t password{0};
+};
+
+/*!
+ * Options of EthercatMaster::updateFirmware.
+ */
+struct FirmwareUpdateOptions {
+  /// Maximal number of concurrent FoE transfers.
+  unsigned int maxConcurrentTransfers{4};
+  /// Read the image back with FoE and compare it, requires slaves supporting FoE read of the firmware file.
+  bool verify{false};
+  /// Timeout of a single FoE packet [us].
+  int packetTimeoutUs{2000000};
+  /// Set the slaves back to INIT after the update, most slaves start the new firmware with this transition.
+  bool returnToInit{true};
+};
+
+enum class FirmwareUpdateState { Pending, Transferring, Verifying, Done, Failed };
+
+/*!
+ * Returns a readable representation of a firmware update state.
+ */
+std::string firmwareUpdateStateToString(FirmwareUpdateState state);
+
+/*!
+ * Progress of the firmware update of a single slave.
+ */
+struct FirmwareUpdateProgress {
+  uint16_t slave{0};
+  FirmwareUpdateState state{FirmwareUpdateState::Pending};
+  size_t imageSize{0};
+  size_t bytesTransferred{0};
+  /// Reason of the failure.
+  std::string error;
+};
+
+using FirmwareUpdateProgressCallback = std::function<void(const FirmwareUpdateProgress&)>;
+
+/*!
+ * Firmware images loaded from disk, identical images are loaded once and shared between the transfers.
+ */
+class FirmwareImageCache {
+ public:
+  using Image = std::shared_ptr<const std::vector<char>>;
+
+  /*!
+   * Returns the image, loads it on first use. nullptr if it cannot be read. Thread safe.
+   */
+  Image get(const std::string& path);
+
+  /*!
+   * Release all images. Thread safe.
+   */
+  void clear();
+
+ private:
+  std::mutex mutex_;
+  std::map<std::string, Image> images_;
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Detects which regions of the input process image changed since the previous cycle.
+ * Every region is compared against a shadow copy with 16 byte SIMD compares (SSE2, scalar fallback), the shadow copy
+ * of a changed region is updated. Cost: one compare pass over the inputs and a copy of the changed regions only.
+ */
+class InputChangeDetector {
+ public:
+  /*!
+   * A contiguous part of the input process image, e.g. the inputs of one slave.
+   */
+  struct Region {
+    const uint8_t* data{nullptr};
+    size_t size{0};
+  };
+
+  /*!
+   * Set the regions to monitor, the memory must stay valid until the next configure(). All regions are reported
+   * as changed by the first update().
+   */
+  void configure(const std::vector<Region>& regions);
+
+  /*!
+   * Compare the regions with their state of the previous update().
+   */
+  void update();
+
+  /*!
+   * Returns true if the region changed in the last update().
+   */
+  bool changed(size_t region) const { return region < changed_.size() && changed_[region] != 0; }
+
+  /*!
+   * Change flag of every region, in the order of configure().
+   */
+  const std::vector<uint8_t>& getChanged() const { return changed_; }
+
+  /*!
+   * Returns true if both memory areas are equal.
+   */
+  static bool equal(const uint8_t* a, const uint8_t* b, size_t size);
+
+ private:
+  std::vector<Region> regions_;
+  // shadow copy of every region, at shadowOffsets_.
+  std::vector<uint8_t> shadow_;
+  std::vector<size_t> shadowOffsets_;
+  std::vector<uint8_t> changed_;
+  bool initialized_{false};
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Inputs of one bus in a MultiBusSnapshot.
+ */
+struct BusInputSample {
+  std::string networkInterface;
+  /// false if the bus did not publish a sample yet.
+  bool valid{false};
+  /// Cycle of the sample, see CycleContext::cycle.
+  uint64_t cycle{0};
+  /// Start of the cycle of the sample, CLOCK_MONOTONIC [ns].
+  int64_t stampNs{0};
+  /// Time from the start of the cycle to the snapshot [ns].
+  int64_t ageNs{0};
+  /// Stamp relative to the reference stamp of the snapshot [ns].
+  int64_t offsetNs{0};
+  /// Input process image of the bus.
+  std::vector<uint8_t> inputs;
+};
+
+/*!
+ * Inputs of several buses, each taken from the cycle closest to a common reference time.
+ */
+struct MultiBusSnapshot {
+  /// Newest cycle start all buses have a sample for, CLOCK_MONOTONIC [ns].
+  int64_t referenceStampNs{0};
+  /// Largest difference between the stamps of the samples [ns].
+  int64_t skewNs{0};
+  std::vector<BusInputSample> buses;
+};
+
+/*!
+ * The last input samples of a bus, published by its update thread and read without locks (one sequence lock per sample).
+ * A reader can take the sample of any of the last depth cycles, e.g. to align it with another bus.
+ */
+class InputSnapshotBuffer {
+ public:
+  static constexpr size_t depth{8};
+
+  /*!
+   * Allocate the samples, once before the first publish(). The size is fixed afterwards: readers copy imageSize bytes
+   * without a lock, use a new buffer for another size.
+   * @return false if the buffer was configured with another size.
+   */
+  bool configure(size_t imageSize);
+
+  /*!
+   * Start publishing, called when the first reader is created.
+   */
+  void enable() { enabled_ = true; }
+
+  bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  /*!
+   * Publish the inputs of a cycle, called by the update thread of the bus.
+   */
+  void publish(uint64_t cycle, int64_t stampNs, const uint8_t* inputs);
+
+  /*!
+   * Returns the stamp of the newest sample.
+   * @return false if there is none.
+   */
+  bool getLatestStamp(int64_t& stampNs) const;
+
+  /*!
+   * Copy the sample whose stamp is closest to stampNs.
+   * @return false if there is no sample or the update thread overwrote it repeatedly while copying.
+   */
+  bool read(int64_t stampNs, BusInputSample& sample) const;
+
+ private:
+  struct alignas(64) Slot {
+    // odd while the update thread writes the slot.
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> cycle{0};
+    std::atomic<int64_t> stampNs{0};
+    std::vector<uint8_t> data;
+  };
+
+  /*!
+   * Read the stamp and cycle and optionally the data of a slot.
+   * @return false if the slot is empty or was written meanwhile.
+   */
+  bool readSlot(const Slot& slot, uint64_t& cycle, int64_t& stampNs, uint8_t* data) const;
+
+  std::array<Slot, depth> slots_;
+  std::atomic<uint64_t> published_{0};
+  std::atomic<bool> configured_{false};
+  std::atomic<bool> enabled_{false};
+  size_t imageSize_{0};
+};
+
+/*!
+ * Reads consistent input snapshots of a selection of buses, see EthercatMasterSingleton::createInputSnapshotReader.
+ */
+class InputSnapshotReader {
+ public:
+  using Source = std::pair<std::string, std::shared_ptr<InputSnapshotBuffer>>;
+
+  InputSnapshotReader() = default;
+  explicit InputSnapshotReader(std::vector<Source> sources) : sources_(std::move(sources)) {}
+
+  /*!
+   * Take the newest snapshot: the reference is the newest cycle start every bus has published, every bus contributes
+   * the sample closest to it. Lock free, the buffers of the snapshot are reused.
+   * @return true if every bus contributed a sample.
+   */
+  bool read(MultiBusSnapshot& snapshot) const;
+
+ private:
+  std::vector<Source> sources_;
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Placement of the EthercatMaster on the NUMA node of its network interface.
+ */
+struct NumaPlacement {
+  /*!
+   * A memory region moved to a NUMA node.
+   */
+  struct Region {
+    std::string name;
+    /// Target node, the node of the network interface of the region.
+    int node{-1};
+    /// Pages of the region on the target node afterwards.
+    size_t movedPages{0};
+    size_t pages{0};
+  };
+
+  std::string networkInterface;
+  /// NUMA node of the network interface, -1 if unknown (single node system, virtual interface).
+  int node{-1};
+  /// CPUs of the node.
+  std::vector<int> cpus;
+  /// The buses (process image and SOEM slave tables), the master state and the device objects.
+  std::vector<Region> regions;
+
+  /*!
+   * Human readable placement, e.g. for logging.
+   */
+  std::string toString() const;
+};
+
+/*!
+ * Returns the NUMA node of a network interface from sysfs, -1 if unknown.
+ */
+int getNetworkInterfaceNumaNode(const std::string& networkInterface);
+
+/*!
+ * Returns the CPUs of a NUMA node from sysfs, empty if unknown.
+ */
+std::vector<int> getNumaNodeCpus(int node);
+
+/*!
+ * Move the pages of a memory range of the calling process to a NUMA node (move_pages), the memory policy is not changed.
+ * @param[out] pages number of pages of the range.
+ * @return number of pages on the node afterwards.
+ */
+size_t moveToNumaNode(const void* address, size_t size, int node, size_t& pages);
+
+}  // namespace ecat_master
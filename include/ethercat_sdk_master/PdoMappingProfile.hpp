@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Alternative PDO mapping of a device, e.g. a position and a torque control mapping of a drive.
+ * The profile selects predefined (or previously configured) PDOs through the PDO assignment objects.
+ */
+struct PdoMappingProfile {
+  std::string name;
+  /// RxPDOs (outputs) assigned in 0x1C12.
+  std::vector<uint16_t> rxPdoAssignment;
+  /// TxPDOs (inputs) assigned in 0x1C13.
+  std::vector<uint16_t> txPdoAssignment;
+  /// Size of the outputs with this profile [bytes].
+  uint32_t rxPdoSize{0};
+  /// Size of the inputs with this profile [bytes].
+  uint32_t txPdoSize{0};
+};
+
+/*!
+ * Process data window of a profile, precomputed by the EthercatMaster at startup.
+ */
+struct PdoMappingLayout {
+  uint32_t outputBytes{0};
+  uint32_t inputBytes{0};
+  /// The profile fits into the process image reserved for the slave at startup.
+  bool fits{false};
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ethercat_sdk_master/CycleStatistics.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace ecat_master {
+
+/*!
+ * Hardware and software performance counters of the calling thread (perf_event_open): instructions, CPU cycles,
+ * last level cache misses and context switches. Hardware counters are read in user space with rdpmc where the kernel
+ * permits it (x86, /sys/bus/event_source/devices/cpu/rdpmc), with read() otherwise. Counters which cannot be opened
+ * (kernel.perf_event_paranoid, no PMU in a virtual machine) read as 0.
+ */
+class PerfCounters {
+ public:
+  enum Counter : unsigned int { Instructions = 0, CpuCycles, CacheMisses, ContextSwitches, Size };
+
+  PerfCounters() = default;
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  /*!
+   * Open the counters for the calling thread, which is the only thread allowed to sample them.
+   * @return false if none of the counters is available.
+   */
+  bool open();
+
+  /*!
+   * Close all counters.
+   */
+  void close();
+
+  /*!
+   * Returns true if at least one counter is open.
+   */
+  bool isOpen() const;
+
+  /*!
+   * Counter deltas since the previous sample.
+   * @param[out] values counts since the previous call.
+   * @return false for the first sample after open().
+   */
+  bool sample(PerfCounterValues& values);
+
+  /*!
+   * Available counters and how they are read, e.g. for logging.
+   */
+  std::string toString() const;
+
+ private:
+  struct Event {
+    int fd{-1};
+    // perf_event_mmap_page of hardware counters, nullptr if rdpmc is not used.
+    void* page{nullptr};
+  };
+
+  uint64_t read(const Event& event) const;
+
+  std::array<Event, Size> events_;
+  std::array<uint64_t, Size> previous_{};
+  bool sampled_{false};
+};
+
+}  // namespace ecat_master
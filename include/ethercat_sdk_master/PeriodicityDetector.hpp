@@ -0,0 +1,126 @@
+#pragma once
+
+#include "ethercat_sdk_master/SpscQueue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Periodic component of the cycle lateness.
+ */
+struct PeriodicComponent {
+  /// Period [s].
+  double period{0.0};
+  /// Period in update cycles.
+  double periodCycles{0.0};
+  /// Peak to peak of the mean lateness per cycle of the period [ns], e.g. the size of a periodic spike.
+  double amplitudeNs{0.0};
+  /// Autocorrelation of the lateness at the period, relative to its variance.
+  double correlation{0.0};
+  /// Significant harmonics among the first 16, many for short spikes, none for a sine.
+  unsigned int harmonics{0};
+};
+
+/*!
+ * Result of the periodicity analysis of the last complete window.
+ */
+struct PeriodicityReport {
+  /// Windows analysed since start().
+  uint64_t windows{0};
+  /// Samples dropped because the analysis thread did not keep up.
+  uint64_t droppedSamples{0};
+  /// Duration of a window [s].
+  double windowDuration{0.0};
+  /// Mean and maximum lateness in the window [ns].
+  double meanLatenessNs{0.0};
+  double maxLatenessNs{0.0};
+  /// Median spectral amplitude [ns].
+  double noiseFloorNs{0.0};
+  /// Periodic components, strongest first.
+  std::vector<PeriodicComponent> components;
+
+  /*!
+   * Human readable report, e.g. for logging.
+   */
+  std::string toString() const;
+};
+
+/*!
+ * Streaming periodicity analysis of the cycle lateness, to find periodic interference (SMIs, cron jobs, interrupt
+ * storms) which disappears in averages. The update thread adds one sample per cycle through a lock-free queue. A low
+ * priority analysis thread collects windows of samples and runs a Goertzel filter per DFT bin over every window (Hann
+ * window). The periods are found in the autocorrelation computed from this spectrum, which also catches short spikes
+ * whose energy is spread over many harmonics: the strongest periodic component is taken, its harmonics are removed from
+ * the spectrum and the search is repeated. Periods between 2 cycles and half the window are resolved.
+ */
+class PeriodicityDetector {
+ public:
+  PeriodicityDetector() = default;
+  ~PeriodicityDetector();
+
+  PeriodicityDetector(const PeriodicityDetector&) = delete;
+  PeriodicityDetector& operator=(const PeriodicityDetector&) = delete;
+
+  /*!
+   * Start the analysis thread.
+   * @param[in] windowCycles samples per analysed window, at least 2 periods of the slowest interference of interest.
+   */
+  void start(unsigned int windowCycles);
+
+  /*!
+   * Stop and join the analysis thread, the last report is kept.
+   */
+  void stop();
+
+  bool isRunning() const { return running_; }
+
+  /*!
+   * Called by the update thread once per cycle while running, never blocks.
+   * @param[in] cycleStartNs start of the cycle, CLOCK_MONOTONIC [ns].
+   * @param[in] latenessNs lateness of the cycle start [ns].
+   */
+  void addSample(int64_t cycleStartNs, int64_t latenessNs) {
+    if (!queue_->push(Sample{cycleStartNs, latenessNs})) {
+      droppedSamples_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /*!
+   * Returns the analysis of the last complete window. Thread safe.
+   */
+  PeriodicityReport getReport() const;
+
+ protected:
+  struct Sample {
+    int64_t cycleStartNs{0};
+    int64_t latenessNs{0};
+  };
+
+  void analyse();
+  void analyseWindow();
+
+  unsigned int windowCycles_{0};
+  std::unique_ptr<SpscQueue<Sample>> queue_;
+  std::atomic<uint64_t> droppedSamples_{0};
+
+  // owned by the analysis thread.
+  std::vector<int64_t> cycleStarts_;
+  std::vector<double> lateness_;
+  std::vector<double> hannWindow_;
+  std::vector<double> amplitudes_;
+
+  mutable std::mutex reportMutex_;
+  PeriodicityReport report_;
+
+  std::thread analysisThread_;
+  std::atomic<bool> running_{false};
+};
+
+}  // namespace ecat_master
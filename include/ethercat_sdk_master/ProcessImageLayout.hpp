@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Location of the process data of a single slave in the logical process image.
+ */
+struct ProcessImageEntry {
+  uint16_t slave{0};
+  std::string name;
+
+  /// Offsets relative to the start of the process image [bytes].
+  uint32_t outputOffset{0};
+  uint32_t outputBytes{0};
+  /// First bit inside the first byte, non zero for bit oriented slaves.
+  uint8_t outputStartBit{0};
+  uint32_t inputOffset{0};
+  uint32_t inputBytes{0};
+  uint8_t inputStartBit{0};
+
+  /// Frame (SOEM IO segment) carrying the first byte of the outputs and inputs.
+  unsigned int outputFrame{0};
+  unsigned int inputFrame{0};
+  /// The outputs or inputs are split over two frames.
+  bool crossesFrame{false};
+};
+
+/*!
+ * Layout of the logical process image of the bus.
+ */
+struct ProcessImageLayout {
+  std::vector<ProcessImageEntry> entries;
+  uint32_t outputBytes{0};
+  uint32_t inputBytes{0};
+  unsigned int frames{0};
+  /// Inputs and outputs are exchanged with separate LRD / LWR datagrams instead of a single LRW.
+  bool blockLRW{false};
+  /// Number of slaves which cannot be accessed with LRW.
+  unsigned int slavesBlockingLRW{0};
+
+  /*!
+   * Human readable table of the layout, e.g. for logging.
+   */
+  std::string toString() const;
+};
+
+/*!
+ * Contiguous bytes of the process image which are moved as a whole: the outputs or the inputs of a slave, or of several
+ * bit oriented slaves sharing bytes.
+ */
+struct ProcessImageBlock {
+  bool input{false};
+  /// Offset in the current image and size [bytes].
+  uint32_t offset{0};
+  uint32_t size{0};
+  /// Accessed by a hot device: grouped at the start of the outputs or inputs.
+  bool hot{false};
+  /// Offset in the planned image [bytes].
+  uint32_t plannedOffset{0};
+};
+
+/*!
+ * Planned process image: outputs first, followed by the inputs, as mapped by SOEM.
+ */
+struct ProcessImagePlan {
+  std::vector<ProcessImageBlock> blocks;
+  uint32_t outputBytes{0};
+  uint32_t inputBytes{0};
+  /// Sizes of the frames (SOEM IO segments), the inputs start in frame inputFrame at inputFrameOffset.
+  std::vector<uint32_t> frames;
+  unsigned int inputFrame{0};
+  uint32_t inputFrameOffset{0};
+};
+
+/*!
+ * Plan the layout of the process image. The blocks of hot devices come first in the outputs and in the inputs, the others
+ * keep their order. With align every block starts on its natural boundary (its size rounded up to a power of two, at
+ * most 8 bytes) and the inputs start on a cache line. Frames are split at block boundaries.
+ * @param[in] blocks blocks of the current image.
+ * @param[in] align pad the blocks to natural boundaries and the inputs to a cache line.
+ * @param[in] maxFrameSize largest process data per frame [bytes].
+ * @param[in] capacity size of the process image memory [bytes].
+ * @param[out] plan planned layout.
+ * @return false if a block does not fit into a frame or the image does not fit into the memory.
+ */
+bool planProcessImageLayout(const std::vector<ProcessImageBlock>& blocks, bool align, uint32_t maxFrameSize, uint32_t capacity,
+                            ProcessImagePlan& plan);
+
+}  // namespace ecat_master
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ethercat_sdk_master/BusTopology.hpp"
+
+#include <string>
+
+namespace ecat_master {
+
+/*!
+ * State of the cable redundancy (ring topology over a primary and a secondary NIC).
+ */
+struct RedundancyState {
+  /// Frames are sent on both NICs and merged by SOEM.
+  bool enabled{false};
+  /// A link of the ring is broken, the slaves behind the break are reached via the secondary NIC.
+  bool lineBreak{false};
+  /// Broken link, slave 0 stands for the master NIC (primary if upstream, secondary if downstream).
+  PortLink breakLink{};
+  /// Human readable description, e.g. for logging.
+  std::string description;
+
+  bool operator==(const RedundancyState& o) const {
+    return o.enabled == enabled && o.lineBreak == lineBreak && o.breakLink.upstream.slave == breakLink.upstream.slave &&
+           o.breakLink.upstream.port == breakLink.upstream.port && o.breakLink.downstream.slave == breakLink.downstream.slave &&
+           o.breakLink.downstream.port == breakLink.downstream.port;
+  }
+  bool operator!=(const RedundancyState& o) const { return !(o == *this); }
+};
+
+}  // namespace ecat_master
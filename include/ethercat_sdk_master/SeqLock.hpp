@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ecat_master {
+
+/*!
+ * Sequence lock publishing a trivially copyable value from a single writer thread to any number of readers.
+ * store() never blocks or allocates, which makes it usable from the update thread. load() retries while a store is in
+ * progress. The value is kept in relaxed atomic words, so a torn read is detected by the sequence instead of being a data race.
+ */
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+ public:
+  SeqLock() { store(T{}); }
+
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+
+  /*!
+   * Writer: publish a new value.
+   */
+  void store(const T& value) {
+    std::array<uint64_t, words> buffer{};
+    std::memcpy(buffer.data(), &value, sizeof(T));
+    const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < words; i++) {
+      data_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  /*!
+   * Reader: the latest published value.
+   */
+  T load() const {
+    std::array<uint64_t, words> buffer{};
+    uint64_t before = 0;
+    uint64_t after = 0;
+    do {
+      before = sequence_.load(std::memory_order_acquire);
+      for (size_t i = 0; i < words; i++) {
+        buffer[i] = data_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence_.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    T value;
+    std::memcpy(static_cast<void*>(&value), buffer.data(), sizeof(T));
+    return value;
+  }
+
+ private:
+  static constexpr size_t words{(sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t)};
+
+  // odd while a store is in progress.
+  std::atomic<uint64_t> sequence_{0};
+  std::array<std::atomic<uint64_t>, words> data_{};
+};
+
+}  // namespace ecat_master
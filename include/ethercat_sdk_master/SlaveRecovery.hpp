@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace ecat_master {
+
+/*!
+ * Recovery attempts of a single slave by the EthercatMaster slave recovery.
+ */
+struct SlaveRecoveryStatistics {
+  /// Segment of the slave, 1 for the second segment of a split bus.
+  unsigned int segment{0};
+  uint16_t slave{0};
+  std::string name;
+  uint64_t attempts{0};
+  uint64_t successes{0};
+  bool lastAttemptSucceeded{false};
+  std::chrono::time_point<std::chrono::system_clock> lastAttempt{};
+  /// Duration of the last successful recovery, from the first datagram to OPERATIONAL.
+  std::chrono::milliseconds lastRecoveryDuration{0};
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * AL status (EtherCAT state incl. error flag 0x10) and AL status code of a single slave.
+ */
+struct SlaveAlStatus {
+  uint16_t state{0};
+  uint16_t alStatusCode{0};
+
+  bool operator==(const SlaveAlStatus& o) const { return o.state == state && o.alStatusCode == alStatusCode; }
+  bool operator!=(const SlaveAlStatus& o) const { return !(o == *this); }
+};
+
+/*!
+ * Timestamped AL status of a slave.
+ */
+struct SlaveStateSample {
+  std::chrono::system_clock::time_point stamp;
+  SlaveAlStatus status;
+};
+
+/*!
+ * Returns a readable representation of an AL state, e.g. "SAFE_OP + ERROR".
+ */
+std::string alStateToString(uint16_t state);
+
+/*!
+ * Keeps the current AL status and a bounded history of state changes for every slave on the bus.
+ * update() is called from a single thread (the slave state monitor of the EthercatMaster), the getters are thread safe.
+ */
+class SlaveStateTracker {
+ public:
+  /*!
+   * @param[in] historyLength number of state changes kept per slave.
+   */
+  explicit SlaveStateTracker(size_t historyLength = 32) : historyLength_(historyLength) {}
+
+  /*!
+   * Drop all states and histories and prepare for the given number of slaves.
+   */
+  void reset(size_t numberOfSlaves);
+
+  /*!
+   * Record the AL status of all slaves, states[i] belongs to the slave at bus position i + 1.
+   * Only changes are added to the history.
+   * @return bus positions of the slaves whose status changed.
+   */
+  std::vector<uint16_t> update(const std::vector<SlaveAlStatus>& states, std::chrono::system_clock::time_point stamp);
+
+  /*!
+   * Latest status of every slave, index i belongs to the slave at bus position i + 1.
+   */
+  std::vector<SlaveStateSample> getCurrentStates() const;
+
+  /*!
+   * Latest status of the slave at the given bus position.
+   */
+  SlaveStateSample getCurrentState(uint16_t slave) const;
+
+  /*!
+   * State changes of the slave at the given bus position, oldest first.
+   */
+  std::vector<SlaveStateSample> getHistory(uint16_t slave) const;
+
+  /*!
+   * Stamp of the latest update(), also if no state changed. Default constructed before the first update.
+   */
+  std::chrono::system_clock::time_point getLastUpdate() const;
+
+ private:
+  size_t historyLength_;
+  mutable std::mutex mutex_;
+  std::vector<SlaveStateSample> current_;
+  // ring buffers of historyLength_ entries per slave
+  std::vector<std::vector<SlaveStateSample>> history_;
+  std::vector<size_t> historyHead_;
+  std::vector<size_t> historySize_;
+  std::chrono::system_clock::time_point lastUpdate_{};
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Bounded lock-free queue for a single producer and a single consumer thread.
+ * The storage is allocated in the constructor, push() and pop() never allocate or block, which makes the queue
+ * usable from the update thread.
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  /*!
+   * @param[in] capacity number of elements, rounded up to a power of two.
+   */
+  explicit SpscQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size *= 2;
+    }
+    buffer_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  /*!
+   * Producer: append an element.
+   * @return false if the queue is full, the element is dropped.
+   */
+  bool push(const T& value) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) > mask_) {
+      return false;
+    }
+    buffer_[head & mask_] = value;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /*!
+   * Consumer: remove the oldest element.
+   * @return false if the queue is empty.
+   */
+  bool pop(T& value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = buffer_[tail & mask_];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const { return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire); }
+
+  size_t capacity() const { return buffer_.size(); }
+
+ private:
+  std::vector<T> buffer_;
+  size_t mask_{0};
+  // producer and consumer index on separate cache lines.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace ecat_master
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <pthread.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Information about a stalled update thread.
+ */
+struct StallReport {
+  /// Heartbeats received before the stall.
+  uint64_t heartbeats{0};
+  /// Time since the last heartbeat when the stall was detected.
+  std::chrono::nanoseconds stallDuration{0};
+  /// Stack of the stalled thread, innermost frame first. Empty if it could not be captured, frames of code built
+  /// without frame pointers are missing.
+  std::vector<std::string> backtrace;
+  /// Additional state of the owner, e.g. the cycle statistics of the EthercatMaster.
+  std::string state;
+
+  /*!
+   * Human readable report, e.g. for logging.
+   */
+  std::string toString() const;
+};
+
+/*!
+ * Detects a stalled update thread, e.g. a deadlocked device, long before the SM watchdogs of the slaves trip.
+ * The monitored thread calls heartbeat() once per cycle (a relaxed atomic increment). A low priority monitor thread
+ * checks the heartbeat every timeout / 4 and reports a stall once the heartbeat did not change for longer than timeout:
+ * it captures the stack of the monitored thread (by signalling it), collects the state of the owner and calls the
+ * stall callback. A stall is reported once, the watchdog rearms with the next heartbeat. The watchdog is disarmed
+ * when the monitored thread exits, the next heartbeat of another thread arms it again.
+ */
+class StallWatchdog {
+ public:
+  using StateCallback = std::function<std::string()>;
+  using StallCallback = std::function<void(const StallReport&)>;
+
+  StallWatchdog() = default;
+  ~StallWatchdog();
+
+  StallWatchdog(const StallWatchdog&) = delete;
+  StallWatchdog& operator=(const StallWatchdog&) = delete;
+
+  /*!
+   * Start the monitor thread. The watchdog is armed with the first heartbeat, the monitored thread is the thread
+   * calling heartbeat().
+   * @param[in] timeout time without heartbeat after which a stall is reported.
+   * @param[in] stateCallback collects the state of the owner for the report, called from the monitor thread.
+   * @param[in] stallCallback called from the monitor thread on a stall.
+   */
+  void start(std::chrono::nanoseconds timeout, StateCallback stateCallback, StallCallback stallCallback);
+
+  /*!
+   * Stop and join the monitor thread.
+   */
+  void stop();
+
+  bool isRunning() const { return running_; }
+
+  /*!
+   * Called by the monitored thread once per cycle.
+   */
+  void heartbeat() {
+    if (!armed_->load(std::memory_order_relaxed)) {
+      arm();
+    }
+    heartbeats_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /*!
+   * Number of stalls detected since start().
+   */
+  uint64_t getStallCount() const { return stalls_; }
+
+ protected:
+  /*!
+   * Monitor the calling thread, disarms the watchdog again when the thread exits.
+   */
+  void arm();
+  void monitor();
+  std::vector<std::string> captureBacktrace();
+
+  std::chrono::nanoseconds timeout_{0};
+  StateCallback stateCallback_;
+  StallCallback stallCallback_;
+
+  std::thread monitorThread_;
+  std::mutex monitorMutex_;
+  std::atomic<bool> running_{false};
+  // shared with the exit handler of the monitored thread, which may outlive the watchdog.
+  std::shared_ptr<std::atomic<bool>> armed_{std::make_shared<std::atomic<bool>>(false)};
+  std::atomic<uint64_t> heartbeats_{0};
+  std::atomic<uint64_t> stalls_{0};
+  pthread_t monitoredThread_{};
+};
+
+}  // namespace ecat_master
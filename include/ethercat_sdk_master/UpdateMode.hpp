@@ -28,6 +28,8 @@ namespace ecat_master{
  * - StandaloneEnforceStep:
  *   Create the necessary timeout such that the update time step correspnds to
  *   the target time step. No compensation for updates that took too long.
+ * - ExternalTrigger:
+ *   Wait for an external trigger before the update, see EthercatMaster::setTriggerFd and EthercatMaster::setTrigger.
  */
-enum class UpdateMode {NonStandalone, StandaloneEnforceRate, StandaloneEnforceStep};
+enum class UpdateMode {NonStandalone, StandaloneEnforceRate, StandaloneEnforceStep, ExternalTrigger};
 }
@@ -0,0 +1,281 @@
+#include "ethercat_sdk_master/AcyclicScheduler.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <sstream>
+
+namespace ecat_master {
+
+namespace {
+
+// weight of a new measurement in the expected execution time.
+constexpr double executionTimeFilter{0.2};
+
+// the counters have a single writer, the maxima need no compare exchange.
+void storeMax(std::atomic<long>& maximum, long value) {
+  if (value > maximum.load(std::memory_order_relaxed)) {
+    maximum.store(value, std::memory_order_relaxed);
+  }
+}
+
+long monotonicNs() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+}  // namespace
+
+std::string acyclicPriorityToString(AcyclicPriority priority) {
+  switch (priority) {
+    case AcyclicPriority::Safety:
+      return "safety";
+    case AcyclicPriority::Diagnostics:
+      return "diagnostics";
+    case AcyclicPriority::Parameter:
+      return "parameter";
+    case AcyclicPriority::Size:
+      break;
+  }
+  return "unknown";
+}
+
+AcyclicService::AcyclicService() {
+  fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+}
+
+AcyclicService::~AcyclicService() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool AcyclicService::waitForGrant(long timeoutNs) {
+  const long startNs = monotonicNs();
+  const timespec timeout{timeoutNs / 1000000000L, timeoutNs % 1000000000L};
+  pollfd descriptor{fd_, POLLIN, 0};
+  uint64_t grants = 0;
+  if (fd_ >= 0 && ppoll(&descriptor, 1, &timeout, nullptr) > 0 && read(fd_, &grants, sizeof(grants)) == sizeof(grants)) {
+    return true;
+  }
+  if (fd_ < 0) {
+    nanosleep(&timeout, nullptr);
+  }
+  const long lastScheduledNs = lastScheduledNs_.load(std::memory_order_relaxed);
+  if (lastScheduledNs != 0 && lastScheduledNs >= startNs - timeoutNs) {
+    return false;
+  }
+  // no scheduler: run on its own, unless a grant came in meanwhile.
+  bool busy = false;
+  if (!busy_.compare_exchange_strong(busy, true, std::memory_order_acquire)) {
+    (void)!read(fd_, &grants, sizeof(grants));
+  }
+  return true;
+}
+
+void AcyclicService::finish(long executionNs) {
+  executionNs_.store(executionNs, std::memory_order_release);
+  busy_.store(false, std::memory_order_release);
+}
+
+bool AcyclicService::grant() {
+  bool busy = false;
+  if (!busy_.compare_exchange_strong(busy, true, std::memory_order_acq_rel)) {
+    return false;
+  }
+  if (fd_ >= 0) {
+    const uint64_t value = 1;
+    (void)!write(fd_, &value, sizeof(value));
+  }
+  return true;
+}
+
+void AcyclicScheduler::addTask(const std::string& name, AcyclicPriority priority, unsigned int periodCycles, Task task) {
+  Entry entry;
+  entry.name = name;
+  entry.priority = priority;
+  entry.periodCycles = std::max(periodCycles, 1u);
+  entry.task = std::move(task);
+  tasks_.push_back(std::move(entry));
+}
+
+void AcyclicScheduler::addService(const std::string& name, AcyclicPriority priority, unsigned int periodCycles, AcyclicService& service) {
+  Entry entry;
+  entry.name = name;
+  entry.priority = priority;
+  entry.periodCycles = std::max(periodCycles, 1u);
+  entry.service = &service;
+  tasks_.push_back(std::move(entry));
+}
+
+bool AcyclicScheduler::setPeriod(const std::string& name, unsigned int periodCycles) {
+  bool found = false;
+  for (auto& entry : tasks_) {
+    if (entry.name == name) {
+      entry.periodCycles = std::max(periodCycles, 1u);
+      // a longer countdown than the new period would delay the next run.
+      entry.cycleCount = std::min(entry.cycleCount, entry.periodCycles - 1);
+      found = true;
+    }
+  }
+  return found;
+}
+
+void AcyclicScheduler::clear() {
+  tasks_.clear();
+  resetStatistics();
+}
+
+void AcyclicScheduler::run(long nowNs, long budgetNs) {
+  const bool unlimited = budgetNs < 0;
+  long usedNs = 0;
+  for (auto& entry : tasks_) {
+    if (entry.service != nullptr) {
+      entry.service->lastScheduledNs_.store(nowNs, std::memory_order_relaxed);
+      // the service used the bus since the last cycle, its run is charged to this one.
+      const long executionNs = entry.service->takeExecutionNs();
+      if (executionNs >= 0 && entry.granted) {
+        entry.granted = false;
+        recordExecution(entry, executionNs, entry.admittedNs, unlimited);
+        usedNs += executionNs;
+      }
+      entry.available = !entry.service->busy_.load(std::memory_order_acquire);
+    }
+    if (++entry.cycleCount >= entry.periodCycles) {
+      entry.cycleCount = 0;
+      // a task which is still due keeps its original due time.
+      if (!entry.due) {
+        entry.due = true;
+        entry.dueNs = nowNs;
+      }
+    }
+  }
+
+  long startNs = nowNs;
+  bool first = true;
+  while (true) {
+    // most urgent due task: highest priority, then longest waiting.
+    Entry* next = nullptr;
+    for (auto& entry : tasks_) {
+      if (entry.due && entry.available &&
+          (next == nullptr || entry.priority < next->priority || (entry.priority == next->priority && entry.dueNs < next->dueNs))) {
+        next = &entry;
+      }
+    }
+    if (next == nullptr) {
+      break;
+    }
+    // safety tasks are due first and never deferred.
+    const bool safety = next->priority == AcyclicPriority::Safety;
+    const long remainingNs = budgetNs - usedNs;
+    if (!unlimited && !safety && (remainingNs <= 0 || (!first && next->expectedExecutionNs > static_cast<double>(remainingNs)))) {
+      break;
+    }
+
+    Counters& counters = counters_[static_cast<size_t>(next->priority)];
+    if (next->service != nullptr) {
+      // runs in the service thread, the execution time is charged when it is reported.
+      if (!next->service->grant()) {
+        next->available = false;
+        continue;
+      }
+      next->due = false;
+      next->granted = true;
+      next->admittedNs = remainingNs;
+      counters.executed.fetch_add(1, std::memory_order_relaxed);
+      counters.totalQueueingDelayNs.fetch_add(startNs - next->dueNs, std::memory_order_relaxed);
+      storeMax(counters.maxQueueingDelayNs, startNs - next->dueNs);
+      if (!safety) {
+        first = false;
+      }
+      continue;
+    }
+
+    next->due = false;
+    next->task();
+    const long endNs = monotonicNs();
+    const long executionNs = endNs - startNs;
+    const long queueingDelayNs = startNs - next->dueNs;
+    counters.executed.fetch_add(1, std::memory_order_relaxed);
+    counters.totalQueueingDelayNs.fetch_add(queueingDelayNs, std::memory_order_relaxed);
+    storeMax(counters.maxQueueingDelayNs, queueingDelayNs);
+    recordExecution(*next, executionNs, remainingNs, unlimited);
+    usedNs += executionNs;
+    startNs = endNs;
+    if (!safety) {
+      first = false;
+    }
+  }
+
+  // everything still due waits for the next cycle.
+  for (const auto& entry : tasks_) {
+    if (entry.due) {
+      counters_[static_cast<size_t>(entry.priority)].deferrals.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void AcyclicScheduler::recordExecution(Entry& entry, long executionNs, long remainingNs, bool unlimited) {
+  entry.expectedExecutionNs = entry.expectedExecutionNs > 0.0
+                                  ? entry.expectedExecutionNs + executionTimeFilter * (executionNs - entry.expectedExecutionNs)
+                                  : static_cast<double>(executionNs);
+  Counters& counters = counters_[static_cast<size_t>(entry.priority)];
+  counters.totalExecutionNs.fetch_add(executionNs, std::memory_order_relaxed);
+  storeMax(counters.maxExecutionNs, executionNs);
+  if (!unlimited && executionNs > remainingNs) {
+    counters.budgetOverruns.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+std::array<AcyclicStatistics, static_cast<size_t>(AcyclicPriority::Size)> AcyclicScheduler::getStatistics() const {
+  std::array<AcyclicStatistics, static_cast<size_t>(AcyclicPriority::Size)> statistics{};
+  for (size_t priority = 0; priority < statistics.size(); priority++) {
+    const Counters& counters = counters_[priority];
+    AcyclicStatistics& entry = statistics[priority];
+    entry.executed = counters.executed.load(std::memory_order_relaxed);
+    entry.deferrals = counters.deferrals.load(std::memory_order_relaxed);
+    if (entry.executed > 0) {
+      entry.meanQueueingDelayNs =
+          static_cast<double>(counters.totalQueueingDelayNs.load(std::memory_order_relaxed)) / static_cast<double>(entry.executed);
+      entry.meanExecutionNs = static_cast<double>(counters.totalExecutionNs.load(std::memory_order_relaxed)) / static_cast<double>(entry.executed);
+    }
+    entry.maxQueueingDelayNs = counters.maxQueueingDelayNs.load(std::memory_order_relaxed);
+    entry.maxExecutionNs = counters.maxExecutionNs.load(std::memory_order_relaxed);
+    entry.budgetOverruns = counters.budgetOverruns.load(std::memory_order_relaxed);
+  }
+  return statistics;
+}
+
+void AcyclicScheduler::resetStatistics() {
+  for (auto& counters : counters_) {
+    counters.executed = 0;
+    counters.deferrals = 0;
+    counters.totalQueueingDelayNs = 0;
+    counters.maxQueueingDelayNs = 0;
+    counters.totalExecutionNs = 0;
+    counters.maxExecutionNs = 0;
+    counters.budgetOverruns = 0;
+  }
+}
+
+std::string AcyclicScheduler::statisticsToString() const {
+  const auto statistics = getStatistics();
+  std::stringstream ss;
+  for (size_t priority = 0; priority < statistics.size(); priority++) {
+    const AcyclicStatistics& entry = statistics[priority];
+    if (priority > 0) {
+      ss << "\n";
+    }
+    ss << acyclicPriorityToString(static_cast<AcyclicPriority>(priority)) << ": executed: " << entry.executed
+       << ", deferrals: " << entry.deferrals << ", queueing delay: " << entry.meanQueueingDelayNs / 1e3 << "us (max "
+       << entry.maxQueueingDelayNs / 1e3 << "us), execution: " << entry.meanExecutionNs / 1e3 << "us (max " << entry.maxExecutionNs / 1e3
+       << "us), budget overruns: " << entry.budgetOverruns;
+  }
+  return ss.str();
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,117 @@
+#include "ethercat_sdk_master/BusCapacity.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace ecat_master {
+
+namespace {
+
+// 100BASE-TX
+constexpr double nsPerByte{80.0};
+// preamble + SFD, Ethernet header, FCS and inter frame gap
+constexpr uint32_t ethernetOverhead{8 + 14 + 4 + 12};
+constexpr uint32_t minEthernetPayload{46};
+constexpr uint32_t ethercatHeader{2};
+// datagram header and working counter
+constexpr uint32_t datagramOverhead{10 + 2};
+// maximal process data per datagram (EC_MAXLRWDATA)
+constexpr uint32_t maxDatagramData{1486};
+// FRMW of the DC system time
+constexpr uint32_t dcDatagram{datagramOverhead + 8};
+// typical forwarding delay of an ESC with two ports, both directions incl. cable
+constexpr double slaveDelayNs{1000.0};
+// upper limit for the projection of additional slaves
+constexpr unsigned int maxProjectedSlaves{1000};
+
+struct WireModel {
+  unsigned int frames{0};
+  double wireTimeNs{0.0};
+};
+
+WireModel modelWire(uint32_t outputBytes, uint32_t inputBytes, unsigned int frames, bool blockLRW, bool hasDc) {
+  const uint32_t data = outputBytes + inputBytes;
+  const auto requiredFrames = static_cast<unsigned int>((data + maxDatagramData - 1) / maxDatagramData);
+  WireModel model;
+  model.frames = std::max({frames, requiredFrames, 1u});
+  // blockLRW exchanges inputs and outputs with separate LRD and LWR datagrams
+  const unsigned int datagrams = model.frames * (blockLRW ? 2 : 1);
+  const double payload =
+      static_cast<double>(ethercatHeader * model.frames + datagramOverhead * datagrams + data + (hasDc ? dcDatagram : 0));
+  const double payloadPerFrame = std::max(payload / model.frames, static_cast<double>(minEthernetPayload));
+  model.wireTimeNs = model.frames * (payloadPerFrame + ethernetOverhead) * nsPerByte;
+  return model;
+}
+
+}  // namespace
+
+BusCapacityEstimate estimateBusCapacity(const ProcessImageInfo& image, const CycleStatistics& statistics, double cycleTimeNs,
+                                        unsigned int additionalSlaves, uint32_t rxPdoSize, uint32_t txPdoSize) {
+  BusCapacityEstimate estimate;
+  estimate.image = image;
+  estimate.cycleTimeNs = cycleTimeNs;
+  estimate.additionalSlaves = additionalSlaves;
+
+  const WireModel wire = modelWire(image.outputBytes, image.inputBytes, image.frames, image.blockLRW, image.hasDc);
+  estimate.image.frames = wire.frames;
+  estimate.wireTimeNs = wire.wireTimeNs;
+  // the frame passes every slave twice, the DC propagation delay covers the way to the last slave only
+  estimate.loopDelayNs =
+      image.propagationDelayNs > 0 ? 2.0 * static_cast<double>(image.propagationDelayNs) : slaveDelayNs * image.slaves;
+  const double perSlaveDelayNs = image.slaves > 0 ? estimate.loopDelayNs / image.slaves : slaveDelayNs;
+  estimate.estimatedRoundtripNs = estimate.wireTimeNs + estimate.loopDelayNs;
+
+  const bool measured = statistics.cycles > 0;
+  if (measured) {
+    estimate.measuredRoundtripNs = statistics.meanRoundtripNs;
+    estimate.maxMeasuredRoundtripNs = static_cast<double>(statistics.maxRoundtripNs);
+    estimate.recentRoundtripP99Ns = static_cast<double>(statistics.recentRoundtripP99Ns);
+  }
+  // a single outlier since startup, e.g. while another process started, does not limit the cycle time.
+  estimate.minCycleTimeNs = estimate.recentRoundtripP99Ns > 0.0 ? estimate.recentRoundtripP99Ns : estimate.estimatedRoundtripNs;
+  if (cycleTimeNs > 0.0) {
+    estimate.busUtilisation = estimate.wireTimeNs / cycleTimeNs;
+    estimate.headroom = 1.0 - estimate.minCycleTimeNs / cycleTimeNs;
+  }
+
+  // projections are relative to the current state, so the master latency contained in the measurement is kept.
+  auto projectMinCycleTime = [&](unsigned int slaves) {
+    const WireModel projectedWire = modelWire(image.outputBytes + slaves * rxPdoSize, image.inputBytes + slaves * txPdoSize, image.frames,
+                                              image.blockLRW, image.hasDc);
+    const double projectedRoundtrip = projectedWire.wireTimeNs + estimate.loopDelayNs + perSlaveDelayNs * slaves;
+    return estimate.minCycleTimeNs + projectedRoundtrip - estimate.estimatedRoundtripNs;
+  };
+  estimate.projectedMinCycleTimeNs = projectMinCycleTime(additionalSlaves);
+  if (cycleTimeNs > 0.0) {
+    estimate.projectedHeadroom = 1.0 - estimate.projectedMinCycleTimeNs / cycleTimeNs;
+    while (estimate.maxAdditionalSlaves < maxProjectedSlaves && projectMinCycleTime(estimate.maxAdditionalSlaves + 1) <= cycleTimeNs) {
+      estimate.maxAdditionalSlaves++;
+    }
+  }
+  return estimate;
+}
+
+std::string BusCapacityEstimate::toString() const {
+  std::stringstream ss;
+  ss << "Slaves: " << image.slaves << ", process image: " << image.outputBytes << " bytes out / " << image.inputBytes
+     << " bytes in, frames: " << image.frames << (image.hasDc ? " (DC)" : "") << "\n";
+  ss << "Wire time: " << wireTimeNs / 1e3 << "us, loop delay: " << loopDelayNs / 1e3
+     << "us, estimated roundtrip: " << estimatedRoundtripNs / 1e3 << "us";
+  if (measuredRoundtripNs > 0.0) {
+    ss << ", measured roundtrip: " << measuredRoundtripNs / 1e3 << "us (recent 99%: " << recentRoundtripP99Ns / 1e3 << "us, max "
+       << maxMeasuredRoundtripNs / 1e3 << "us)";
+  }
+  ss << "\n";
+  ss << "Cycle time: " << cycleTimeNs / 1e3 << "us, min. cycle time: " << minCycleTimeNs / 1e3
+     << "us, bus utilisation: " << std::round(busUtilisation * 1000.0) / 10.0 << "%, headroom: " << std::round(headroom * 1000.0) / 10.0
+     << "%";
+  if (additionalSlaves > 0) {
+    ss << "\nWith " << additionalSlaves << " additional slaves: min. cycle time: " << projectedMinCycleTimeNs / 1e3
+       << "us, headroom: " << std::round(projectedHeadroom * 1000.0) / 10.0 << "%";
+  }
+  ss << "\nAdditional slaves fitting into the cycle: " << maxAdditionalSlaves;
+  return ss.str();
+}
+
+}  // namespace ecat_master
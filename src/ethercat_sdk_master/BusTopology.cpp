@@ -0,0 +1,130 @@
+#include "ethercat_sdk_master/BusTopology.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr size_t numberOfPorts{PortErrorCounters::numberOfPorts};
+
+// RX error counter registers hold the invalid frame counter in the low byte and the physical layer error counter in the high byte.
+uint32_t rxErrors(uint16_t fullValue) {
+  return static_cast<uint32_t>(fullValue & 0xff) + static_cast<uint32_t>(fullValue >> 8);
+}
+
+std::string endpointName(const PortEndpoint& endpoint) {
+  if (endpoint.slave == 0) {
+    return "master NIC";
+  }
+  return "slave " + std::to_string(endpoint.slave) + " port " + std::to_string(endpoint.port);
+}
+
+}  // namespace
+
+int BusTopology::linkAt(uint16_t slave, uint8_t port) const {
+  for (size_t i = 0; i < links.size(); i++) {
+    const auto& link = links[i];
+    if ((link.upstream.slave == slave && link.upstream.port == port) || (link.downstream.slave == slave && link.downstream.port == port)) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void LinkFaultLocalizer::setTopology(const BusTopology& topology) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  topology_ = topology;
+  upstreamScore_.assign(topology_.links.size(), 0.0);
+  downstreamScore_.assign(topology_.links.size(), 0.0);
+  lastCounters_.clear();
+  estimate_ = LinkFaultEstimate{};
+}
+
+void LinkFaultLocalizer::update(const std::vector<PortErrorCounters>& counters) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (topology_.links.empty()) {
+    return;
+  }
+
+  for (size_t i = 0; i < topology_.links.size(); i++) {
+    upstreamScore_[i] *= decay_;
+    downstreamScore_[i] *= decay_;
+  }
+
+  // the first set of counters only serves as baseline, the counters might have been running for a while.
+  const bool hasBaseline = lastCounters_.size() == counters.size();
+  if (!hasBaseline) {
+    lastCounters_.assign(counters.size(), std::vector<uint32_t>(numberOfPorts, 0));
+  }
+
+  for (size_t slaveIndex = 0; slaveIndex < counters.size(); slaveIndex++) {
+    const auto slave = static_cast<uint16_t>(slaveIndex + 1);
+    for (size_t port = 0; port < numberOfPorts; port++) {
+      const uint32_t count = rxErrors(counters[slaveIndex].rxErrors[port]) + counters[slaveIndex].lostLinks[port];
+      // the counters saturate and might be cleared by a third party, a decrease is treated as restart from zero.
+      const uint32_t last = lastCounters_[slaveIndex][port];
+      const uint32_t delta = count >= last ? count - last : count;
+      lastCounters_[slaveIndex][port] = count;
+      if (!hasBaseline || delta == 0) {
+        continue;
+      }
+
+      const int linkIndex = topology_.linkAt(slave, static_cast<uint8_t>(port));
+      if (linkIndex < 0) {
+        continue;
+      }
+      if (topology_.links[linkIndex].upstream.slave == slave) {
+        upstreamScore_[linkIndex] += delta;
+      } else {
+        downstreamScore_[linkIndex] += delta;
+      }
+    }
+  }
+
+  double totalScore = 0.0;
+  size_t worstLink = 0;
+  for (size_t i = 0; i < topology_.links.size(); i++) {
+    const double score = upstreamScore_[i] + downstreamScore_[i];
+    totalScore += score;
+    if (score > upstreamScore_[worstLink] + downstreamScore_[worstLink]) {
+      worstLink = i;
+    }
+  }
+
+  const double worstScore = upstreamScore_[worstLink] + downstreamScore_[worstLink];
+  if (worstScore < reportThreshold_) {
+    estimate_ = LinkFaultEstimate{};
+    return;
+  }
+
+  const auto& link = topology_.links[worstLink];
+  estimate_.valid = true;
+  estimate_.link = link;
+  estimate_.score = worstScore;
+  estimate_.confidence = worstScore / totalScore;
+  // errors on the weaker side below 10% of the stronger side are considered as noise.
+  const double weakerSide = std::min(upstreamScore_[worstLink], downstreamScore_[worstLink]);
+  estimate_.bothDirections = weakerSide > 0.1 * worstScore;
+
+  std::stringstream description;
+  description << "link " << endpointName(link.upstream) << " <-> " << endpointName(link.downstream) << ": ";
+  if (estimate_.bothDirections) {
+    description << "errors in both directions, check the cable and both connectors";
+  } else if (upstreamScore_[worstLink] > downstreamScore_[worstLink]) {
+    description << "receive errors on " << endpointName(link.upstream) << ", check its connector or the transmitter of "
+                << endpointName(link.downstream);
+  } else {
+    description << "receive errors on " << endpointName(link.downstream) << ", check its connector or the transmitter of "
+                << endpointName(link.upstream);
+  }
+  estimate_.description = description.str();
+}
+
+LinkFaultEstimate LinkFaultLocalizer::getEstimate() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return estimate_;
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,32 @@
+#include "ethercat_sdk_master/CycleTimeAutotuner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace ecat_master {
+
+std::string AutotuneResult::toString() const {
+  if (!error.empty()) {
+    return "Autotuning refused: " + error;
+  }
+  std::stringstream ss;
+  for (const auto& step : steps) {
+    ss << "Time step " << step.timeStep * 1e6 << "us: " << (step.passed ? "passed" : "failed") << ", overruns: " << step.overruns << "/"
+       << step.cycles << ", roundtrip: " << step.meanRoundtripNs / 1e3 << "us (max " << step.maxRoundtripNs / 1e3
+       << "us), working counter errors: " << step.workingCounterErrors;
+    if (step.maxDcSyncErrorNs >= 0) {
+      ss << ", DC sync error: " << step.maxDcSyncErrorNs << "ns";
+    }
+    ss << "\n";
+  }
+  if (success) {
+    ss << "Shortest safe time step: " << shortestSafeTimeStep * 1e6 << "us, recommended: " << recommendedTimeStep * 1e6 << "us"
+       << (applied ? " (applied)" : "");
+  } else {
+    ss << "No safe time step found";
+  }
+  return ss.str();
+}
+
+}  // namespace ecat_master
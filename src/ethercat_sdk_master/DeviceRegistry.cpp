@@ -0,0 +1,49 @@
+#include "ethercat_sdk_master/DeviceRegistry.hpp"
+
+#include <typeinfo>
+
+namespace ecat_master {
+
+size_t DeviceRegistry::add(const EthercatDevice::SharedPtr& device, unsigned int segment) {
+  const size_t index = devices_.size();
+  if (!nameIndex_.emplace(device->getName(), index).second) {
+    return npos;
+  }
+  devices_.push_back(device);
+  segments_.push_back(segment);
+  if (addressIndex_.size() <= segment) {
+    addressIndex_.resize(segment + 1);
+  }
+  auto& addresses = addressIndex_[segment];
+  const uint32_t address = device->getAddress();
+  if (addresses.size() <= address) {
+    addresses.resize(address + 1);
+  }
+  addresses[address].push_back(index);
+  const EthercatDevice& typed = *device;
+  typeIndex_[std::type_index(typeid(typed))].push_back(index);
+  return index;
+}
+
+void DeviceRegistry::clear() {
+  devices_.clear();
+  segments_.clear();
+  nameIndex_.clear();
+  addressIndex_.clear();
+  typeIndex_.clear();
+}
+
+size_t DeviceRegistry::find(const std::string& name) const {
+  const auto entry = nameIndex_.find(name);
+  return entry == nameIndex_.end() ? npos : entry->second;
+}
+
+const std::vector<size_t>& DeviceRegistry::findAt(unsigned int segment, uint32_t address) const {
+  static const std::vector<size_t> none;
+  if (segment >= addressIndex_.size() || address >= addressIndex_[segment].size()) {
+    return none;
+  }
+  return addressIndex_[segment][address];
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,18 @@
+#include "ethercat_sdk_master/EmergencyMessage.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+namespace ecat_master {
+
+std::string EmergencyMessage::toString() const {
+  std::stringstream ss;
+  ss << std::hex << std::setfill('0') << "error code: 0x" << std::setw(4) << errorCode << ", error register: 0x" << std::setw(2)
+     << static_cast<unsigned int>(errorRegister) << ", data:";
+  for (const auto byte : data) {
+    ss << " " << std::setw(2) << static_cast<unsigned int>(byte);
+  }
+  return ss.str();
+}
+
+}  // namespace ecat_master
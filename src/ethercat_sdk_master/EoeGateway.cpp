@@ -0,0 +1,205 @@
+#include "ethercat_sdk_master/EoeGateway.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+#include <fcntl.h>
+#include <linux/if_tun.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+namespace ecat_master {
+
+namespace {
+
+int openTap(const std::string& name) {
+  const int fd = ::open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+  if (fd < 0) {
+    return -1;
+  }
+  ifreq request{};
+  request.ifr_flags = IFF_TAP | IFF_NO_PI;
+  std::strncpy(request.ifr_name, name.c_str(), IFNAMSIZ - 1);
+  if (ioctl(fd, TUNSETIFF, &request) < 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+std::string EoeStatistics::toString() const {
+  std::stringstream ss;
+  ss << "tx: " << txFrames << " frames, " << txBytes << " bytes, " << txFragments << " fragments, " << droppedTxFrames << " dropped; "
+     << "rx: " << rxFrames << " frames, " << rxBytes << " bytes, " << rxFragments << " fragments, " << droppedRxFrames << " dropped; "
+     << "queued: " << queuedFrames << " (max " << maxQueuedFrames << "), throttled cycles: " << throttledCycles;
+  return ss.str();
+}
+
+EoeGateway::~EoeGateway() {
+  close();
+}
+
+unsigned int EoeGateway::open(EthercatBus& bus, const std::string& interfacePrefix) {
+  close();
+  bus_ = &bus;
+  for (const auto slave : bus.getEoeSlaves()) {
+    const std::string name = interfacePrefix + std::to_string(slave);
+    Tunnel tunnel;
+    tunnel.slave = slave;
+    tunnel.fragmentSize = bus.getEoeFragmentSize(slave);
+    if (tunnel.fragmentSize == 0) {
+      MELO_WARN_STREAM("[EoeGateway] Mailbox of slave " << slave << " too small for EoE, not tunneled.")
+      continue;
+    }
+    tunnel.fd = openTap(name);
+    if (tunnel.fd < 0) {
+      MELO_ERROR_STREAM("[EoeGateway] Cannot create TAP interface " << name << " for slave " << slave << ": " << std::strerror(errno))
+      continue;
+    }
+    tunnel.queue.resize(queueCapacity);
+    tunnels_.push_back(std::move(tunnel));
+    MELO_INFO_STREAM("[EoeGateway] Tunneling slave " << slave << " through " << name << ".")
+  }
+  return static_cast<unsigned int>(tunnels_.size());
+}
+
+void EoeGateway::close() {
+  for (auto& tunnel : tunnels_) {
+    ::close(tunnel.fd);
+  }
+  tunnels_.clear();
+  nextTunnel_ = 0;
+}
+
+void EoeGateway::transmit(size_t budgetBytes) {
+  if (tunnels_.empty()) {
+    return;
+  }
+  // drain the TAP interfaces, the frames which do not fit are dropped.
+  for (auto& tunnel : tunnels_) {
+    Frame overflow;
+    while (true) {
+      Frame& frame = tunnel.queueSize < queueCapacity ? tunnel.queue[(tunnel.queueHead + tunnel.queueSize) % queueCapacity] : overflow;
+      const ssize_t size = ::read(tunnel.fd, frame.data.data(), frame.data.size());
+      if (size <= 0) {
+        break;
+      }
+      if (&frame == &overflow) {
+        droppedTxFrames_.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      frame.size = static_cast<size_t>(size);
+      tunnel.queueSize++;
+    }
+  }
+
+  // a single fragment per cycle, for the next slave with queued frames.
+  for (size_t i = 0; i < tunnels_.size(); i++) {
+    const size_t index = (nextTunnel_ + i) % tunnels_.size();
+    Tunnel& tunnel = tunnels_[index];
+    if (tunnel.queueSize == 0) {
+      continue;
+    }
+    nextTunnel_ = (index + 1) % tunnels_.size();
+    const Frame& frame = tunnel.queue[tunnel.queueHead];
+    const size_t remaining = frame.size - tunnel.txOffset;
+    size_t size = std::min(remaining, tunnel.fragmentSize);
+    if (size > budgetBytes) {
+      // not the last fragment anymore.
+      size = budgetBytes / fragmentAlignment * fragmentAlignment;
+    }
+    if (size > 0 && bus_->sendEoeFragment(tunnel.slave, frame.data.data(), frame.size, tunnel.txOffset, size, tunnel.txFragment,
+                                          tunnel.txFrameNumber)) {
+      tunnel.txOffset += size;
+      tunnel.txFragment++;
+      txFragments_.fetch_add(1, std::memory_order_relaxed);
+      if (tunnel.txOffset == frame.size) {
+        txFrames_.fetch_add(1, std::memory_order_relaxed);
+        txBytes_.fetch_add(frame.size, std::memory_order_relaxed);
+        tunnel.queueHead = (tunnel.queueHead + 1) % queueCapacity;
+        tunnel.queueSize--;
+        tunnel.txOffset = 0;
+        tunnel.txFragment = 0;
+        tunnel.txFrameNumber = static_cast<uint8_t>((tunnel.txFrameNumber + 1) & 0x0f);
+      }
+    }
+    break;
+  }
+
+  size_t queuedFrames = 0;
+  for (const auto& tunnel : tunnels_) {
+    queuedFrames += tunnel.queueSize;
+  }
+  // transmit() is the only writer of the queue statistics.
+  queuedFrames_.store(queuedFrames, std::memory_order_relaxed);
+  if (queuedFrames > maxQueuedFrames_.load(std::memory_order_relaxed)) {
+    maxQueuedFrames_.store(queuedFrames, std::memory_order_relaxed);
+  }
+  if (queuedFrames > 0) {
+    throttledCycles_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool EoeGateway::receive(uint16_t slave, const ec_mbxbuft& mailbox) {
+  ec_mbxheadert header;
+  std::memcpy(&header, mailbox, sizeof(header));
+  if ((header.mbxtype & 0x0f) != ECT_MBXT_EOE) {
+    return false;
+  }
+  const auto tunnel = std::find_if(tunnels_.begin(), tunnels_.end(), [slave](const Tunnel& t) { return t.slave == slave; });
+  if (tunnel == tunnels_.end()) {
+    return false;
+  }
+  uint16 frameInfo1 = 0;
+  std::memcpy(&frameInfo1, mailbox + sizeof(header), sizeof(frameInfo1));
+  if (EOE_HDR_FRAME_TYPE_GET(etohs(frameInfo1)) != EOE_FRAG_DATA) {
+    // e.g. responses to IP parameter requests, not part of the tunneled traffic.
+    return true;
+  }
+
+  ec_mbxbuft fragment;
+  std::memcpy(fragment, mailbox, sizeof(fragment));
+  int size = static_cast<int>(maxFrameSize);
+  const int result = ecx_EOEreadfragment(&fragment, &tunnel->rxFragment, &tunnel->rxFrameSize, &tunnel->rxFrameOffset,
+                                         &tunnel->rxFrameNumber, &size, tunnel->rxFrame.data.data());
+  bool written = false;
+  if (result > 0) {
+    written = ::write(tunnel->fd, tunnel->rxFrame.data.data(), static_cast<size_t>(size)) == size;
+  } else if (result < 0) {
+    tunnel->rxFragment = 0;
+  }
+
+  rxFragments_.fetch_add(1, std::memory_order_relaxed);
+  if (written) {
+    rxFrames_.fetch_add(1, std::memory_order_relaxed);
+    rxBytes_.fetch_add(static_cast<uint64_t>(size), std::memory_order_relaxed);
+  } else if (result != 0) {
+    droppedRxFrames_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+EoeStatistics EoeGateway::getStatistics() const {
+  EoeStatistics statistics;
+  statistics.txFrames = txFrames_.load(std::memory_order_relaxed);
+  statistics.txBytes = txBytes_.load(std::memory_order_relaxed);
+  statistics.txFragments = txFragments_.load(std::memory_order_relaxed);
+  statistics.rxFrames = rxFrames_.load(std::memory_order_relaxed);
+  statistics.rxBytes = rxBytes_.load(std::memory_order_relaxed);
+  statistics.rxFragments = rxFragments_.load(std::memory_order_relaxed);
+  statistics.droppedTxFrames = droppedTxFrames_.load(std::memory_order_relaxed);
+  statistics.droppedRxFrames = droppedRxFrames_.load(std::memory_order_relaxed);
+  statistics.queuedFrames = queuedFrames_.load(std::memory_order_relaxed);
+  statistics.maxQueuedFrames = maxQueuedFrames_.load(std::memory_order_relaxed);
+  statistics.throttledCycles = throttledCycles_.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,1300 @@
+#include "ethercat_sdk_master/EthercatBus.hpp"
+#include "ethercat_sdk_master/EthercatDevice.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+#include <soem_interface_rsl/EthercatSlaveBase.hpp>
+
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr std::chrono::seconds carrierTimeout{5};
+
+bool setInterfaceUp(const std::string& networkInterface, bool up) {
+  const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  ifreq request{};
+  std::strncpy(request.ifr_name, networkInterface.c_str(), IFNAMSIZ - 1);
+  bool success = ioctl(fd, SIOCGIFFLAGS, &request) >= 0;
+  if (success) {
+    if (up) {
+      request.ifr_flags |= IFF_UP;
+    } else {
+      request.ifr_flags &= ~IFF_UP;
+    }
+    success = ioctl(fd, SIOCSIFFLAGS, &request) >= 0;
+  }
+  close(fd);
+  return success;
+}
+
+bool hasCarrier(const std::string& networkInterface) {
+  std::ifstream carrier("/sys/class/net/" + networkInterface + "/carrier");
+  int value = 0;
+  return carrier >> value && value == 1;
+}
+
+int64_t monotonicNs() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// DL status (0x0110): communication established on port n is signalled by bit 9 + 2 * n.
+bool communicationOnPort(uint16_t dlStatus, uint8_t port) {
+  return (dlStatus & (1 << (9 + 2 * port))) != 0;
+}
+
+// RX error counters of port 0-3, 2 bytes each.
+constexpr uint16 escRxErrorCounterRegister{0x0300};
+// lost link counters of port 0-3, 1 byte each.
+constexpr uint16 escLostLinkCounterRegister{0x0310};
+// number of FMMUs supported by the ESC.
+constexpr uint16 escFmmuCountRegister{0x0004};
+// SM status: the mailbox is full.
+constexpr uint8_t mailboxFull{0x08};
+// mapped per slave: the SM0 (mailbox out) status up to the SM1 (mailbox in) status.
+constexpr size_t mailboxStatusSize{ECT_REG_SM1STAT - ECT_REG_SM0STAT + 1};
+// mailbox header and EoE header.
+constexpr size_t eoeHeaderSize{10};
+constexpr size_t eoeFragmentAlignment{32};
+// limit of a single LRD datagram.
+constexpr size_t maxMappedMailboxStatus{1024 / mailboxStatusSize};
+// mailbox header and CoE header, enough to tell the unsolicited mailbox types apart.
+constexpr uint16 mailboxPeekSize{sizeof(ec_mbxheadert) + sizeof(uint16)};
+
+bool isEoe(const ec_mbxbuft& mailbox) {
+  ec_mbxheadert header;
+  std::memcpy(&header, mailbox, sizeof(header));
+  return (header.mbxtype & 0x0f) == ECT_MBXT_EOE;
+}
+
+bool isCoeEmergency(const ec_mbxbuft& mailbox) {
+  ec_mbxheadert header;
+  std::memcpy(&header, mailbox, sizeof(header));
+  uint16 coeHeader = 0;
+  std::memcpy(&coeHeader, mailbox + sizeof(header), sizeof(coeHeader));
+  return (header.mbxtype & 0x0f) == ECT_MBXT_COE && (etohs(coeHeader) >> 12) == ECT_COES_EMERGENCY;
+}
+
+// SOEM calls the FoE hook with the slave only. The hook is set by startup() and runs in the thread of the transfer, which
+// sets the context of its bus, the progress callbacks of all buses are registered by context and slave.
+thread_local const ecx_contextt* foeContext{nullptr};
+std::mutex foeProgressMutex;
+std::map<std::pair<const ecx_contextt*, uint16_t>, EthercatBus::FirmwareProgressCallback> foeProgressCallbacks;
+
+int foeProgressHook(uint16 slave, int /*packetNumber*/, int remainingBytes) {
+  std::lock_guard<std::mutex> lock(foeProgressMutex);
+  const auto callback = foeProgressCallbacks.find({foeContext, slave});
+  if (callback != foeProgressCallbacks.end() && callback->second) {
+    callback->second(static_cast<size_t>(std::max(remainingBytes, 0)));
+  }
+  return 0;
+}
+
+}  // namespace
+
+bool EthercatBus::startup(std::atomic<bool>& abortFlag, const bool sizeCheck, unsigned int maxDiscoverRetries) {
+  // set once before any transfer: the concurrent FoE transfers share the context, the hook dispatches by thread.
+  ecatContext_.FOEhook = foeProgressHook;
+  if (redundantInterface_.empty()) {
+    return EthercatBusBase::startup(abortFlag, sizeCheck, maxDiscoverRetries);
+  }
+
+  // SOEM only discovers and configures an open line, with the secondary interface down the last slave closes its port.
+  if (!setInterfaceUp(redundantInterface_, false)) {
+    MELO_ERROR_STREAM("[EthercatBus::" << name_ << "] Could not set redundant interface " << redundantInterface_
+                                       << " down, CAP_NET_ADMIN is required for cable redundancy.")
+    return false;
+  }
+  const bool success = EthercatBusBase::startup(abortFlag, sizeCheck, maxDiscoverRetries);
+  if (!setInterfaceUp(redundantInterface_, true)) {
+    MELO_ERROR_STREAM("[EthercatBus::" << name_ << "] Could not set redundant interface " << redundantInterface_ << " up.")
+    if (success) {
+      shutdown();
+    }
+    return false;
+  }
+  if (!success) {
+    return false;
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + carrierTimeout;
+  while (!hasCarrier(redundantInterface_)) {
+    if (abortFlag || std::chrono::steady_clock::now() > deadline) {
+      MELO_WARN_STREAM("[EthercatBus::" << name_ << "] No link on redundant interface " << redundantInterface_
+                                        << ", continuing without redundancy.")
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  if (!enableRedundancy()) {
+    shutdown();
+    return false;
+  }
+  return true;
+}
+
+void EthercatBus::updateWrite() {
+  if (sentProcessData_) {
+    MELO_DEBUG_STREAM("[EthercatBus::" << name_ << "] Sending new process data without reading the previous one.")
+  }
+  updatingDevices_.store(true);
+  for (auto& slave : slaves_) {
+    if (!isSlaveRecovering(slave->getAddress())) {
+      slave->updateWrite();
+    }
+  }
+  updatingDevices_.store(false, std::memory_order_release);
+
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  sendTimeNs_ = monotonicNs();
+  ecx_send_processdata(&ecatContext_);
+  updateWriteStamp_ = std::chrono::high_resolution_clock::now();
+  sentProcessData_ = true;
+}
+
+void EthercatBus::updateRead() {
+  if (!sentProcessData_) {
+    MELO_DEBUG_STREAM("[EthercatBus::" << name_ << "] No process data to read.")
+    return;
+  }
+  {
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    wkc_ = ecx_receive_processdata(&ecatContext_, EC_TIMEOUTRET);
+    receiveTimeNs_ = monotonicNs();
+  }
+  updateReadStamp_ = std::chrono::high_resolution_clock::now();
+  sentProcessData_ = false;
+
+  // the slaves only read complete process data.
+  if (!workingCounterIsOk()) {
+    // nothing new for the slaves.
+    for (auto* device : inputChangeDevices_) {
+      device->setInputsChanged(false);
+    }
+    ++workingCounterTooLowCounter_;
+    if (!busIsOk()) {
+      MELO_WARN_THROTTLE_STREAM(1.0, "[EthercatBus::" << name_ << "] Bus is not ok. Too many working counter too low in a row: "
+                                                      << workingCounterTooLowCounter_)
+    }
+    MELO_DEBUG_STREAM("[EthercatBus::" << name_ << "] Working counter too low: " << wkc_.load() << " < " << getExpectedWorkingCounter()
+                                       << ", " << workingCounterTooLowCounter_ << " cycles in a row.")
+    return;
+  }
+  workingCounterTooLowCounter_ = 0;
+  if (!inputChangeDevices_.empty()) {
+    inputChangeDetector_.update();
+    for (size_t i = 0; i < inputChangeDevices_.size(); i++) {
+      inputChangeDevices_[i]->setInputsChanged(inputChangeDetector_.changed(i));
+    }
+  }
+  updatingDevices_.store(true);
+  for (auto& slave : slaves_) {
+    if (!isSlaveRecovering(slave->getAddress())) {
+      slave->updateRead();
+    }
+  }
+  updatingDevices_.store(false, std::memory_order_release);
+}
+
+void EthercatBus::enableInputChangeDetection() {
+  std::vector<InputChangeDetector::Region> regions;
+  inputChangeDevices_.clear();
+  for (const auto& slave : slaves_) {
+    auto* device = dynamic_cast<EthercatDevice*>(slave.get());
+    if (device == nullptr) {
+      continue;
+    }
+    regions.push_back(getInputRegion(static_cast<uint16_t>(device->getAddress())));
+    inputChangeDevices_.push_back(device);
+  }
+  inputChangeDetector_.configure(regions);
+}
+
+bool EthercatBus::enableRedundancy() {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  // ecx_init_redundant opens the primary socket again.
+  close(ecatContext_.port->sockhandle);
+  if (ecx_init_redundant(&ecatContext_, &redundantPort_, name_.c_str(), const_cast<char*>(redundantInterface_.c_str())) <= 0) {
+    MELO_ERROR_STREAM("[EthercatBus::" << name_ << "] Could not open redundant interface " << redundantInterface_)
+    return false;
+  }
+
+  // the port of the last slave with communication which is not part of the discovered line leads to the secondary interface.
+  redundantTopology_ = getTopology();
+  const auto dlStatus = readDlStatus();
+  for (int slave = ecatSlavecount_; slave >= 1; slave--) {
+    for (uint8_t port = 0; port < 4; port++) {
+      if (communicationOnPort(dlStatus[slave - 1], port) && redundantTopology_.linkAt(static_cast<uint16_t>(slave), port) < 0) {
+        secondaryEndpoint_ = PortEndpoint{static_cast<uint16_t>(slave), port};
+        MELO_INFO_STREAM("[EthercatBus::" << name_ << "] Cable redundancy enabled, ring closed at slave " << slave << " port "
+                                          << static_cast<int>(port) << " via " << redundantInterface_)
+        return true;
+      }
+    }
+  }
+  secondaryEndpoint_ = PortEndpoint{static_cast<uint16_t>(ecatSlavecount_), 1};
+  MELO_WARN_STREAM("[EthercatBus::" << name_ << "] Cable redundancy enabled, but the ring via " << redundantInterface_ << " is not closed.")
+  return true;
+}
+
+std::vector<uint16_t> EthercatBus::readDlStatus() {
+  std::vector<uint16_t> dlStatus(static_cast<size_t>(ecatSlavecount_), 0);
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    uint16 value = 0;
+    if (ecx_FPRD(ecatContext_.port, ecatSlavelist_[slave].configadr, ECT_REG_DLSTAT, sizeof(value), &value, EC_TIMEOUTRET) > 0) {
+      dlStatus[slave - 1] = etohs(value);
+    }
+  }
+  return dlStatus;
+}
+
+RedundancyState EthercatBus::readRedundancyState() {
+  RedundancyState state;
+  state.enabled = !redundantInterface_.empty() && ecatContext_.port->redstate != ECT_RED_NONE;
+  if (!state.enabled) {
+    return state;
+  }
+
+  // walk the ring from the primary to the secondary interface, the first link without communication is the break.
+  std::vector<PortLink> ring = redundantTopology_.links;
+  ring.push_back(PortLink{secondaryEndpoint_, PortEndpoint{0, 0}});
+  const auto dlStatus = readDlStatus();
+  auto communicates = [&dlStatus](const PortEndpoint& endpoint) {
+    return endpoint.slave == 0 || communicationOnPort(dlStatus[endpoint.slave - 1], endpoint.port);
+  };
+  for (const auto& link : ring) {
+    if (!communicates(link.upstream) || !communicates(link.downstream)) {
+      state.lineBreak = true;
+      state.breakLink = link;
+      break;
+    }
+  }
+
+  if (state.lineBreak) {
+    auto endpointName = [this](const PortEndpoint& endpoint, bool primary) {
+      if (endpoint.slave == 0) {
+        return primary ? name_ : redundantInterface_;
+      }
+      return "slave " + std::to_string(endpoint.slave) + " port " + std::to_string(endpoint.port);
+    };
+    state.description =
+        "line break between " + endpointName(state.breakLink.upstream, true) + " and " + endpointName(state.breakLink.downstream, false);
+  } else {
+    state.description = "ring closed";
+  }
+  return state;
+}
+
+BusTopology EthercatBus::getTopology() const {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  BusTopology topology;
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    const ec_slavet& slaveInfo = ecatSlavelist_[slave];
+    PortLink link;
+    link.upstream.slave = slaveInfo.parent;
+    link.upstream.port = slaveInfo.parent == 0 ? 0 : slaveInfo.parentport;
+    link.downstream.slave = static_cast<uint16_t>(slave);
+    link.downstream.port = slaveInfo.entryport;
+    topology.links.push_back(link);
+  }
+  return topology;
+}
+
+uint16_t EthercatBus::readSlaveStates(std::vector<SlaveAlStatus>& states) {
+  ecx_portt* port = ecatContext_.port;
+  states.assign(static_cast<size_t>(ecatSlavecount_), SlaveAlStatus{});
+
+  // the broadcast ORs the states of all slaves: a single state bit without error means they all agree.
+  uint16 combinedState = 0;
+  const int workingCounter = ecx_BRD(port, 0, ECT_REG_ALSTAT, sizeof(combinedState), &combinedState, EC_TIMEOUTRET);
+  combinedState = etohs(combinedState);
+  const uint16 state = combinedState & 0x0f;
+  if (workingCounter == ecatSlavecount_ && !(combinedState & EC_STATE_ERROR) &&
+      (state == EC_STATE_INIT || state == EC_STATE_PRE_OP || state == EC_STATE_SAFE_OP || state == EC_STATE_OPERATIONAL)) {
+    for (auto& slaveState : states) {
+      slaveState.state = state;
+    }
+    return state;
+  }
+
+  uint16_t lowestState = EC_STATE_OPERATIONAL;
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    // AL status (0x0130), reserved, AL status code (0x0134).
+    uint16 alStatus[3] = {0, 0, 0};
+    if (ecx_FPRD(port, ecatSlavelist_[slave].configadr, ECT_REG_ALSTAT, sizeof(alStatus), alStatus, EC_TIMEOUTRET) > 0) {
+      states[slave - 1].state = etohs(alStatus[0]);
+      states[slave - 1].alStatusCode = etohs(alStatus[2]);
+    }
+    lowestState = std::min<uint16_t>(lowestState, states[slave - 1].state & 0x0f);
+  }
+  return lowestState;
+}
+
+void EthercatBus::readPortErrorCounters(std::vector<PortErrorCounters>& counters) {
+  ecx_portt* port = ecatContext_.port;
+  counters.assign(static_cast<size_t>(ecatSlavecount_), PortErrorCounters{});
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    auto& slaveCounters = counters[slave - 1];
+    uint16 rxErrors[PortErrorCounters::numberOfPorts] = {};
+    if (ecx_FPRD(port, ecatSlavelist_[slave].configadr, escRxErrorCounterRegister, sizeof(rxErrors), rxErrors, EC_TIMEOUTRET) > 0) {
+      for (size_t i = 0; i < PortErrorCounters::numberOfPorts; i++) {
+        slaveCounters.rxErrors[i] = etohs(rxErrors[i]);
+      }
+    }
+    ecx_FPRD(port, ecatSlavelist_[slave].configadr, escLostLinkCounterRegister, sizeof(slaveCounters.lostLinks),
+             slaveCounters.lostLinks.data(), EC_TIMEOUTRET);
+  }
+}
+
+ProcessImageInfo EthercatBus::getProcessImageInfo() const {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  const ec_groupt& group = ecatGrouplist_[0];
+  ProcessImageInfo image;
+  image.slaves = static_cast<unsigned int>(ecatSlavecount_);
+  image.outputBytes = group.Obytes;
+  image.inputBytes = group.Ibytes;
+  image.frames = group.nsegments;
+  image.blockLRW = group.blockLRW != 0;
+  image.hasDc = group.hasdc != 0;
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    if (ecatSlavelist_[slave].hasdc) {
+      image.propagationDelayNs = std::max(image.propagationDelayNs, static_cast<long>(ecatSlavelist_[slave].pdelay));
+    }
+  }
+  return image;
+}
+
+long EthercatBus::readMaxDcSyncErrorNs() {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  long maxError = -1;
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    if (!ecatSlavelist_[slave].hasdc) {
+      continue;
+    }
+    uint32 difference = 0;
+    if (ecx_FPRD(ecatContext_.port, ecatSlavelist_[slave].configadr, ECT_REG_DCSYSDIFF, sizeof(difference), &difference, EC_TIMEOUTRET) >
+        0) {
+      // bit 31 is the sign, bits 0-30 the magnitude.
+      maxError = std::max(maxError, static_cast<long>(etohl(difference) & 0x7fffffff));
+    }
+  }
+  return maxError;
+}
+
+bool EthercatBus::setSync0CycleTime(uint32_t cycleTimeNs, int64_t startDelayNs) {
+  if (cycleTimeNs == 0) {
+    return true;
+  }
+  bool success = true;
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    // the slave list is locked for its accesses only, the datagrams interleave with the cyclic frames.
+    uint16 configadr = 0;
+    int32 shift = 0;
+    {
+      std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+      const ec_slavet& slaveInfo = ecatSlavelist_[slave];
+      if (!slaveInfo.DCactive) {
+        continue;
+      }
+      configadr = slaveInfo.configadr;
+      shift = slaveInfo.DCshift;
+    }
+    uint8 activation = 0;
+    uint8 inactive = 0;
+    uint64 localTime = 0;
+    if (ecx_FPRD(ecatContext_.port, configadr, ECT_REG_DCSYNCACT, sizeof(activation), &activation, EC_TIMEOUTRET) <= 0 ||
+        ecx_FPWR(ecatContext_.port, configadr, ECT_REG_DCSYNCACT, sizeof(inactive), &inactive, EC_TIMEOUTRET) <= 0 ||
+        ecx_FPRD(ecatContext_.port, configadr, ECT_REG_DCSYSTIME, sizeof(localTime), &localTime, EC_TIMEOUTRET) <= 0) {
+      success = false;
+      continue;
+    }
+    // first pulse on a multiple of the cycle time, all slaves share the system time and stay aligned.
+    uint64 startTime = (etohll(localTime) + startDelayNs) / cycleTimeNs * cycleTimeNs + cycleTimeNs + shift;
+    startTime = htoell(startTime);
+    uint32 cycleTime = htoel(cycleTimeNs);
+    if (ecx_FPWR(ecatContext_.port, configadr, ECT_REG_DCSTART0, sizeof(startTime), &startTime, EC_TIMEOUTRET) <= 0 ||
+        ecx_FPWR(ecatContext_.port, configadr, ECT_REG_DCCYCLE0, sizeof(cycleTime), &cycleTime, EC_TIMEOUTRET) <= 0 ||
+        ecx_FPWR(ecatContext_.port, configadr, ECT_REG_DCSYNCACT, sizeof(activation), &activation, EC_TIMEOUTRET) <= 0) {
+      success = false;
+      continue;
+    }
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    ecatSlavelist_[slave].DCcycle = static_cast<int32>(cycleTimeNs);
+  }
+  return success;
+}
+
+ProcessImageLayout EthercatBus::getProcessImageLayout() const {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  const ec_groupt& group = ecatGrouplist_[0];
+  ProcessImageLayout layout;
+  layout.outputBytes = group.Obytes;
+  layout.inputBytes = group.Ibytes;
+  layout.frames = group.nsegments;
+  layout.blockLRW = group.blockLRW != 0;
+
+  // SOEM maps the outputs of all slaves first, followed by the inputs. Both are split into frames at slave boundaries if possible.
+  const uint8* imageStart = group.outputs != nullptr ? group.outputs : group.inputs;
+  auto frameOf = [&group](uint32_t offset) {
+    uint32_t segmentEnd = 0;
+    for (unsigned int segment = 0; segment < group.nsegments && segment < EC_MAXIOSEGMENTS; segment++) {
+      segmentEnd += group.IOsegment[segment];
+      if (offset < segmentEnd) {
+        return segment;
+      }
+    }
+    return group.nsegments > 0 ? static_cast<unsigned int>(group.nsegments - 1) : 0u;
+  };
+
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    const ec_slavet& slaveInfo = ecatSlavelist_[slave];
+    if (slaveInfo.blockLRW) {
+      layout.slavesBlockingLRW++;
+    }
+    ProcessImageEntry entry;
+    entry.slave = static_cast<uint16_t>(slave);
+    entry.name = slaveInfo.name;
+    if (slaveInfo.outputs != nullptr && imageStart != nullptr) {
+      entry.outputOffset = static_cast<uint32_t>(slaveInfo.outputs - imageStart);
+      entry.outputBytes = slaveInfo.Obytes;
+      entry.outputStartBit = slaveInfo.Ostartbit;
+      entry.outputFrame = frameOf(entry.outputOffset);
+      entry.crossesFrame |= slaveInfo.Obytes > 0 && frameOf(entry.outputOffset + slaveInfo.Obytes - 1) != entry.outputFrame;
+    }
+    if (slaveInfo.inputs != nullptr && imageStart != nullptr) {
+      entry.inputOffset = static_cast<uint32_t>(slaveInfo.inputs - imageStart);
+      entry.inputBytes = slaveInfo.Ibytes;
+      entry.inputStartBit = slaveInfo.Istartbit;
+      entry.inputFrame = frameOf(entry.inputOffset);
+      entry.crossesFrame |= slaveInfo.Ibytes > 0 && frameOf(entry.inputOffset + slaveInfo.Ibytes - 1) != entry.inputFrame;
+    }
+    layout.entries.push_back(entry);
+  }
+  return layout;
+}
+
+bool EthercatBus::optimizeProcessImageLayout(const std::vector<uint16_t>& hotSlaves) {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  ec_groupt& group = ecatGrouplist_[0];
+  uint8* image = group.outputs;
+  if (image == nullptr || ecatSlavecount_ == 0) {
+    return false;
+  }
+
+  // the outputs (FMMU type 2, write) and inputs (FMMU type 1, read) of every slave, overlapping areas form one block.
+  struct SlaveArea {
+    uint16_t slave{0};
+    ProcessImageBlock block;
+    size_t blockIndex{0};
+  };
+  std::vector<SlaveArea> areas;
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    const ec_slavet& slaveInfo = ecatSlavelist_[slave];
+    const bool hot = std::find(hotSlaves.begin(), hotSlaves.end(), slave) != hotSlaves.end();
+    for (const bool input : {false, true}) {
+      uint32_t begin = UINT32_MAX;
+      uint32_t end = 0;
+      for (int fmmu = 0; fmmu < slaveInfo.FMMUunused && fmmu < EC_MAXFMMU; fmmu++) {
+        const ec_fmmut& mapping = slaveInfo.FMMU[fmmu];
+        if (!mapping.FMMUactive || mapping.FMMUtype != (input ? 1 : 2) || etohs(mapping.LogLength) == 0) {
+          continue;
+        }
+        const uint32_t start = etohl(mapping.LogStart) - group.logstartaddr;
+        begin = std::min(begin, start);
+        end = std::max(end, start + etohs(mapping.LogLength));
+      }
+      if (begin < end) {
+        areas.push_back(SlaveArea{static_cast<uint16_t>(slave), ProcessImageBlock{input, begin, end - begin, hot, 0}, 0});
+      }
+    }
+  }
+  std::sort(areas.begin(), areas.end(), [](const SlaveArea& a, const SlaveArea& b) { return a.block.offset < b.block.offset; });
+  std::vector<ProcessImageBlock> blocks;
+  for (auto& area : areas) {
+    if (!blocks.empty() && blocks.back().input == area.block.input && area.block.offset < blocks.back().offset + blocks.back().size) {
+      ProcessImageBlock& block = blocks.back();
+      block.size = std::max(block.offset + block.size, area.block.offset + area.block.size) - block.offset;
+      block.hot |= area.block.hot;
+    } else {
+      blocks.push_back(area.block);
+    }
+    area.blockIndex = blocks.size() - 1;
+  }
+
+  ProcessImagePlan plan;
+  const uint32_t maxFrameSize = EC_MAXLRWDATA - EC_FIRSTDCDATAGRAM;
+  const bool aligned = planProcessImageLayout(blocks, true, maxFrameSize, sizeof(ioMap_), plan) && plan.frames.size() <= group.nsegments;
+  if (!aligned && (!planProcessImageLayout(blocks, false, maxFrameSize, sizeof(ioMap_), plan) || plan.frames.size() > group.nsegments ||
+                   plan.frames.size() > EC_MAXIOSEGMENTS)) {
+    return false;
+  }
+  bool unchanged = true;
+  for (const auto& block : plan.blocks) {
+    unchanged &= block.plannedOffset == block.offset;
+  }
+  if (unchanged) {
+    return false;
+  }
+
+  // the FMMUs are evaluated per datagram, the slaves stay in SAFE_OP. Without process data exchange nothing reads the
+  // image while some slaves are already remapped.
+  std::vector<std::pair<int, std::array<ec_fmmut, EC_MAXFMMU>>> written;
+  bool success = true;
+  for (int slave = 1; slave <= ecatSlavecount_ && success; slave++) {
+    ec_slavet& slaveInfo = ecatSlavelist_[slave];
+    std::array<ec_fmmut, EC_MAXFMMU> mappings;
+    std::copy(slaveInfo.FMMU, slaveInfo.FMMU + EC_MAXFMMU, mappings.begin());
+    bool moved = false;
+    for (const auto& area : areas) {
+      if (area.slave != slave) {
+        continue;
+      }
+      const ProcessImageBlock& block = plan.blocks[area.blockIndex];
+      for (int fmmu = 0; fmmu < slaveInfo.FMMUunused && fmmu < EC_MAXFMMU; fmmu++) {
+        ec_fmmut& mapping = mappings[fmmu];
+        if (mapping.FMMUactive && mapping.FMMUtype == (area.block.input ? 1 : 2) && etohs(mapping.LogLength) > 0) {
+          mapping.LogStart = htoel(etohl(mapping.LogStart) + block.plannedOffset - block.offset);
+          moved |= block.plannedOffset != block.offset;
+        }
+      }
+    }
+    if (!moved) {
+      continue;
+    }
+    written.emplace_back(slave, mappings);
+    for (int fmmu = 0; fmmu < slaveInfo.FMMUunused && fmmu < EC_MAXFMMU && success; fmmu++) {
+      success = ecx_FPWR(ecatContext_.port, slaveInfo.configadr, static_cast<uint16>(ECT_REG_FMMU0 + fmmu * sizeof(ec_fmmut)),
+                         sizeof(ec_fmmut), &mappings[fmmu], EC_TIMEOUTRET3) > 0;
+    }
+  }
+  if (!success) {
+    // back to the mapping of SOEM, which the slave list still holds.
+    for (const auto& slaveMappings : written) {
+      ec_slavet& slaveInfo = ecatSlavelist_[slaveMappings.first];
+      for (int fmmu = 0; fmmu < slaveInfo.FMMUunused && fmmu < EC_MAXFMMU; fmmu++) {
+        ecx_FPWR(ecatContext_.port, slaveInfo.configadr, static_cast<uint16>(ECT_REG_FMMU0 + fmmu * sizeof(ec_fmmut)), sizeof(ec_fmmut),
+                 &slaveInfo.FMMU[fmmu], EC_TIMEOUTRET3);
+      }
+    }
+    return false;
+  }
+
+  // move what is already in the image along with the slaves.
+  const uint32_t imageSize = group.Obytes + group.Ibytes;
+  const std::vector<uint8> previousImage(image, image + imageSize);
+  std::fill(image, image + std::max(imageSize, plan.outputBytes + plan.inputBytes), 0);
+  for (const auto& block : plan.blocks) {
+    std::copy(previousImage.begin() + block.offset, previousImage.begin() + block.offset + block.size, image + block.plannedOffset);
+  }
+  for (const auto& slaveMappings : written) {
+    std::copy(slaveMappings.second.begin(), slaveMappings.second.end(), ecatSlavelist_[slaveMappings.first].FMMU);
+  }
+  for (const auto& area : areas) {
+    ec_slavet& slaveInfo = ecatSlavelist_[area.slave];
+    const ProcessImageBlock& block = plan.blocks[area.blockIndex];
+    uint8*& data = area.block.input ? slaveInfo.inputs : slaveInfo.outputs;
+    if (data != nullptr) {
+      data += static_cast<std::ptrdiff_t>(block.plannedOffset) - static_cast<std::ptrdiff_t>(block.offset);
+    }
+  }
+
+  group.Obytes = plan.outputBytes;
+  group.Ibytes = plan.inputBytes;
+  group.inputs = image + plan.outputBytes;
+  group.nsegments = static_cast<uint16>(plan.frames.size());
+  std::copy(plan.frames.begin(), plan.frames.end(), group.IOsegment);
+  group.Isegment = static_cast<uint16>(plan.inputFrame);
+  group.Ioffset = static_cast<uint16>(plan.inputFrameOffset);
+  ecatSlavelist_[0].Obytes = plan.outputBytes;
+  ecatSlavelist_[0].Ibytes = plan.inputBytes;
+  ecatSlavelist_[0].inputs = group.inputs;
+  return true;
+}
+
+InputChangeDetector::Region EthercatBus::getInputRegion(uint16_t slave) const {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  InputChangeDetector::Region region;
+  if (slave == 0 || slave > ecatSlavecount_ || ecatSlavelist_[slave].inputs == nullptr) {
+    return region;
+  }
+  const ec_slavet& slaveInfo = ecatSlavelist_[slave];
+  region.data = slaveInfo.inputs;
+  region.size = slaveInfo.Ibytes > 0 ? slaveInfo.Ibytes : (slaveInfo.Ibits > 0 ? 1 : 0);
+  return region;
+}
+
+InputChangeDetector::Region EthercatBus::getInputImage() const {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  InputChangeDetector::Region region;
+  const ec_groupt& group = ecatGrouplist_[0];
+  if (group.inputs != nullptr) {
+    region.data = group.inputs;
+    region.size = group.Ibytes;
+  }
+  return region;
+}
+
+bool EthercatBus::recoverSlave(uint16_t slave, const std::function<bool()>& preOpConfiguration) {
+  if (slave == 0 || slave > ecatSlavecount_) {
+    return false;
+  }
+  // the update thread leaves the devices of the slave alone while preOpConfiguration reconfigures them.
+  setSlaveRecovering(slave, true);
+  const bool success = reconfigureSlave(slave, preOpConfiguration);
+  setSlaveRecovering(slave, false);
+  return success;
+}
+
+void EthercatBus::setSlaveRecovering(uint16_t slave, bool recovering) {
+  recovering_[slave].store(recovering);
+  // sequentially consistent with the update thread: it either sees the flag or is seen updating the devices.
+  while (recovering && updatingDevices_.load()) {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+bool EthercatBus::reconfigureSlave(uint16_t slave, const std::function<bool()>& preOpConfiguration) {
+  ec_slavet& slaveInfo = ecatSlavelist_[slave];
+  ecx_portt* port = ecatContext_.port;
+
+  uint16 configadr = 0;
+  {
+    // the slave list is shared with the mailbox service and the diagnosis, the lock is released for the state changes.
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    // a slave which was power cycled lost its configured station address.
+    uint16 alStatus = 0;
+    if (ecx_FPRD(port, slaveInfo.configadr, ECT_REG_ALSTAT, sizeof(alStatus), &alStatus, EC_TIMEOUTRET) <= 0) {
+      if (ecx_recover_slave(&ecatContext_, slave, EC_TIMEOUTRET3) <= 0) {
+        return false;
+      }
+    }
+    configadr = slaveInfo.configadr;
+  }
+
+  // INIT, acknowledging a pending error.
+  if (!requestSlaveState(slave, EC_STATE_INIT | EC_STATE_ACK)) {
+    return false;
+  }
+  {
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    ecx_eeprom2pdi(&ecatContext_, slave);
+    // a slave left in BOOT after a firmware update is recovered with its standard mailbox.
+    restoreStandardMailbox(slave);
+    for (int sm = 0; sm < EC_MAXSM; sm++) {
+      if (slaveInfo.SM[sm].StartAddr) {
+        ecx_FPWR(port, configadr, static_cast<uint16>(ECT_REG_SM0 + sm * sizeof(ec_smt)), sizeof(ec_smt), &slaveInfo.SM[sm],
+                 EC_TIMEOUTRET3);
+      }
+    }
+  }
+
+  if (!requestSlaveState(slave, EC_STATE_PRE_OP)) {
+    return false;
+  }
+  if (preOpConfiguration && !preOpConfiguration()) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    for (int fmmu = 0; fmmu < slaveInfo.FMMUunused && fmmu < EC_MAXFMMU; fmmu++) {
+      ecx_FPWR(port, configadr, static_cast<uint16>(ECT_REG_FMMU0 + fmmu * sizeof(ec_fmmut)), sizeof(ec_fmmut), &slaveInfo.FMMU[fmmu],
+               EC_TIMEOUTRET3);
+    }
+    // a power cycled slave lost its SYNC0 configuration, restarted with the cycle and shift of the slave list.
+    if (slaveInfo.DCactive) {
+      ecx_dcsync0(&ecatContext_, slave, TRUE, static_cast<uint32>(slaveInfo.DCcycle), slaveInfo.DCshift);
+    }
+  }
+  if (!requestSlaveState(slave, EC_STATE_SAFE_OP)) {
+    return false;
+  }
+  return requestSlaveState(slave, EC_STATE_OPERATIONAL);
+}
+
+bool EthercatBus::requestSlaveState(uint16_t slave, uint16_t state) {
+  uint16 configadr = 0;
+  {
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    configadr = ecatSlavelist_[slave].configadr;
+  }
+  ecx_portt* port = ecatContext_.port;
+  if (ecx_FPWRw(port, configadr, ECT_REG_ALCTL, htoes(state), EC_TIMEOUTRET3) <= 0) {
+    return false;
+  }
+
+  // polled like ecx_statecheck, which writes the slave list without the context mutex.
+  const uint16_t requestedState = state & 0x0f;
+  const auto timeout = std::chrono::steady_clock::now() + std::chrono::microseconds(EC_TIMEOUTSTATE);
+  // AL status (0x0130), reserved, AL status code (0x0134).
+  uint16 alStatus[3] = {0, 0, 0};
+  bool reached = false;
+  while (true) {
+    if (ecx_FPRD(port, configadr, ECT_REG_ALSTAT, sizeof(alStatus), alStatus, EC_TIMEOUTRET) > 0) {
+      reached = (etohs(alStatus[0]) & 0x0f) == requestedState;
+    }
+    if (reached || std::chrono::steady_clock::now() > timeout) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  ecatSlavelist_[slave].state = etohs(alStatus[0]);
+  ecatSlavelist_[slave].ALstatuscode = etohs(alStatus[2]);
+  return reached;
+}
+
+bool EthercatBus::changeProcessDataSize(uint16_t slave, uint32_t outputBytes, uint32_t inputBytes,
+                                        const std::function<bool()>& preOpConfiguration) {
+  if (slave == 0 || slave > ecatSlavecount_) {
+    return false;
+  }
+  // the startup configuration of the slave list, which is not changed. The slave list is shared with the mailbox service
+  // and the diagnosis, the lock is released for the state changes and preOpConfiguration like in reconfigureSlave().
+  uint16 configadr = 0;
+  // sync managers of the process data (SM type 3: outputs, 4: inputs).
+  int outputSm = -1;
+  int inputSm = -1;
+  std::array<ec_smt, EC_MAXSM> syncManagers;
+  std::array<ec_fmmut, EC_MAXFMMU> mappings;
+  int mappingCount = 0;
+  {
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    const ec_slavet& slaveInfo = ecatSlavelist_[slave];
+    if (outputBytes > slaveInfo.Obytes || inputBytes > slaveInfo.Ibytes) {
+      return false;
+    }
+    for (int sm = 0; sm < EC_MAXSM; sm++) {
+      if (slaveInfo.SM[sm].StartAddr == 0 || (slaveInfo.SMtype[sm] != 3 && slaveInfo.SMtype[sm] != 4)) {
+        continue;
+      }
+      int& processDataSm = slaveInfo.SMtype[sm] == 3 ? outputSm : inputSm;
+      if (processDataSm >= 0) {
+        return false;
+      }
+      processDataSm = sm;
+    }
+    configadr = slaveInfo.configadr;
+    std::copy(slaveInfo.SM, slaveInfo.SM + EC_MAXSM, syncManagers.begin());
+    std::copy(slaveInfo.FMMU, slaveInfo.FMMU + EC_MAXFMMU, mappings.begin());
+    mappingCount = std::min<int>(slaveInfo.FMMUunused, EC_MAXFMMU);
+  }
+  ecx_portt* port = ecatContext_.port;
+
+  // the length of a process data sync manager and of its FMMU, the startup lengths if restore is set.
+  auto writeLength = [&](int sm, uint32_t bytes, bool restore) {
+    if (sm < 0) {
+      return true;
+    }
+    ec_smt syncManager = syncManagers[sm];
+    if (!restore) {
+      syncManager.SMlength = htoes(static_cast<uint16>(bytes));
+    }
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    if (ecx_FPWR(port, configadr, static_cast<uint16>(ECT_REG_SM0 + sm * sizeof(ec_smt)), sizeof(ec_smt), &syncManager, EC_TIMEOUTRET3) <= 0) {
+      return false;
+    }
+    // the FMMU of the sync manager, not the mailbox status FMMU of mapMailboxStatus().
+    for (int fmmu = 0; fmmu < mappingCount; fmmu++) {
+      if (mappings[fmmu].PhysStart != syncManager.StartAddr) {
+        continue;
+      }
+      ec_fmmut mapping = mappings[fmmu];
+      if (!restore) {
+        mapping.LogLength = htoes(static_cast<uint16>(bytes));
+      }
+      if (ecx_FPWR(port, configadr, static_cast<uint16>(ECT_REG_FMMU0 + fmmu * sizeof(ec_fmmut)), sizeof(ec_fmmut), &mapping,
+                   EC_TIMEOUTRET3) <= 0) {
+        return false;
+      }
+    }
+    return true;
+  };
+  // back to the startup lengths and SAFE_OP. A slave which refuses SAFE_OP with the PDO assignment left by a failed
+  // preOpConfiguration is brought back by the slave recovery, which reruns the startup of its devices.
+  auto rollback = [&]() {
+    writeLength(outputSm, 0, true);
+    writeLength(inputSm, 0, true);
+    requestSlaveState(slave, EC_STATE_SAFE_OP);
+    return false;
+  };
+
+  if (!requestSlaveState(slave, EC_STATE_PRE_OP)) {
+    return rollback();
+  }
+  if (preOpConfiguration && !preOpConfiguration()) {
+    return rollback();
+  }
+  if (!writeLength(outputSm, outputBytes, false) || !writeLength(inputSm, inputBytes, false)) {
+    return rollback();
+  }
+  if (!requestSlaveState(slave, EC_STATE_SAFE_OP)) {
+    return rollback();
+  }
+  return true;
+}
+
+bool EthercatBus::getProcessDataSize(uint16_t slave, uint32_t& outputBytes, uint32_t& inputBytes) const {
+  if (slave == 0 || slave > ecatSlavecount_) {
+    return false;
+  }
+  outputBytes = ecatSlavelist_[slave].Obytes;
+  inputBytes = ecatSlavelist_[slave].Ibytes;
+  return true;
+}
+
+unsigned int EthercatBus::mapMailboxStatus() {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  ecx_portt* port = ecatContext_.port;
+  mailboxStatusSlaves_.clear();
+  polledMailboxSlaves_.clear();
+
+  // behind everything SOEM mapped.
+  uint32_t logicalAddress = 0;
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    const ec_slavet& slaveInfo = ecatSlavelist_[slave];
+    for (int fmmu = 0; fmmu < slaveInfo.FMMUunused && fmmu < EC_MAXFMMU; fmmu++) {
+      if (slaveInfo.FMMU[fmmu].FMMUactive) {
+        logicalAddress = std::max(logicalAddress, etohl(slaveInfo.FMMU[fmmu].LogStart) + etohs(slaveInfo.FMMU[fmmu].LogLength));
+      }
+    }
+  }
+  mailboxStatusLogicalAddress_ = logicalAddress;
+
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    ec_slavet& slaveInfo = ecatSlavelist_[slave];
+    if (slaveInfo.mbx_l == 0 || slaveInfo.SM[1].StartAddr == 0) {
+      continue;
+    }
+    uint8 fmmuCount = 0;
+    if (mailboxStatusSlaves_.size() >= maxMappedMailboxStatus || slaveInfo.FMMUunused >= EC_MAXFMMU ||
+        ecx_FPRD(port, slaveInfo.configadr, escFmmuCountRegister, sizeof(fmmuCount), &fmmuCount, EC_TIMEOUTRET3) <= 0 ||
+        slaveInfo.FMMUunused >= fmmuCount) {
+      polledMailboxSlaves_.push_back(static_cast<uint16_t>(slave));
+      continue;
+    }
+
+    // both mailbox status registers and the SM1 configuration between them with a single FMMU, read only.
+    const uint8 fmmuIndex = slaveInfo.FMMUunused;
+    ec_fmmut& fmmu = slaveInfo.FMMU[fmmuIndex];
+    std::memset(&fmmu, 0, sizeof(fmmu));
+    fmmu.LogStart = htoel(static_cast<uint32>(logicalAddress + mailboxStatusSlaves_.size() * mailboxStatusSize));
+    fmmu.LogLength = htoes(static_cast<uint16>(mailboxStatusSize));
+    fmmu.LogEndbit = 7;
+    fmmu.PhysStart = htoes(ECT_REG_SM0STAT);
+    fmmu.FMMUtype = 1;
+    fmmu.FMMUactive = 1;
+    if (ecx_FPWR(port, slaveInfo.configadr, static_cast<uint16>(ECT_REG_FMMU0 + fmmuIndex * sizeof(ec_fmmut)), sizeof(ec_fmmut), &fmmu,
+                 EC_TIMEOUTRET3) <= 0) {
+      std::memset(&fmmu, 0, sizeof(fmmu));
+      polledMailboxSlaves_.push_back(static_cast<uint16_t>(slave));
+      continue;
+    }
+    // the FMMU is restored together with the process data FMMUs by recoverSlave().
+    slaveInfo.FMMUunused++;
+    mailboxStatusSlaves_.push_back(static_cast<uint16_t>(slave));
+  }
+  mailboxStatus_.resize(mailboxStatusSlaves_.size() * mailboxStatusSize);
+  outMailboxFull_.assign(static_cast<size_t>(ecatSlavecount_) + 1, 0);
+  pendingMailboxes_.reserve(mailboxStatusSlaves_.size() + polledMailboxSlaves_.size());
+  return static_cast<unsigned int>(mailboxStatusSlaves_.size());
+}
+
+bool EthercatBus::readMailboxStatus(std::vector<uint16_t>& pendingSlaves) {
+  ecx_portt* port = ecatContext_.port;
+  pendingSlaves.clear();
+  bool success = true;
+
+  if (!mailboxStatusSlaves_.empty()) {
+    // slaves which do not respond leave their byte untouched.
+    std::fill(mailboxStatus_.begin(), mailboxStatus_.end(), 0);
+    const int workingCounter = ecx_LRD(port, mailboxStatusLogicalAddress_, static_cast<uint16>(mailboxStatus_.size()),
+                                       mailboxStatus_.data(), EC_TIMEOUTRET);
+    success &= workingCounter == static_cast<int>(mailboxStatusSlaves_.size());
+    for (size_t i = 0; i < mailboxStatusSlaves_.size(); i++) {
+      const uint8_t* status = &mailboxStatus_[i * mailboxStatusSize];
+      outMailboxFull_[mailboxStatusSlaves_[i]] = status[0] & mailboxFull;
+      if (status[mailboxStatusSize - 1] & mailboxFull) {
+        pendingSlaves.push_back(mailboxStatusSlaves_[i]);
+      }
+    }
+  }
+
+  auto pollSlave = [&](uint16_t slave) {
+    uint8 status = 0;
+    if (ecx_FPRD(port, getMailboxArea(slave).configuredAddress, ECT_REG_SM1STAT, sizeof(status), &status, EC_TIMEOUTRET) <= 0) {
+      success = false;
+    } else if (status & mailboxFull) {
+      pendingSlaves.push_back(slave);
+    }
+  };
+  if (mailboxStatusSlaves_.empty() && polledMailboxSlaves_.empty()) {
+    for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+      if (getMailboxArea(static_cast<uint16_t>(slave)).writeLength > 0) {
+        pollSlave(static_cast<uint16_t>(slave));
+      }
+    }
+  } else {
+    for (const auto slave : polledMailboxSlaves_) {
+      pollSlave(slave);
+    }
+  }
+  return success;
+}
+
+bool EthercatBus::serviceMailboxes(const MailboxHandler& handler) {
+  ecx_portt* port = ecatContext_.port;
+  bool success = readMailboxStatus(pendingMailboxes_);
+  for (const auto slave : pendingMailboxes_) {
+    // responses belong to the transfer which requested them.
+    if (hasMailboxTransfer(slave)) {
+      continue;
+    }
+    const MailboxArea area = getMailboxArea(slave);
+    if (area.readLength == 0 || area.readLength > EC_MAXMBX) {
+      continue;
+    }
+    ec_mbxbuft mailbox;
+    ec_clearmbx(&mailbox);
+    // the mailbox header and the CoE header first, only reading the last byte of the mailbox releases it.
+    if (ecx_FPRD(port, area.configuredAddress, area.readOffset, mailboxPeekSize, &mailbox, EC_TIMEOUTRET) <= 0 ||
+        !(isCoeEmergency(mailbox) || isEoe(mailbox))) {
+      continue;
+    }
+    // an SDO transfer started meanwhile reads the mailbox itself, the ESC then does not answer the read of the empty
+    // mailbox.
+    if (ecx_FPRD(port, area.configuredAddress, area.readOffset, area.readLength, &mailbox, EC_TIMEOUTRET) <= 0) {
+      success = false;
+      continue;
+    }
+    if (isCoeEmergency(mailbox)) {
+      pushEmergency(slave, mailbox);
+    } else if (isEoe(mailbox)) {
+      if (handler) {
+        handler(slave, mailbox);
+      }
+    } else {
+      // the response of an SDO transfer which took the peeked mailbox meanwhile, the transfer will time out.
+      discardedMailboxes_++;
+      MELO_WARN_STREAM("[EthercatBus::" << name_ << "] Discarded a mailbox of type " << (mailbox[5] & 0x0f) << " from slave " << slave
+                                        << ", a mailbox transfer to the slave started meanwhile.")
+    }
+  }
+  return success;
+}
+
+void EthercatBus::beginMailboxTransfer(uint16_t slave) {
+  std::lock_guard<std::mutex> lock(mailboxTransferMutex_);
+  mailboxTransfers_[slave]++;
+}
+
+void EthercatBus::endMailboxTransfer(uint16_t slave) {
+  std::lock_guard<std::mutex> lock(mailboxTransferMutex_);
+  const auto transfer = mailboxTransfers_.find(slave);
+  if (transfer != mailboxTransfers_.end() && --transfer->second == 0) {
+    mailboxTransfers_.erase(transfer);
+  }
+}
+
+bool EthercatBus::hasMailboxTransfer(uint16_t slave) const {
+  std::lock_guard<std::mutex> lock(mailboxTransferMutex_);
+  return mailboxTransfers_.count(slave) > 0;
+}
+
+EthercatBus::MailboxArea EthercatBus::getMailboxArea(uint16_t slave) const {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  const ec_slavet& slaveInfo = ecatSlavelist_[slave];
+  MailboxArea area;
+  area.configuredAddress = slaveInfo.configadr;
+  area.writeOffset = slaveInfo.mbx_wo;
+  area.writeLength = slaveInfo.mbx_l;
+  area.readOffset = slaveInfo.mbx_ro;
+  area.readLength = slaveInfo.mbx_rl;
+  return area;
+}
+
+void EthercatBus::pushEmergency(uint16_t slave, const ec_mbxbuft& mailbox) {
+  // behind the mailbox header and the CoE header: error code, error register, 5 bytes of manufacturer data.
+  const uint8* data = mailbox + sizeof(ec_mbxheadert) + sizeof(uint16);
+  uint16 errorCode = 0;
+  uint16 w1 = 0;
+  uint16 w2 = 0;
+  std::memcpy(&errorCode, data, sizeof(errorCode));
+  std::memcpy(&w1, data + 4, sizeof(w1));
+  std::memcpy(&w2, data + 6, sizeof(w2));
+
+  // the entry ecx_mbxreceive() pushes for an emergency.
+  ec_errort error;
+  std::memset(&error, 0, sizeof(error));
+  error.Time = osal_current_time();
+  error.Slave = slave;
+  error.Etype = EC_ERR_TYPE_EMERGENCY;
+  error.ErrorCode = etohs(errorCode);
+  error.ErrorReg = data[2];
+  error.b1 = data[3];
+  error.w1 = etohs(w1);
+  error.w2 = etohs(w2);
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  ecx_pusherror(&ecatContext_, &error);
+}
+
+bool EthercatBus::popEmergencies(const std::function<void(const ec_errort& error)>& handler) {
+  std::unique_lock<std::recursive_mutex> lock(contextMutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return false;
+  }
+  // the oldest entry is Error[tail], the list is empty if head == tail.
+  const ec_eringt* errorList = ecatContext_.elist;
+  ec_errort error;
+  while (errorList->head != errorList->tail && errorList->Error[errorList->tail].Etype == EC_ERR_TYPE_EMERGENCY &&
+         ecx_poperror(&ecatContext_, &error)) {
+    handler(error);
+  }
+  return true;
+}
+
+std::vector<uint16_t> EthercatBus::getEoeSlaves() const {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  std::vector<uint16_t> slaves;
+  for (int slave = 1; slave <= ecatSlavecount_; slave++) {
+    if (ecatSlavelist_[slave].mbx_proto & ECT_MBXPROT_EOE) {
+      slaves.push_back(static_cast<uint16_t>(slave));
+    }
+  }
+  return slaves;
+}
+
+size_t EthercatBus::getEoeFragmentSize(uint16_t slave) const {
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  const size_t mailboxSize = ecatSlavelist_[slave].mbx_l;
+  if (mailboxSize <= eoeHeaderSize) {
+    return 0;
+  }
+  return std::min<size_t>(mailboxSize - eoeHeaderSize, EC_MAXEOEDATA) / eoeFragmentAlignment * eoeFragmentAlignment;
+}
+
+bool EthercatBus::sendEoeFragment(uint16_t slave, const uint8_t* frame, size_t frameSize, size_t offset, size_t size, uint8_t fragmentNumber,
+                                  uint8_t frameNumber) {
+  // the mapped SM0 status of the last mailbox status read: the slave did not take the previous mailbox yet.
+  if (slave < outMailboxFull_.size() && outMailboxFull_[slave]) {
+    return false;
+  }
+  ec_mbxbuft mailbox;
+  ec_clearmbx(&mailbox);
+  ec_EOEt* eoe = reinterpret_cast<ec_EOEt*>(&mailbox);
+  const bool lastFragment = offset + size == frameSize;
+  const uint16 frameInfo1 = EOE_HDR_FRAME_TYPE_SET(EOE_FRAG_DATA) | EOE_HDR_LAST_FRAGMENT_SET(lastFragment ? 1 : 0);
+  // the first fragment carries the frame size, the others their offset, both in 32 byte blocks.
+  const uint16 blocks = static_cast<uint16>(fragmentNumber == 0 ? (frameSize + eoeFragmentAlignment - 1) / eoeFragmentAlignment
+                                                                : offset / eoeFragmentAlignment);
+  const uint16 frameInfo2 =
+      EOE_HDR_FRAG_NO_SET(fragmentNumber) | EOE_HDR_FRAME_OFFSET_SET(blocks) | EOE_HDR_FRAME_NO_SET(frameNumber & 0x0f);
+  MailboxArea area;
+  uint8 count = 0;
+  {
+    // the counter is taken even if the write fails, the slave only rejects a repeated counter.
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    ec_slavet& slaveInfo = ecatSlavelist_[slave];
+    count = ec_nextmbxcnt(slaveInfo.mbx_cnt);
+    slaveInfo.mbx_cnt = count;
+    area.configuredAddress = slaveInfo.configadr;
+    area.writeOffset = slaveInfo.mbx_wo;
+    area.writeLength = slaveInfo.mbx_l;
+  }
+  eoe->mbxheader.length = htoes(static_cast<uint16>(eoeHeaderSize - sizeof(ec_mbxheadert) + size));
+  eoe->mbxheader.mbxtype = static_cast<uint8>(ECT_MBXT_EOE + (count << 4));
+  eoe->frameinfo1 = htoes(frameInfo1);
+  eoe->frameinfo2 = htoes(frameInfo2);
+  std::memcpy(eoe->data, frame + offset, size);
+  // written without the SM0 status read of ecx_mbxsend, the ESC rejects a write to a full mailbox.
+  return ecx_FPWR(ecatContext_.port, area.configuredAddress, area.writeOffset, area.writeLength, &mailbox, EC_TIMEOUTRET) > 0;
+}
+
+bool EthercatBus::writeFirmware(uint16_t slave, const std::string& fileName, uint32_t password, const std::vector<char>& image,
+                                const FirmwareProgressCallback& progress, int timeoutUs) {
+  if (slave == 0 || slave > ecatSlavecount_ || !beginFoeTransfer(slave, progress)) {
+    return false;
+  }
+  std::vector<char> name(fileName.begin(), fileName.end());
+  name.push_back('\0');
+  // SOEM does not modify the data, the interface is not const correct.
+  const int workingCounter = runFoeTransfer([&](ecx_contextt* context) {
+    return ecx_FOEwrite(context, slave, name.data(), password, static_cast<int>(image.size()), const_cast<char*>(image.data()), timeoutUs);
+  });
+  endFoeTransfer(slave);
+  return workingCounter > 0;
+}
+
+bool EthercatBus::readFirmware(uint16_t slave, const std::string& fileName, uint32_t password, std::vector<char>& image, int timeoutUs) {
+  if (slave == 0 || slave > ecatSlavecount_ || !beginFoeTransfer(slave, nullptr)) {
+    return false;
+  }
+  std::vector<char> name(fileName.begin(), fileName.end());
+  name.push_back('\0');
+  int size = static_cast<int>(image.size());
+  const int workingCounter =
+      runFoeTransfer([&](ecx_contextt* context) { return ecx_FOEread(context, slave, name.data(), password, &size, image.data(), timeoutUs); });
+  endFoeTransfer(slave);
+  if (workingCounter <= 0) {
+    return false;
+  }
+  image.resize(static_cast<size_t>(size));
+  return true;
+}
+
+int EthercatBus::runFoeTransfer(const std::function<int(ecx_contextt* context)>& transfer) {
+  // a copy of the context with an error list of its own: ecx_mbxreceive() pushes the errors of the transfer without a
+  // lock, which would race with pushEmergency() and popEmergencies().
+  ec_eringt errorList;
+  std::memset(&errorList, 0, sizeof(errorList));
+  boolean errorFlag = FALSE;
+  ecx_contextt context;
+  {
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    context = ecatContext_;
+  }
+  context.elist = &errorList;
+  context.ecaterror = &errorFlag;
+  const int workingCounter = transfer(&context);
+
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  ec_errort error;
+  while (ecx_poperror(&context, &error)) {
+    ecx_pusherror(&ecatContext_, &error);
+  }
+  return workingCounter;
+}
+
+bool EthercatBus::beginFoeTransfer(uint16_t slave, const FirmwareProgressCallback& progress) {
+  {
+    std::lock_guard<std::mutex> lock(foeProgressMutex);
+    if (!foeProgressCallbacks.emplace(std::make_pair(&ecatContext_, slave), progress).second) {
+      MELO_ERROR_STREAM("[EthercatBus::" << name_ << "] FoE transfer to slave " << slave << " already in progress.")
+      return false;
+    }
+  }
+  foeContext = &ecatContext_;
+  beginMailboxTransfer(slave);
+  return true;
+}
+
+void EthercatBus::endFoeTransfer(uint16_t slave) {
+  endMailboxTransfer(slave);
+  foeContext = nullptr;
+  std::lock_guard<std::mutex> lock(foeProgressMutex);
+  foeProgressCallbacks.erase({&ecatContext_, slave});
+}
+
+bool EthercatBus::enterBootState(uint16_t slave) {
+  if (slave == 0 || slave > ecatSlavecount_) {
+    return false;
+  }
+  ec_slavet& slaveInfo = ecatSlavelist_[slave];
+  ecx_portt* port = ecatContext_.port;
+  const uint16 configadr = slaveInfo.configadr;
+
+  if (!requestSlaveState(slave, EC_STATE_INIT | EC_STATE_ACK)) {
+    return false;
+  }
+  {
+    // the mailbox service and the SDO transfers use the mailbox of the slave list.
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    // offset in the low word, size in the high word.
+    const uint32 bootRx = etohl(ecx_readeeprom(&ecatContext_, slave, ECT_SII_BOOTRXMBX, EC_TIMEOUTEEP));
+    const uint32 bootTx = etohl(ecx_readeeprom(&ecatContext_, slave, ECT_SII_BOOTTXMBX, EC_TIMEOUTEEP));
+    ecx_eeprom2pdi(&ecatContext_, slave);
+    const auto rxOffset = static_cast<uint16>(bootRx & 0xffff);
+    const auto rxSize = static_cast<uint16>(bootRx >> 16);
+    const auto txOffset = static_cast<uint16>(bootTx & 0xffff);
+    const auto txSize = static_cast<uint16>(bootTx >> 16);
+    if (rxSize == 0 || txSize == 0 || rxSize == 0xffff || txSize == 0xffff) {
+      MELO_ERROR_STREAM("[EthercatBus::" << name_ << "] Slave " << slave << " has no boot mailbox.")
+      return false;
+    }
+
+    // the standard mailbox is kept until leaveBootState(), entering BOOT again keeps the first copy.
+    standardMailboxes_.emplace(
+        slave, StandardMailbox{slaveInfo.SM[0], slaveInfo.SM[1], slaveInfo.mbx_wo, slaveInfo.mbx_l, slaveInfo.mbx_ro, slaveInfo.mbx_rl});
+    slaveInfo.SM[0].StartAddr = htoes(rxOffset);
+    slaveInfo.SM[0].SMlength = htoes(rxSize);
+    slaveInfo.SM[1].StartAddr = htoes(txOffset);
+    slaveInfo.SM[1].SMlength = htoes(txSize);
+    // slaves without standard mailbox get the default mailbox sync manager configuration.
+    if (slaveInfo.SM[0].SMflags == 0) {
+      slaveInfo.SM[0].SMflags = htoel(EC_DEFAULTMBXSM0);
+    }
+    if (slaveInfo.SM[1].SMflags == 0) {
+      slaveInfo.SM[1].SMflags = htoel(EC_DEFAULTMBXSM1);
+    }
+    slaveInfo.mbx_wo = rxOffset;
+    slaveInfo.mbx_l = rxSize;
+    slaveInfo.mbx_ro = txOffset;
+    slaveInfo.mbx_rl = txSize;
+    if (ecx_FPWR(port, configadr, ECT_REG_SM0, sizeof(ec_smt), &slaveInfo.SM[0], EC_TIMEOUTRET3) <= 0 ||
+        ecx_FPWR(port, configadr, ECT_REG_SM1, sizeof(ec_smt), &slaveInfo.SM[1], EC_TIMEOUTRET3) <= 0) {
+      restoreStandardMailbox(slave);
+      return false;
+    }
+  }
+
+  if (!requestSlaveState(slave, EC_STATE_BOOT)) {
+    MELO_ERROR_STREAM("[EthercatBus::" << name_ << "] Slave " << slave << " did not enter BOOT.")
+    requestSlaveState(slave, EC_STATE_INIT | EC_STATE_ACK);
+    std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+    restoreStandardMailbox(slave);
+    return false;
+  }
+  return true;
+}
+
+bool EthercatBus::leaveBootState(uint16_t slave) {
+  if (slave == 0 || slave > ecatSlavecount_) {
+    return false;
+  }
+  if (!requestSlaveState(slave, EC_STATE_INIT)) {
+    return false;
+  }
+  std::lock_guard<std::recursive_mutex> lock(contextMutex_);
+  restoreStandardMailbox(slave);
+  return true;
+}
+
+void EthercatBus::restoreStandardMailbox(uint16_t slave) {
+  const auto standardMailbox = standardMailboxes_.find(slave);
+  if (standardMailbox == standardMailboxes_.end()) {
+    return;
+  }
+  ec_slavet& slaveInfo = ecatSlavelist_[slave];
+  slaveInfo.SM[0] = standardMailbox->second.rxSyncManager;
+  slaveInfo.SM[1] = standardMailbox->second.txSyncManager;
+  slaveInfo.mbx_wo = standardMailbox->second.rxOffset;
+  slaveInfo.mbx_l = standardMailbox->second.rxSize;
+  slaveInfo.mbx_ro = standardMailbox->second.txOffset;
+  slaveInfo.mbx_rl = standardMailbox->second.txSize;
+  standardMailboxes_.erase(standardMailbox);
+  // a slave without standard mailbox gets its sync managers disabled.
+  ecx_FPWR(ecatContext_.port, slaveInfo.configadr, ECT_REG_SM0, sizeof(ec_smt), &slaveInfo.SM[0], EC_TIMEOUTRET3);
+  ecx_FPWR(ecatContext_.port, slaveInfo.configadr, ECT_REG_SM1, sizeof(ec_smt), &slaveInfo.SM[1], EC_TIMEOUTRET3);
+}
+
+}  // namespace ecat_master
@@ -16,11 +16,169 @@
 
 #include "ethercat_sdk_master/EthercatDevice.hpp"
 
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 namespace ecat_master{
 
 void EthercatDevice::setTimeStep(double timeStep){
   timeStep_ = timeStep;
 }
+
+bool EthercatDevice::configurePdoMappingProfile(const PdoMappingProfile& profile){
+  auto writeAssignment = [this](uint16_t index, const std::vector<uint16_t>& pdos){
+    // the assignment can only be changed while it is empty.
+    bool success = cachedSdoWrite(index, 0, false, static_cast<uint8_t>(0));
+    for (size_t i = 0; i < pdos.size() && success; i++){
+      success &= cachedSdoWrite(index, static_cast<uint8_t>(i + 1), false, pdos[i]);
+    }
+    return success && cachedSdoWrite(index, 0, false, static_cast<uint8_t>(pdos.size()));
+  };
+  return writeAssignment(0x1C12, profile.rxPdoAssignment) && writeAssignment(0x1C13, profile.txPdoAssignment);
+}
+
+void EthercatDevice::invalidateSdoCache(const uint16_t index, const uint8_t subindex){
+  std::lock_guard<std::recursive_mutex> lock(sdoCacheMutex_);
+  bool persistent = false;
+  for (const bool completeAccess : {false, true}){
+    const auto entry = sdoCache_.find(SdoCacheKey{index, subindex, completeAccess});
+    if (entry != sdoCache_.end()){
+      persistent |= entry->second.persistent;
+      sdoCache_.erase(entry);
+    }
+  }
+  sdoDiskCacheDirty_ |= persistent && sdoDiskCacheEnabled_;
+}
+
+void EthercatDevice::invalidateSdoCache(){
+  std::lock_guard<std::recursive_mutex> lock(sdoCacheMutex_);
+  sdoCache_.clear();
+  if (!sdoCacheFile_.empty()){
+    std::error_code error;
+    std::filesystem::remove(sdoCacheFile_, error);
+  }
+  // the identity might have changed as well.
+  sdoCacheFile_.clear();
+  sdoDiskCacheLoaded_ = false;
+  sdoDiskCacheDirty_ = false;
+}
+
+void EthercatDevice::setSdoDiskCacheEnabled(bool enabled){
+  std::lock_guard<std::recursive_mutex> lock(sdoCacheMutex_);
+  sdoDiskCacheEnabled_ = enabled;
+  sdoDiskCacheLoaded_ = false;
+}
+
+bool EthercatDevice::flushSdoCache(){
+  std::lock_guard<std::recursive_mutex> lock(sdoCacheMutex_);
+  if (!sdoDiskCacheDirty_ || !sdoDiskCacheEnabled_){
+    return true;
+  }
+  const bool saved = saveSdoCache();
+  // without a disk cache file (no identity or serial number) there is nothing to retry.
+  if (saved || sdoCacheFile_.empty()){
+    sdoDiskCacheDirty_ = false;
+  }
+  return saved;
+}
+
+std::string EthercatDevice::getSdoCacheFile(){
+  if (!sdoCacheFile_.empty()){
+    return sdoCacheFile_;
+  }
+  const char* home = std::getenv("HOME");
+  uint32_t vendorId = 0;
+  uint32_t productCode = 0;
+  uint32_t revision = 0;
+  uint32_t serialNumber = 0;
+  if (home == nullptr || !sendSdoRead(0x1018, 1, false, vendorId) || !sendSdoRead(0x1018, 2, false, productCode) ||
+      !sendSdoRead(0x1018, 3, false, revision)){
+    return "";
+  }
+  // optional in CiA 301. Without it two slaves of the same type would share a cache.
+  if (!sendSdoRead(0x1018, 4, false, serialNumber) || serialNumber == 0){
+    return "";
+  }
+  std::stringstream ss;
+  ss << home << "/.ethercat_master/sdo_cache/" << std::hex << std::setfill('0') << std::setw(8) << vendorId << "_" << std::setw(8)
+     << productCode << "_" << std::setw(8) << revision << "_" << std::setw(8) << serialNumber << ".cache";
+  sdoCacheFile_ = ss.str();
+  return sdoCacheFile_;
+}
+
+bool EthercatDevice::loadSdoCache(){
+  std::lock_guard<std::recursive_mutex> lock(sdoCacheMutex_);
+  sdoDiskCacheLoaded_ = true;
+  const std::string fileName = getSdoCacheFile();
+  if (fileName.empty()){
+    return false;
+  }
+  std::ifstream file(fileName);
+  if (!file){
+    return false;
+  }
+  // one object per line: index subindex completeAccess size bytes (hex)
+  std::string line;
+  while (std::getline(file, line)){
+    std::istringstream ss(line);
+    unsigned int index = 0;
+    unsigned int subindex = 0;
+    bool completeAccess = false;
+    size_t size = 0;
+    if (!(ss >> std::hex >> index >> subindex >> completeAccess >> size)){
+      continue;
+    }
+    SdoCacheEntry entry;
+    entry.persistent = true;
+    unsigned int byte = 0;
+    while (entry.data.size() < size && ss >> byte){
+      entry.data.push_back(static_cast<uint8_t>(byte));
+    }
+    const SdoCacheKey key{static_cast<uint16_t>(index), static_cast<uint8_t>(subindex), completeAccess};
+    // objects read or written in this session are more recent.
+    if (entry.data.size() == size && sdoCache_.find(key) == sdoCache_.end()){
+      sdoCache_.emplace(key, std::move(entry));
+    }
+  }
+  return true;
+}
+
+bool EthercatDevice::saveSdoCache(){
+  std::lock_guard<std::recursive_mutex> lock(sdoCacheMutex_);
+  const std::string fileName = getSdoCacheFile();
+  if (fileName.empty()){
+    return false;
+  }
+  std::error_code error;
+  std::filesystem::create_directories(std::filesystem::path(fileName).parent_path(), error);
+  // write a temporary file and rename it, devices of the same type might share the directory.
+  const std::string temporaryFileName = fileName + ".tmp";
+  {
+    std::ofstream file(temporaryFileName, std::ios::trunc);
+    if (!file){
+      return false;
+    }
+    file << std::hex;
+    for (const auto& entry : sdoCache_){
+      if (!entry.second.persistent){
+        continue;
+      }
+      file << std::get<0>(entry.first) << " " << static_cast<unsigned int>(std::get<1>(entry.first)) << " " << std::get<2>(entry.first)
+           << " " << entry.second.data.size();
+      for (const auto byte : entry.second.data){
+        file << " " << static_cast<unsigned int>(byte);
+      }
+      file << "\n";
+    }
+    if (!file){
+      return false;
+    }
+  }
+  std::filesystem::rename(temporaryFileName, fileName, error);
+  return !error;
+}
 } // namespace ecat_master
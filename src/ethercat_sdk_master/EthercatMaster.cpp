@@ -22,14 +22,34 @@
 
 #include "ethercat_sdk_master/EthercatMaster.hpp"
 #include <pthread.h>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <filesystem>
+#include <sstream>
 #include <thread>
 #include "message_logger/message_logger.hpp"
 
 #define SLEEP_EARLY_STOP_NS (50000) // less than 1e9 - 1!!
 #define BILLION (1000000000)
+#define MAILBOX_SERVICE_DECIMATION (10)
+#define BUS_DIAGNOSIS_DECIMATION (200)
+#define SLAVE_STATE_MONITOR_INTERVAL_MS (100)
+#define SYNC0_UPDATE_CHECK_INTERVAL_MS (100)
+// a recovery request of the update thread is served at the next check.
+#define SLAVE_RECOVERY_CHECK_INTERVAL_MS (100)
+// pause after the first failed recovery of a slave, doubled after every further failure up to the maximum.
+#define SLAVE_RECOVERY_RETRY_DELAY_MIN_MS (1000)
+#define SLAVE_RECOVERY_RETRY_DELAY_MAX_MS (60000)
+// the mailbox service thread pushes, the dispatch thread pops every dispatch interval.
+#define EMERGENCY_QUEUE_CAPACITY (256)
+#define EMERGENCY_DISPATCH_INTERVAL_MS (10)
+// the swap takes one cycle, the timeout covers slow update loops.
+#define PDO_MAPPING_SWAP_TIMEOUT_CYCLES (100)
+// cycles longer than the time step by this factor are outliers.
+#define PERF_COUNTER_OUTLIER_NUMERATOR (11)
+#define PERF_COUNTER_OUTLIER_DENOMINATOR (10)
 
 namespace ecat_master
 {
@@ -39,8 +59,42 @@ namespace ecat_master
     using namespace std::chrono_literals;
     devices_.clear();
     configuration_ = configuration;
+    if (!configuration_.eoeInterfacePrefix.empty() && configuration_.eoeBytesPerRound < EoeGateway::fragmentAlignment)
+    {
+      // a budget below one block would round every fragment down to nothing and stall the tunnel.
+      MELO_WARN_STREAM("[EthercatMaster::" << configuration_.name << "] eoeBytesPerRound " << configuration_.eoeBytesPerRound
+                                           << " is below one EoE fragment block, using " << EoeGateway::fragmentAlignment << " bytes.")
+      configuration_.eoeBytesPerRound = static_cast<unsigned int>(EoeGateway::fragmentAlignment);
+    }
+    // the process images of the new configuration may differ in size, the samples are allocated by startup().
+    for (auto &inputSnapshot : inputSnapshots_)
+    {
+      inputSnapshot = std::make_shared<InputSnapshotBuffer>();
+    }
+
+    acyclicScheduler_.clear();
+    // the mailboxes (emergencies, EoE tunnel) and the slave states are serviced by threads of their own, see
+    // startMailboxService() and startSlaveStateMonitor(). Their runs are granted within the budget like the tasks, the
+    // mailbox service with safety priority: the emergencies must not be deferred by diagnostics or parameter work.
+    if (configuration_.mapMailboxStatus || configuration_.collectEmergencies || !configuration_.eoeInterfacePrefix.empty())
+    {
+      acyclicScheduler_.addService("mailbox service", AcyclicPriority::Safety, MAILBOX_SERVICE_DECIMATION, mailboxService_);
+    }
+    if (configuration_.doBusDiagnosis || configuration_.slaveRecovery)
+    {
+      acyclicScheduler_.addService("slave state monitor", AcyclicPriority::Diagnostics, getSlaveStateMonitorCycles(configuration_.timeStep),
+                                   slaveStateMonitorService_);
+    }
+    if (configuration_.doBusDiagnosis)
+    {
+      // every 200 pdo cycles a diagnosis datagram is sent, it swaps between error counter or state depending on config.
+      acyclicScheduler_.addTask("bus diagnosis", AcyclicPriority::Diagnostics, BUS_DIAGNOSIS_DECIMATION, [this]() { doBusDiagnosis(); });
+    }
 
-    timestepNs_ = floor(configuration.timeStep * 1e9);
+    timestepNs_ = static_cast<long>(floor(configuration.timeStep * 1e9));
+    timeStep_ = configuration.timeStep;
+    cycleContext_ = CycleContext{};
+    cycleContext_.timeStepNs = timestepNs_;
     if (configuration_.logErrorCounters)
     {
       auto getFolderSize = [](const std::string &folderPath) -> uintmax_t
@@ -94,26 +148,51 @@ namespace ecat_master
 
   EthercatMasterConfiguration EthercatMaster::getConfiguration()
   {
-    return configuration_;
+    EthercatMasterConfiguration configuration = configuration_;
+    configuration.timeStep = timeStep_;
+    return configuration;
   }
 
   void EthercatMaster::createEthercatBus()
   {
-    bus_.reset(new soem_interface_rsl::EthercatBusBase(configuration_.networkInterface));
+    bus_.reset(new EthercatBus(configuration_.networkInterface));
+    bus_->setRedundantInterface(configuration_.redundantNetworkInterface);
+    // a reloaded configuration without segment must not keep the bus of the previous one.
+    if (!configuration_.segmentNetworkInterface.empty())
+    {
+      segmentBus_.reset(new EthercatBus(configuration_.segmentNetworkInterface));
+    }
+    else
+    {
+      segmentBus_.reset();
+    }
   }
 
   bool EthercatMaster::attachDevice(EthercatDevice::SharedPtr device)
+  {
+    return attachDevice(device, 0);
+  }
+
+  bool EthercatMaster::attachDevice(EthercatDevice::SharedPtr device, unsigned int segment)
   {
     if (deviceExists(device->getName()))
     {
       MELO_ERROR_STREAM("Cannot attach device with name '" << device->getName() << "' because it already exists.");
       return false;
     }
-    bus_->addSlave(device);
-    device->setEthercatBusBasePointer(bus_.get());
-    device->setTimeStep(configuration_.timeStep);
-    devices_.push_back(device);
-    MELO_DEBUG_STREAM("Attached device '" << device->getName() << "' to address " << device->getAddress());
+    EthercatBus *bus = getSegmentBus(segment);
+    if (bus == nullptr)
+    {
+      MELO_ERROR_STREAM("Cannot attach device with name '" << device->getName() << "' to segment " << segment
+                                                           << ", the segment is not configured.");
+      return false;
+    }
+    bus->addSlave(device);
+    device->setEthercatBusBasePointer(bus);
+    device->setTimeStep(timeStep_);
+    device->setCycleContext(&cycleContext_);
+    devices_.add(device, segment);
+    MELO_DEBUG_STREAM("Attached device '" << device->getName() << "' to address " << device->getAddress() << " on " << bus->getName());
     return true;
   }
 
@@ -121,38 +200,151 @@ namespace ecat_master
   {
     bool success = true;
 
+    if (segmentBus_ && !configuration_.eoeInterfacePrefix.empty())
+    {
+      // the EoE gateway tunnels the slaves of a single bus.
+      MELO_ERROR_STREAM("[EthercatMaster::" << bus_->getName() << "] EoE is not supported on a bus split into segments.")
+      return false;
+    }
+
     success &= bus_->startup(abortFlag, configuration_.pdoSizeCheck, configuration_.slaveDiscoverRetries);
+    if (segmentBus_ && success)
+    {
+      success &= segmentBus_->startup(abortFlag, configuration_.pdoSizeCheck, configuration_.slaveDiscoverRetries);
+      if (!success)
+      {
+        // the first segment is already up, leave it in INIT. shutdown() closes the sockets of both segments.
+        bus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::INIT);
+      }
+    }
     if (!success)
     {
       return false;
     }
 
-    for (const auto &device : devices_)
+    if (configuration_.numaPlacement)
+    {
+      placeOnNumaNode();
+    }
+
+    for (size_t i = 0; i < devices_.size(); i++)
     {
+      const auto &device = devices_[i];
       MELO_INFO_STREAM("Waiting for device: " << device->getName() << " Address: " << device->getAddress());
-      if (!bus_->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP, device->getAddress(), 50))
+      if (!getSegmentBus(devices_.getSegment(i))->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP, device->getAddress(), 50))
       {
         MELO_ERROR_STREAM("[EthercatMaster::" << bus_->getName() << "] not in SAFE_OP after startup!");
       }
     }
+    if (configuration_.optimizeProcessImageLayout)
+    {
+      for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+      {
+        std::vector<uint16_t> hotSlaves;
+        for (size_t i = 0; i < devices_.size(); i++)
+        {
+          const auto &hotDevices = configuration_.hotDevices;
+          if (devices_.getSegment(i) == segment && std::find(hotDevices.begin(), hotDevices.end(), devices_[i]->getName()) != hotDevices.end())
+          {
+            hotSlaves.push_back(static_cast<uint16_t>(devices_[i]->getAddress()));
+          }
+        }
+        EthercatBus *bus = getSegmentBus(segment);
+        if (!bus->optimizeProcessImageLayout(hotSlaves))
+        {
+          MELO_INFO_STREAM("[EthercatMaster::" << bus->getName() << "] Keeping the process image layout of SOEM.")
+        }
+      }
+      MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] " << getProcessImageLayout().toString())
+      if (segmentBus_)
+      {
+        MELO_INFO_STREAM("[EthercatMaster::" << segmentBus_->getName() << "] " << segmentBus_->getProcessImageLayout().toString())
+      }
+    }
+    else
+    {
+      MELO_DEBUG_STREAM("[EthercatMaster::" << bus_->getName() << "] " << getProcessImageLayout().toString())
+    }
+    precomputePdoMappingLayouts();
+    // the process images do not move after the startup, the PDO mapping profiles only shrink the slave areas.
+    for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+    {
+      inputImages_[segment] = getSegmentBus(segment)->getInputImage();
+      if (!inputSnapshots_[segment]->configure(inputImages_[segment].size))
+      {
+        MELO_ERROR_STREAM("[EthercatMaster::" << getSegmentBus(segment)->getName()
+                                              << "] Input snapshot buffer configured for another process image, reload the configuration.")
+      }
+    }
+    // the object dictionary caches were filled by the startup of the devices.
+    for (const auto &device : devices_)
+    {
+      device->flushSdoCache();
+    }
+
+    if (configuration_.mapMailboxStatus)
+    {
+      for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+      {
+        EthercatBus *bus = getSegmentBus(segment);
+        const unsigned int mappedSlaves = bus->mapMailboxStatus();
+        MELO_INFO_STREAM("[EthercatMaster::" << bus->getName() << "] Mailbox status of " << mappedSlaves
+                                             << " slaves mapped, the remaining mailbox slaves are polled.")
+      }
+    }
+
+    if (!configuration_.eoeInterfacePrefix.empty())
+    {
+      const unsigned int tunnels = eoeGateway_.open(*bus_, configuration_.eoeInterfacePrefix);
+      MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] EoE tunnel to " << tunnels << " slaves.")
+    }
+
+    // created before the update thread runs, notify() only writes to it.
+    if (!cycleNotification_.open())
+    {
+      MELO_WARN_STREAM("[EthercatMaster::" << bus_->getName() << "] Cannot create the cycle notification eventfd.")
+    }
+
+    startEmergencyDispatch();
+    startMailboxService();
+    startSync0Update();
+
+    if (configuration_.detectInputChanges)
+    {
+      bus_->enableInputChangeDetection();
+      if (segmentBus_)
+      {
+        segmentBus_->enableInputChangeDetection();
+      }
+    }
+
+    for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+    {
+      EthercatBus *bus = getSegmentBus(segment);
+      linkFaultLocalizers_[segment].setTopology(bus->getTopology());
+      slaveStateTrackers_[segment].reset(static_cast<size_t>(bus->getNumberOfSlaves()));
+      slaveStates_[segment] = std::vector<std::atomic<uint32_t>>(static_cast<size_t>(bus->getNumberOfSlaves()));
+    }
 
-    // write the header of the diagnosis log
+    // write the header of the diagnosis log, a block of columns per segment: the AL status code of the bus and the columns
+    // of its slaves.
     if (configuration_.logErrorCounters)
     {
       if (busDiagnosisLogFile_)
       {
         std::lock_guard busDiagStreamLock(logFileStreamMutex_);
-        busDiagnosisLogFile_ << "Time, " << configuration_.networkInterface << ", ";
-        for (size_t slaveCount = 0; slaveCount < devices_.size(); slaveCount++)
+        busDiagnosisLogFile_ << "Time";
+        for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
         {
-          for (size_t regCount = 0; regCount < static_cast<size_t>(soem_interface_rsl::REG::ERROR_COUNTERS::SIZE); regCount++)
+          EthercatBus *bus = getSegmentBus(segment);
+          busDiagnosisLogFile_ << ", " << (segment == 0 ? configuration_.networkInterface : configuration_.segmentNetworkInterface);
+          for (int slave = 1; slave <= bus->getNumberOfSlaves(); slave++)
           {
-            busDiagnosisLogFile_ << devices_[slaveCount]->getName(); // For every error register a column.
-            bool lastElement =
-                (slaveCount == devices_.size() - 1) && (regCount == static_cast<size_t>(soem_interface_rsl::REG::ERROR_COUNTERS::SIZE) - 1);
-            if (!lastElement)
+            // For every error register and the AL state and AL status code of the slave a column.
+            const std::string deviceName = getDeviceName(static_cast<uint16_t>(slave), segment);
+            for (size_t regCount = 0; regCount < static_cast<size_t>(soem_interface_rsl::REG::ERROR_COUNTERS::SIZE) + 2; regCount++)
             {
-              busDiagnosisLogFile_ << ", ";
+              busDiagnosisLogFile_ << ", " << deviceName;
             }
           }
         }
@@ -164,22 +356,21 @@ namespace ecat_master
 
         busDiagnosisLogFile_ << "\n"
                              << ss.str();
-        busDiagnosisLogFile_ << ", ALStatusCode, "; // DLStatus
-        for (size_t slaveCount = 0; slaveCount < devices_.size(); slaveCount++)
+        for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
         {
-          for (size_t regCount = 0; regCount < static_cast<size_t>(soem_interface_rsl::REG::ERROR_COUNTERS::SIZE); regCount++)
+          EthercatBus *bus = getSegmentBus(segment);
+          busDiagnosisLogFile_ << ", ALStatusCode"; // DLStatus
+          for (int slave = 1; slave <= bus->getNumberOfSlaves(); slave++)
           {
-            busDiagnosisLogFile_ << soem_interface_rsl::REG::ERROR_COUNTERS_LIST.Registers[regCount].name;
-            bool lastElement =
-                (slaveCount == devices_.size() - 1) && (regCount == static_cast<size_t>(soem_interface_rsl::REG::ERROR_COUNTERS::SIZE) - 1);
-            if (!lastElement)
+            for (size_t regCount = 0; regCount < static_cast<size_t>(soem_interface_rsl::REG::ERROR_COUNTERS::SIZE); regCount++)
             {
-              busDiagnosisLogFile_ << ", ";
+              busDiagnosisLogFile_ << ", " << soem_interface_rsl::REG::ERROR_COUNTERS_LIST.Registers[regCount].name;
             }
+            busDiagnosisLogFile_ << ", SlaveALState, SlaveALStatusCode";
           }
+          busDiagnosisLogs_[segment].errorCounters_.resize(static_cast<size_t>(bus->getNumberOfSlaves()));
         }
         busDiagnosisLogFile_ << std::endl; // this flushes.
-        busDiagnosisLog_.errorCounters_.resize(devices_.size());
       }
       else
       {
@@ -187,6 +378,8 @@ namespace ecat_master
       }
     }
 
+    MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] Bus capacity:\n" << estimateBusCapacity().toString())
+
     if (!success)
       MELO_ERROR("[ethercat_sdk_master:EthercatMaster::startup] Startup not successful.");
     return success;
@@ -205,22 +398,31 @@ namespace ecat_master
     clock_gettime(CLOCK_MONOTONIC, &lastWakeup_);
     sleepEnd_ = lastWakeup_;
 
+    resetCycleStatistics();
     for (int i = 0; i < 200; i++)
     {
-      bus_->updateWrite();
-      bus_->updateRead();
+      exchangeProcessData();
       createUpdateHeartbeat(true);
     }
+    MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] Bus capacity (measured):\n" << estimateBusCapacity().toString())
 
-    for (auto &device : devices_)
+    for (size_t i = 0; i < devices_.size(); i++)
     {
-      bus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::OPERATIONAL, device->getAddress());
-      success &= bus_->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::OPERATIONAL, device->getAddress(), 10);
+      const auto &device = devices_[i];
+      getSegmentBus(devices_.getSegment(i))->setState(soem_interface_rsl::ETHERCAT_SM_STATE::OPERATIONAL, device->getAddress());
+      success &= getSegmentBus(devices_.getSegment(i))->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::OPERATIONAL, device->getAddress(), 10);
       if (!success)
       {
         MELO_ERROR_STREAM("Failed to put device: " << device->getName() << ": " << device->getAddress() << " EC_STATE_OPERATIONAL");
       }
     }
+    startSlaveStateMonitor();
+    startSlaveRecovery();
+    startStallWatchdog();
+    if (configuration_.periodicityWindow > 0)
+    {
+      periodicityDetector_.start(configuration_.periodicityWindow);
+    }
     // will only be used in case internal update timing functionality is used, otherwise no effect.
     return success;
   }
@@ -230,62 +432,78 @@ namespace ecat_master
     // is there any action on the slaves needed?, the slaves EC SM and Drive SM should take care of it?
 
     bool success = true;
+    stopSlaveRecovery();
+    stopSlaveStateMonitor();
+    stopStallWatchdog();
+    periodicityDetector_.stop();
     bus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP);
+    if (segmentBus_)
+    {
+      segmentBus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP);
+      success &= segmentBus_->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP, 0, 0);
+    }
     success &= bus_->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP, 0, 0);
     return success;
   }
 
   void EthercatMaster::update(UpdateMode updateMode)
   {
+    updateThread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    updateCount_.fetch_add(1, std::memory_order_relaxed);
+    if (updateMode == UpdateMode::ExternalTrigger)
+    {
+      waitForTrigger();
+    }
+    stallWatchdog_.heartbeat();
+    if (configuration_.numaPlacement && !numaThreadPinned_)
+    {
+      pinUpdateThread();
+    }
+    if (pendingTimeStep_.load(std::memory_order_relaxed) != 0.0)
+    {
+      applyTimeStep(pendingTimeStep_.exchange(0.0));
+    }
+    if (pdoMappingSwitchPending_.load(std::memory_order_relaxed))
+    {
+      applyPendingPdoMappingProfile();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &cycleStart_);
+    updateCycleContext();
+    if (configuration_.perfCounters)
+    {
+      samplePerfCounters();
+    }
+    if (periodicityDetector_.isRunning())
+    {
+      samplePeriodicity(updateMode);
+    }
 
-    bus_->updateWrite();
-    bus_->updateRead();
-
-    // log
-    if (configuration_.doBusDiagnosis)
+    exchangeProcessData();
+    for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
     {
-      if (busDiagDecimationCount_ >
-          200)
-      { // after 100 pdo cycles a 1 diagnosis datagram send, this datagram swaps between error counter or state depending on config.
-        bus_->doBusMonitoring(configuration_.logErrorCounters);
-        if (configuration_.logErrorCounters)
-        {
-          bool diagUpdated = bus_->getBusDiagnosisLog(busDiagnosisLog_);
-          if (diagUpdated)
-          { // will only be fully after some runs, depends on number of slaves on the bus.
-            MELO_DEBUG_STREAM("[EcatMaster::" << bus_->getName() << "::Update] Writing log to file (or buffer)")
-            // write the error counter to the file:
-            auto currentTime = std::chrono::system_clock::now();
-            auto msSinceStart =
-                std::chrono::duration_cast<std::chrono::milliseconds>(currentTime.time_since_epoch() - logStartTime_.time_since_epoch());
-            std::chrono::seconds secondsSinceStart = std::chrono::duration_cast<std::chrono::seconds>(msSinceStart);
-            std::chrono::milliseconds millisecondsSinceStart =
-                std::chrono::duration_cast<std::chrono::milliseconds>(msSinceStart % std::chrono::seconds(1));
-            std::lock_guard busDiagStreamLock(logFileStreamMutex_);
-            busDiagnosisLogFile_ << secondsSinceStart.count() << "." << std::setw(3) << std::setfill('0') << millisecondsSinceStart.count()
-                                 << ", ";
-            busDiagnosisLogFile_ << busDiagnosisLog_.ecatApplicationLayerStatus << ", ";
-            for (size_t slaveCount = 0; slaveCount < busDiagnosisLog_.errorCounters_.size(); slaveCount++)
-            {
-              for (size_t errorRegCount = 0; errorRegCount < static_cast<size_t>(soem_interface_rsl::REG::ERROR_COUNTERS::SIZE);
-                   errorRegCount++)
-              {
-                busDiagnosisLogFile_ << busDiagnosisLog_.errorCounters_[slaveCount][errorRegCount].fullValue;
-                bool lastEntry = (slaveCount == busDiagnosisLog_.errorCounters_.size() - 1) &&
-                                 (errorRegCount == static_cast<size_t>(soem_interface_rsl::REG::ERROR_COUNTERS::SIZE) - 1);
-                if (!lastEntry)
-                {
-                  busDiagnosisLogFile_ << ", ";
-                }
-              }
-            }
-            busDiagnosisLogFile_ << std::endl; // flush after every loop.
-          }
-        }
-        busDiagDecimationCount_ = 0;
+      if (inputSnapshots_[segment]->isEnabled())
+      {
+        inputSnapshots_[segment]->publish(cycleContext_.cycle, cycleContext_.startTimeNs, inputImages_[segment].data);
       }
-      busDiagDecimationCount_++;
     }
+    cycleNotification_.notify(sendTimeNs_);
+    if (updateMode == UpdateMode::ExternalTrigger)
+    {
+      recordTrigger();
+    }
+
+    // acyclic work within the budget and the time left in this cycle.
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const long nowNs = BILLION * now.tv_sec + now.tv_nsec;
+    long budgetNs = -1;
+    if (configuration_.acyclicBudget > 0.0)
+    {
+      const long cycleEndNs = BILLION * cycleStart_.tv_sec + cycleStart_.tv_nsec + timestepNs_;
+      budgetNs = std::max(0L, std::min(static_cast<long>(configuration_.acyclicBudget * 1e9), cycleEndNs - nowNs));
+    }
+    acyclicScheduler_.run(nowNs, budgetNs);
+
     // we should flush here to not leave the function (and therefore the thread
 
     // create update heartbeat if in standalone mode
@@ -298,22 +516,279 @@ namespace ecat_master
       createUpdateHeartbeat(false);
       break;
     case UpdateMode::NonStandalone:
+    case UpdateMode::ExternalTrigger:
       break;
     }
+    cycleStatisticsPublished_.store(cycleStatistics_);
+  }
+
+  bool EthercatMaster::isUpdatedByOtherThread()
+  {
+    const std::thread::id updateThread = updateThread_.load(std::memory_order_relaxed);
+    if (updateThread == std::thread::id{} || updateThread == std::this_thread::get_id())
+    {
+      return false;
+    }
+    // the other thread may have stopped updating, e.g. after handing the update over to this thread.
+    const uint64_t updates = updateCount_.load(std::memory_order_relaxed);
+    std::this_thread::sleep_for(std::chrono::nanoseconds(3 * timestepNs_));
+    return updateCount_.load(std::memory_order_relaxed) != updates;
+  }
+
+  bool EthercatMaster::setTimeStep(double timeStep)
+  {
+    const long timeStepNs = static_cast<long>(std::floor(timeStep * 1e9));
+    if (timeStepNs <= 0)
+    {
+      MELO_ERROR_STREAM("[EthercatMaster::" << bus_->getName() << "] Invalid time step: " << timeStep)
+      return false;
+    }
+    pendingTimeStep_ = timeStep;
+    return true;
+  }
+
+  void EthercatMaster::applyTimeStep(double timeStep)
+  {
+    const long timeStepNs = static_cast<long>(std::floor(timeStep * 1e9));
+    timestepNs_ = timeStepNs;
+    timeStep_ = timeStep;
+    for (auto &device : devices_)
+    {
+      device->setTimeStep(timeStep);
+    }
+    // the slave state monitor keeps its interval, the other acyclic work is decimated by cycles.
+    acyclicScheduler_.setPeriod("slave state monitor", getSlaveStateMonitorCycles(timeStep));
+    // the DC writes take several roundtrips per slave, the SYNC0 update thread sends them.
+    pendingSync0CycleTimeNs_ = timeStepNs;
+    sync0UpdateCondition_.notify_one();
+    // the new period starts now.
+    clock_gettime(CLOCK_MONOTONIC, &lastWakeup_);
+    sleepEnd_ = lastWakeup_;
+    MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] Time step changed to " << timeStepNs / 1e3 << "us.")
+  }
+
+  unsigned int EthercatMaster::getSlaveStateMonitorCycles(double timeStep) const
+  {
+    const double monitorCycles = SLAVE_STATE_MONITOR_INTERVAL_MS * 1e-3 / timeStep;
+    return static_cast<unsigned int>(std::max(1.0, monitorCycles));
+  }
+
+  void EthercatMaster::startSync0Update()
+  {
+    if (sync0UpdateRunning_)
+    {
+      return;
+    }
+    sync0UpdateRunning_ = true;
+    sync0UpdateThread_ = std::thread(&EthercatMaster::sync0UpdateLoop, this);
+  }
+
+  void EthercatMaster::stopSync0Update()
+  {
+    {
+      std::lock_guard<std::mutex> lock(sync0UpdateMutex_);
+      sync0UpdateRunning_ = false;
+    }
+    sync0UpdateCondition_.notify_one();
+    if (sync0UpdateThread_.joinable())
+    {
+      sync0UpdateThread_.join();
+    }
+  }
+
+  void EthercatMaster::sync0UpdateLoop()
+  {
+    sched_param param{};
+    param.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+    while (sync0UpdateRunning_)
+    {
+      long cycleTimeNs = 0;
+      {
+        // the update thread notifies without the mutex, the timeout covers a notification between check and wait.
+        std::unique_lock<std::mutex> lock(sync0UpdateMutex_);
+        sync0UpdateCondition_.wait_for(lock, std::chrono::milliseconds(SYNC0_UPDATE_CHECK_INTERVAL_MS),
+                                       [this]() { return !sync0UpdateRunning_ || pendingSync0CycleTimeNs_ != 0; });
+        cycleTimeNs = pendingSync0CycleTimeNs_.exchange(0);
+      }
+      if (cycleTimeNs == 0)
+      {
+        continue;
+      }
+      // SYNC0 restarts this long after the DC writes, well before the 100ms of ecx_dcsync0.
+      const int64_t startDelayNs = std::max<int64_t>(2 * cycleTimeNs, 1000000);
+      for (unsigned int segment = 0; segment < 2; segment++)
+      {
+        EthercatBus *bus = getSegmentBus(segment);
+        if (bus != nullptr && !bus->setSync0CycleTime(static_cast<uint32_t>(cycleTimeNs), startDelayNs))
+        {
+          MELO_ERROR_STREAM("[EthercatMaster::" << bus->getName() << "] Could not change the SYNC0 cycle time of all slaves.")
+        }
+      }
+    }
+  }
+
+  void EthercatMaster::updateCycleContext()
+  {
+    const int64_t startTimeNs = BILLION * cycleStart_.tv_sec + cycleStart_.tv_nsec;
+    if (cycleContext_.startTimeNs != 0)
+    {
+      cycleContext_.cycle++;
+      cycleContext_.measuredPeriodNs = startTimeNs - cycleContext_.startTimeNs;
+    }
+    cycleContext_.startTimeNs = startTimeNs;
+    cycleContext_.startSystemTime = std::chrono::system_clock::now();
+    cycleContext_.timeStepNs = timestepNs_;
+    cycleContext_.dcTimeNs = bus_->getDcTime();
+    cycleContext_.overrun = cycleOverrun_;
+    cycleOverrun_ = false;
+  }
+
+  void EthercatMaster::exchangeProcessData()
+  {
+    if (cycleStatisticsResetRequested_.exchange(false))
+    {
+      cycleStatistics_ = CycleStatistics{};
+      roundtripWindow_.clear();
+    }
+    // the frames of both segments are on the wire at the same time.
+    bus_->updateWrite();
+    if (segmentBus_)
+    {
+      segmentBus_->updateWrite();
+    }
+    bus_->updateRead();
+    if (segmentBus_)
+    {
+      segmentBus_->updateRead();
+    }
+    // the roundtrip of the frames, the device callbacks before the send and after the receive are not part of it.
+    sendTimeNs_ = bus_->getSendTimeNs();
+    int64_t receiveTimeNs = bus_->getReceiveTimeNs();
+    if (segmentBus_)
+    {
+      sendTimeNs_ = std::min(sendTimeNs_, segmentBus_->getSendTimeNs());
+      receiveTimeNs = std::max(receiveTimeNs, segmentBus_->getReceiveTimeNs());
+    }
+    const long roundtripNs = static_cast<long>(receiveTimeNs - sendTimeNs_);
+    cycleStatistics_.addRoundtrip(roundtripNs);
+    roundtripWindow_.add(roundtripNs);
+
+    const bool workingCounterOk = bus_->workingCounterIsOk() && (!segmentBus_ || segmentBus_->workingCounterIsOk());
+    if (!workingCounterOk)
+    {
+      cycleStatistics_.workingCounterErrors++;
+      slaveRecoveryRequested_ = true;
+    }
+    cycleStatisticsPublished_.store(cycleStatistics_);
+  }
+
+  CycleStatistics EthercatMaster::getCycleStatistics()
+  {
+    CycleStatistics statistics = cycleStatisticsPublished_.load();
+    statistics.recentRoundtripP99Ns = roundtripWindow_.percentile(0.99);
+    return statistics;
+  }
+
+  void EthercatMaster::resetCycleStatistics()
+  {
+    cycleStatisticsResetRequested_ = true;
+  }
+
+  BusCapacityEstimate EthercatMaster::estimateBusCapacity(unsigned int additionalSlaves, uint32_t rxPdoSize, uint32_t txPdoSize)
+  {
+    // the segments share the cycle and the measured roundtrip, the segment with the lower headroom limits the cycle.
+    const CycleStatistics statistics = getCycleStatistics();
+    BusCapacityEstimate estimate = ecat_master::estimateBusCapacity(bus_->getProcessImageInfo(), statistics, static_cast<double>(timestepNs_),
+                                                                    additionalSlaves, rxPdoSize, txPdoSize);
+    if (segmentBus_)
+    {
+      const BusCapacityEstimate segmentEstimate = ecat_master::estimateBusCapacity(
+          segmentBus_->getProcessImageInfo(), statistics, static_cast<double>(timestepNs_), additionalSlaves, rxPdoSize, txPdoSize);
+      if (segmentEstimate.headroom < estimate.headroom)
+      {
+        estimate = segmentEstimate;
+      }
+    }
+    return estimate;
+  }
+
+  RedundancyState EthercatMaster::getRedundancyState()
+  {
+    const RedundancyState state = bus_->readRedundancyState();
+    std::lock_guard<std::mutex> lock(redundancyStateMutex_);
+    if (state != redundancyState_ && state.enabled)
+    {
+      if (state.lineBreak)
+      {
+        MELO_WARN_STREAM("[EthercatMaster::" << bus_->getName() << "] Cable redundancy: " << state.description)
+      }
+      else
+      {
+        MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] Cable redundancy: " << state.description)
+      }
+    }
+    redundancyState_ = state;
+    return state;
+  }
+
+  ProcessImageLayout EthercatMaster::getProcessImageLayout()
+  {
+    ProcessImageLayout layout = bus_->getProcessImageLayout();
+    for (auto &entry : layout.entries)
+    {
+      entry.name = getDeviceName(entry.slave, 0);
+    }
+    return layout;
+  }
+
+  std::vector<uint8_t> EthercatMaster::getInputChanges() const
+  {
+    std::vector<uint8_t> changes;
+    changes.reserve(devices_.size());
+    for (size_t i = 0; i < devices_.size(); i++)
+    {
+      changes.push_back(devices_[i]->inputsChanged() ? 1 : 0);
+    }
+    return changes;
   }
 
   void EthercatMaster::shutdown()
   {
+    stopSlaveRecovery();
+    stopSlaveStateMonitor();
+    stopStallWatchdog();
+    periodicityDetector_.stop();
+    stopMailboxService();
+    stopSync0Update();
+    stopEmergencyDispatch();
+    perfCounters_.close();
+    perfCountersOpened_ = false;
+    eoeGateway_.close();
+    numaThreadPinned_ = false;
     if (bus_)
     {
       bus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::INIT);
       bus_->shutdown();
     }
+    if (segmentBus_)
+    {
+      segmentBus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::INIT);
+      segmentBus_->shutdown();
+    }
     bus_.reset(nullptr);
+    segmentBus_.reset(nullptr);
   }
 
   void EthercatMaster::preShutdown(bool setIntoSafeOP)
   {
+    // the devices leave their operational state now, they must not be recovered. The update loop usually ends after the pre
+    // shutdown, which is not a stall.
+    stopSlaveRecovery();
+    stopSlaveStateMonitor();
+    stopStallWatchdog();
+    periodicityDetector_.stop();
     if (bus_)
     { // check if the bus is not shutdown already..
       for (auto &device : devices_)
@@ -331,6 +806,11 @@ namespace ecat_master
         // outputs are active but in "safe" state. probably vendor dependent what safe state means. after preShutdown slave should be in a
         // state which allows to fallback into EC_STATE_SAFE_OP without triggering any further slave Call
         bus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP);
+        if (segmentBus_)
+        {
+          segmentBus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP);
+          segmentBus_->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP);
+        }
         bus_->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::SAFE_OP);
       }
     }
@@ -348,46 +828,310 @@ namespace ecat_master
     }
   }
 
-  bool EthercatMaster::deviceExists(const std::string &name)
+  void EthercatMaster::doBusDiagnosis()
   {
-    for (const auto &device : devices_)
+    bool diagUpdated = false;
+    for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
     {
-      if (device->getName() == name)
+      EthercatBus *bus = getSegmentBus(segment);
+      bus->doBusMonitoring(configuration_.logErrorCounters);
+      if (configuration_.logErrorCounters)
       {
-        return true;
+        // the row is written with the latest counters of the other segment.
+        diagUpdated |= bus->getBusDiagnosisLog(busDiagnosisLogs_[segment]);
       }
     }
-    return false;
+    if (diagUpdated)
+    { // will only be fully after some runs, depends on number of slaves on the bus.
+      MELO_DEBUG_STREAM("[EcatMaster::" << bus_->getName() << "::Update] Writing log to file (or buffer)")
+      // write the error counter to the file:
+      auto currentTime = std::chrono::system_clock::now();
+      auto msSinceStart =
+          std::chrono::duration_cast<std::chrono::milliseconds>(currentTime.time_since_epoch() - logStartTime_.time_since_epoch());
+      std::chrono::seconds secondsSinceStart = std::chrono::duration_cast<std::chrono::seconds>(msSinceStart);
+      std::chrono::milliseconds millisecondsSinceStart =
+          std::chrono::duration_cast<std::chrono::milliseconds>(msSinceStart % std::chrono::seconds(1));
+      std::lock_guard busDiagStreamLock(logFileStreamMutex_);
+      busDiagnosisLogFile_ << secondsSinceStart.count() << "." << std::setw(3) << std::setfill('0') << millisecondsSinceStart.count();
+      for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+      {
+        const auto &busDiagnosisLog = busDiagnosisLogs_[segment];
+        const auto &slaveStates = slaveStates_[segment];
+        busDiagnosisLogFile_ << ", " << busDiagnosisLog.ecatApplicationLayerStatus;
+        for (size_t slaveCount = 0; slaveCount < busDiagnosisLog.errorCounters_.size(); slaveCount++)
+        {
+          for (size_t errorRegCount = 0; errorRegCount < static_cast<size_t>(soem_interface_rsl::REG::ERROR_COUNTERS::SIZE);
+               errorRegCount++)
+          {
+            busDiagnosisLogFile_ << ", " << busDiagnosisLog.errorCounters_[slaveCount][errorRegCount].fullValue;
+          }
+          // published by the slave state monitor.
+          const uint32_t slaveStatus = slaveCount < slaveStates.size() ? slaveStates[slaveCount].load(std::memory_order_relaxed) : 0;
+          busDiagnosisLogFile_ << ", " << (slaveStatus >> 16) << ", " << (slaveStatus & 0xffff);
+        }
+      }
+      busDiagnosisLogFile_ << std::endl; // flush after every loop.
+    }
   }
 
-  bool EthercatMaster::setRealtimePriority(int priority, int cpu_core) const
+  void EthercatMaster::serviceMailboxes()
   {
-    bool success = true;
-    // Handle to our thread
-    pthread_t thread = pthread_self();
-    // First set the priority of the thread in the scheduler to the passed priority (99 is max)
-    sched_param param;
-    param.sched_priority = priority;
-    int errorFlag = pthread_setschedparam(thread, SCHED_FIFO, &param);
-    if (errorFlag != 0)
+    if (eoeGateway_.isOpen())
     {
-      MELO_ERROR_STREAM("[ethercat_sdk_master:EthercatMaster::setRealtimePriority]"
-                        << " Could not set thread priority. Check limits.conf or"
-                        << " execute as root");
-      success &= false;
+      bus_->serviceMailboxes([this](uint16_t slave, const ec_mbxbuft &mailbox) { eoeGateway_.receive(slave, mailbox); });
+      // after the mailbox status read, which tells the slaves that did not take the previous fragment yet.
+      eoeGateway_.transmit(configuration_.eoeBytesPerRound);
     }
-
-    // Allow attaching the thread to a certain cpu core
-    // Create an empty cpu set for the scheduler
-    cpu_set_t cpuset;
-    CPU_ZERO(&cpuset);
-    // Obtain amount of cpus
-    int number_of_cpus = sysconf(_SC_NPROCESSORS_ONLN);
-
-    // In case the user passed a core value > 0
-    if (cpu_core > 0)
+    else
     {
-      // check if the core is < than the number of available cpus
+      bus_->serviceMailboxes({});
+    }
+    // startup() rejects EoE on a split bus.
+    if (segmentBus_)
+    {
+      segmentBus_->serviceMailboxes({});
+    }
+    if (configuration_.collectEmergencies)
+    {
+      collectEmergencies();
+    }
+  }
+
+  void EthercatMaster::startMailboxService()
+  {
+    if (!(configuration_.mapMailboxStatus || configuration_.collectEmergencies || eoeGateway_.isOpen()) || mailboxServiceRunning_)
+    {
+      return;
+    }
+    mailboxServiceRunning_ = true;
+    mailboxServiceThread_ = std::thread(&EthercatMaster::mailboxServiceLoop, this);
+  }
+
+  void EthercatMaster::stopMailboxService()
+  {
+    mailboxServiceRunning_ = false;
+    if (mailboxServiceThread_.joinable())
+    {
+      mailboxServiceThread_.join();
+    }
+  }
+
+  void EthercatMaster::mailboxServiceLoop()
+  {
+    // the mailboxes are read with datagrams of their own, the service must never compete with the real time threads.
+    sched_param param{};
+    param.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+    // emergencies report faults of the slaves, the EoE tunnel receives and sends its fragments at the same interval.
+    // The update thread grants the runs within the acyclic budget, it runs on its own while there is no update loop.
+    while (mailboxServiceRunning_)
+    {
+      if (!mailboxService_.waitForGrant(timestepNs_ * MAILBOX_SERVICE_DECIMATION))
+      {
+        continue;
+      }
+      const auto start = std::chrono::steady_clock::now();
+      serviceMailboxes();
+      mailboxService_.finish(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+  }
+
+  void EthercatMaster::startStallWatchdog()
+  {
+    if (configuration_.stallTimeout <= 0.0)
+    {
+      return;
+    }
+    const std::string busName = bus_->getName();
+    stallWatchdog_.start(
+        std::chrono::nanoseconds{static_cast<long>(configuration_.stallTimeout * 1e9)},
+        [this]()
+        {
+          const CycleStatistics statistics = getCycleStatistics();
+          std::stringstream ss;
+          ss << "Cycles: " << statistics.cycles << ", time step: " << timestepNs_ / 1e3
+             << "us, last roundtrip: " << statistics.lastRoundtripNs / 1e3 << "us, mean roundtrip: " << statistics.meanRoundtripNs / 1e3
+             << "us, max roundtrip: " << statistics.maxRoundtripNs / 1e3
+             << "us, working counter errors: " << statistics.workingCounterErrors
+             << ", overruns: " << statistics.overruns;
+          if (statistics.counterCycles > 0)
+          {
+            ss << "\nCounters per cycle (mean / outliers / longest cycle " << statistics.longestCycleNs / 1e3 << "us): instructions "
+               << statistics.meanCounters.instructions << " / " << statistics.meanOutlierCounters.instructions << " / "
+               << statistics.longestCycleCounters.instructions << ", cache misses " << statistics.meanCounters.cacheMisses << " / "
+               << statistics.meanOutlierCounters.cacheMisses << " / " << statistics.longestCycleCounters.cacheMisses
+               << ", context switches " << statistics.meanCounters.contextSwitches << " / "
+               << statistics.meanOutlierCounters.contextSwitches << " / " << statistics.longestCycleCounters.contextSwitches;
+          }
+          for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+          {
+            const auto slaveStates = slaveStateTrackers_[segment].getCurrentStates();
+            for (size_t i = 0; i < slaveStates.size(); i++)
+            {
+              ss << "\n" << (segment == 0 ? "Slave " : "Segment slave ") << i + 1 << ": " << alStateToString(slaveStates[i].status.state);
+            }
+          }
+          return ss.str();
+        },
+        [this, busName](const StallReport &report)
+        {
+          MELO_ERROR_STREAM("[EthercatMaster::" << busName << "] Update thread stalled. " << report.toString())
+          if (stallCallback_)
+          {
+            stallCallback_(report);
+          }
+        });
+  }
+
+  void EthercatMaster::stopStallWatchdog()
+  {
+    stallWatchdog_.stop();
+  }
+
+  void EthercatMaster::startSlaveStateMonitor()
+  {
+    // the slave recovery acts on the states of the monitor.
+    if (!(configuration_.doBusDiagnosis || configuration_.slaveRecovery) || slaveStateMonitorRunning_)
+    {
+      return;
+    }
+    slaveStateMonitorRunning_ = true;
+    slaveStateMonitorThread_ = std::thread(&EthercatMaster::slaveStateMonitorLoop, this);
+  }
+
+  void EthercatMaster::stopSlaveStateMonitor()
+  {
+    slaveStateMonitorRunning_ = false;
+    if (slaveStateMonitorThread_.joinable())
+    {
+      slaveStateMonitorThread_.join();
+    }
+  }
+
+  void EthercatMaster::slaveStateMonitorLoop()
+  {
+    // the AL status is read with datagrams of its own, the monitor must never compete with the real time threads.
+    sched_param param{};
+    param.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+    std::array<std::vector<SlaveAlStatus>, 2> states;
+    std::vector<PortErrorCounters> errorCounters;
+    while (slaveStateMonitorRunning_)
+    {
+      // granted by the update thread within the acyclic budget, like the mailbox service.
+      if (!slaveStateMonitorService_.waitForGrant(SLAVE_STATE_MONITOR_INTERVAL_MS * 1000000L))
+      {
+        continue;
+      }
+      const auto start = std::chrono::steady_clock::now();
+      for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+      {
+        EthercatBus *bus = getSegmentBus(segment);
+        if (configuration_.doBusDiagnosis)
+        {
+          bus->readPortErrorCounters(errorCounters);
+          linkFaultLocalizers_[segment].update(errorCounters);
+        }
+        bus->readSlaveStates(states[segment]);
+      }
+      // the datagrams are done, the rest does not load the bus.
+      slaveStateMonitorService_.finish(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+      const auto stamp = std::chrono::system_clock::now();
+      for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+      {
+        const std::string busName = getSegmentBus(segment)->getName();
+        if (configuration_.doBusDiagnosis)
+        {
+          const auto linkFault = linkFaultLocalizers_[segment].getEstimate();
+          if (linkFault.valid && linkFault.description != lastLinkFaultDescriptions_[segment])
+          {
+            MELO_WARN_STREAM("[EthercatMaster::" << busName << "] Most likely faulty " << linkFault.description
+                                                 << " (confidence: " << linkFault.confidence << ")")
+          }
+          lastLinkFaultDescriptions_[segment] = linkFault.description;
+        }
+        const auto &segmentStates = states[segment];
+        for (size_t i = 0; i < segmentStates.size() && i < slaveStates_[segment].size(); i++)
+        {
+          slaveStates_[segment][i].store(static_cast<uint32_t>(segmentStates[i].state) << 16 | segmentStates[i].alStatusCode,
+                                         std::memory_order_relaxed);
+        }
+        for (const auto slave : slaveStateTrackers_[segment].update(segmentStates, stamp))
+        {
+          const std::string deviceName = getDeviceName(slave, segment);
+          const auto &status = segmentStates[slave - 1];
+          if ((status.state & 0x0f) != EC_STATE_OPERATIONAL || (status.state & EC_STATE_ERROR))
+          {
+            slaveRecoveryRequested_ = true;
+          }
+          std::stringstream statusCode;
+          statusCode << "0x" << std::hex << std::setw(4) << std::setfill('0') << status.alStatusCode;
+          if (status.state & EC_STATE_ERROR)
+          {
+            MELO_WARN_STREAM("[EthercatMaster::" << busName << "] Slave " << slave << " (" << deviceName << ") changed to "
+                                                 << alStateToString(status.state) << ", AL status code: " << statusCode.str())
+          }
+          else
+          {
+            MELO_INFO_STREAM("[EthercatMaster::" << busName << "] Slave " << slave << " (" << deviceName << ") changed to "
+                                                 << alStateToString(status.state))
+          }
+        }
+      }
+    }
+  }
+
+  std::string EthercatMaster::getDeviceName(uint16_t address, unsigned int segment)
+  {
+    std::string name;
+    for (const size_t index : devices_.findAt(segment, address))
+    {
+      name += (name.empty() ? "" : ", ") + devices_[index]->getName();
+    }
+    return name.empty() ? "unknown" : name;
+  }
+
+  bool EthercatMaster::deviceExists(const std::string &name)
+  {
+    return devices_.contains(name);
+  }
+
+  EthercatBus *EthercatMaster::getSegmentBus(unsigned int segment)
+  {
+    return segment == 0 ? bus_.get() : (segment == 1 ? segmentBus_.get() : nullptr);
+  }
+
+  bool EthercatMaster::setRealtimePriority(int priority, int cpu_core) const
+  {
+    bool success = true;
+    // Handle to our thread
+    pthread_t thread = pthread_self();
+    // First set the priority of the thread in the scheduler to the passed priority (99 is max)
+    sched_param param;
+    param.sched_priority = priority;
+    int errorFlag = pthread_setschedparam(thread, SCHED_FIFO, &param);
+    if (errorFlag != 0)
+    {
+      MELO_ERROR_STREAM("[ethercat_sdk_master:EthercatMaster::setRealtimePriority]"
+                        << " Could not set thread priority. Check limits.conf or"
+                        << " execute as root");
+      success &= false;
+    }
+
+    // Allow attaching the thread to a certain cpu core
+    // Create an empty cpu set for the scheduler
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    // Obtain amount of cpus
+    int number_of_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    // In case the user passed a core value > 0
+    if (cpu_core > 0)
+    {
+      // check if the core is < than the number of available cpus
       if (cpu_core >= number_of_cpus)
       {
         MELO_ERROR_STREAM("[ethercat_sdk_master:EthercatMaster::setRealtimePriority]"
@@ -486,8 +1230,10 @@ namespace ecat_master
     // we are late.
     if (timespecSmallerThan(&sleepEnd_, &now))
     {
+      cycleOverrun_ = true;
       rateTooLowCounter_++;
       accumulatedDelayNs_ = accumulatedDelayNs_ + getTimeDiffNs(&now, &sleepEnd_); // might overflow
+      cycleStatistics_.overruns++;
       // prevent the creation of a too low update step
       addNsecsToTimespec(&lastWakeup_, static_cast<long int>(configuration_.rateCompensationCoefficient * timestepNs_));
       // we need to sleep a bit
@@ -514,7 +1260,832 @@ namespace ecat_master
       std::lock_guard<std::mutex> lock(timeStepMutex_);
       timeStepNsMeasured_ = getTimeDiffNs(&measurementTime, &lastWakeup_);
     }
+    wakeupLatenessNs_ = getTimeDiffNs(&measurementTime, &sleepEnd_);
     clock_gettime(CLOCK_MONOTONIC, &lastWakeup_);
   }
 
+  void EthercatMaster::precomputePdoMappingLayouts()
+  {
+    pdoMappingLayouts_.assign(devices_.size(), {});
+    for (size_t i = 0; i < devices_.size(); i++)
+    {
+      const auto &device = devices_[i];
+      const auto &profiles = device->getPdoMappingProfiles();
+      if (profiles.empty())
+      {
+        continue;
+      }
+      uint32_t outputBytes = 0;
+      uint32_t inputBytes = 0;
+      getSegmentBus(devices_.getSegment(i))->getProcessDataSize(static_cast<uint16_t>(device->getAddress()), outputBytes, inputBytes);
+      for (const auto &profile : profiles)
+      {
+        PdoMappingLayout layout;
+        layout.outputBytes = profile.rxPdoSize;
+        layout.inputBytes = profile.txPdoSize;
+        layout.fits = profile.rxPdoSize <= outputBytes && profile.txPdoSize <= inputBytes;
+        if (!layout.fits)
+        {
+          MELO_WARN_STREAM("[EthercatMaster::" << bus_->getName() << "] PDO mapping profile '" << profile.name << "' of " << device->getName()
+                                               << " (" << profile.rxPdoSize << " / " << profile.txPdoSize
+                                               << " bytes) does not fit into the process image mapped at startup (" << outputBytes << " / "
+                                               << inputBytes << " bytes), it cannot be switched to.")
+        }
+        pdoMappingLayouts_[i].push_back(layout);
+      }
+    }
+  }
+
+  void EthercatMaster::applyPendingPdoMappingProfile()
+  {
+    bool pending = true;
+    if (pdoMappingSwitchPending_.compare_exchange_strong(pending, false, std::memory_order_acquire))
+    {
+      devices_[pendingPdoMappingDevice_]->setActivePdoMappingProfile(pendingPdoMappingProfile_);
+    }
+  }
+
+  bool EthercatMaster::switchPdoMappingProfile(const std::string &deviceName, const std::string &profileName)
+  {
+    std::lock_guard<std::mutex> lock(pdoMappingMutex_);
+    const size_t deviceIndex = devices_.find(deviceName);
+    if (deviceIndex == DeviceRegistry::npos || deviceIndex >= pdoMappingLayouts_.size())
+    {
+      MELO_ERROR_STREAM("[EthercatMaster::" << bus_->getName() << "] Cannot switch PDO mapping: unknown device " << deviceName)
+      return false;
+    }
+    const auto &device = devices_[deviceIndex];
+    const auto &profiles = device->getPdoMappingProfiles();
+    const auto profile =
+        std::find_if(profiles.begin(), profiles.end(), [&](const PdoMappingProfile &candidate) { return candidate.name == profileName; });
+    if (profile == profiles.end())
+    {
+      MELO_ERROR_STREAM("[EthercatMaster::" << bus_->getName() << "] " << deviceName << " has no PDO mapping profile " << profileName)
+      return false;
+    }
+    const size_t profileIndex = static_cast<size_t>(profile - profiles.begin());
+    const PdoMappingLayout &layout = pdoMappingLayouts_[deviceIndex][profileIndex];
+    if (!layout.fits)
+    {
+      MELO_ERROR_STREAM("[EthercatMaster::" << bus_->getName() << "] PDO mapping profile " << profileName << " of " << deviceName
+                                            << " does not fit into the process image.")
+      return false;
+    }
+    if (profileIndex == device->getActivePdoMappingProfile())
+    {
+      return true;
+    }
+
+    // the slave leaves OPERATIONAL on purpose, it must not be recovered meanwhile.
+    inhibitSlaveRecovery();
+
+    EthercatBus *bus = getSegmentBus(devices_.getSegment(deviceIndex));
+    const uint16_t address = static_cast<uint16_t>(device->getAddress());
+    const auto start = std::chrono::steady_clock::now();
+    bool success = bus->changeProcessDataSize(address, layout.outputBytes, layout.inputBytes,
+                                              [&]() { return device->configurePdoMappingProfile(*profile); });
+    if (success)
+    {
+      // swap at a cycle boundary, the slave does not exchange process data in SAFE_OP.
+      pendingPdoMappingDevice_ = deviceIndex;
+      pendingPdoMappingProfile_ = profileIndex;
+      pdoMappingSwitchPending_.store(true, std::memory_order_release);
+      const auto swapStart = std::chrono::steady_clock::now();
+      const auto timeout = std::chrono::nanoseconds{std::max(timestepNs_.load(), 1000000L) * PDO_MAPPING_SWAP_TIMEOUT_CYCLES};
+      while (pdoMappingSwitchPending_ && std::chrono::steady_clock::now() - swapStart < timeout)
+      {
+        std::this_thread::sleep_for(std::chrono::nanoseconds{std::max(timestepNs_.load(), 100000L)});
+      }
+      bool pending = true;
+      if (pdoMappingSwitchPending_.compare_exchange_strong(pending, false))
+      {
+        MELO_WARN_STREAM("[EthercatMaster::" << bus_->getName() << "] Update thread did not swap the PDO mapping of " << deviceName
+                                             << ", swapping it outside of the update cycle.")
+        device->setActivePdoMappingProfile(profileIndex);
+      }
+      bus->setState(soem_interface_rsl::ETHERCAT_SM_STATE::OPERATIONAL, address);
+      success = bus->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::OPERATIONAL, address, 50, 0.01);
+    }
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    releaseSlaveRecovery();
+    if (success)
+    {
+      MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] Switched " << deviceName << " to PDO mapping profile " << profileName
+                                           << " in " << duration.count() << "ms")
+    }
+    else
+    {
+      MELO_ERROR_STREAM("[EthercatMaster::" << bus_->getName() << "] Switching " << deviceName << " to PDO mapping profile " << profileName
+                                            << " failed, the slave is left out of OPERATIONAL.")
+    }
+    return success;
+  }
+
+  void EthercatMaster::startSlaveRecovery()
+  {
+    if (!configuration_.slaveRecovery || slaveRecoveryRunning_)
+    {
+      return;
+    }
+    slaveRecoveryRequested_ = false;
+    slaveRecoveryRunning_ = true;
+    slaveRecoveryThread_ = std::thread(&EthercatMaster::slaveRecoveryLoop, this);
+  }
+
+  void EthercatMaster::stopSlaveRecovery()
+  {
+    slaveRecoveryRunning_ = false;
+    if (slaveRecoveryThread_.joinable())
+    {
+      slaveRecoveryThread_.join();
+    }
+  }
+
+  void EthercatMaster::inhibitSlaveRecovery()
+  {
+    // waits for a running attempt.
+    std::lock_guard<std::mutex> lock(slaveRecoveryInhibitMutex_);
+    slaveRecoveryInhibits_++;
+  }
+
+  void EthercatMaster::releaseSlaveRecovery()
+  {
+    {
+      std::lock_guard<std::mutex> lock(slaveRecoveryInhibitMutex_);
+      if (slaveRecoveryInhibits_ > 0)
+      {
+        slaveRecoveryInhibits_--;
+      }
+    }
+    // the slaves left behind by the inhibiting operation are recovered with the next check.
+    slaveRecoveryRequested_ = true;
+  }
+
+  void EthercatMaster::slaveRecoveryLoop()
+  {
+    // pending retry of a single slave.
+    struct RecoveryRetry
+    {
+      // no attempt before the slave state monitor sampled the slave at or after this time.
+      std::chrono::system_clock::time_point notBefore{};
+      std::chrono::milliseconds delay{0};
+    };
+    std::array<std::vector<RecoveryRetry>, 2> retries;
+    while (slaveRecoveryRunning_)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(SLAVE_RECOVERY_CHECK_INTERVAL_MS));
+      if (!slaveRecoveryRequested_.exchange(false))
+      {
+        continue;
+      }
+      bool allOperational = true;
+      for (unsigned int segment = 0; segment < getNumberOfSegments() && slaveRecoveryRunning_; segment++)
+      {
+        // the states of the slave state monitor, the recovery sends no datagrams of its own until a slave is recovered.
+        const auto lastUpdate = slaveStateTrackers_[segment].getLastUpdate();
+        const auto states = slaveStateTrackers_[segment].getCurrentStates();
+        auto &segmentRetries = retries[segment];
+        segmentRetries.resize(states.size());
+        for (size_t i = 0; i < states.size() && slaveRecoveryRunning_; i++)
+        {
+          const uint16_t state = states[i].status.state;
+          if (states[i].stamp == std::chrono::system_clock::time_point{})
+          {
+            // not sampled yet.
+            allOperational = false;
+            continue;
+          }
+          if ((state & 0x0f) == EC_STATE_OPERATIONAL && !(state & EC_STATE_ERROR))
+          {
+            segmentRetries[i] = RecoveryRetry{};
+            continue;
+          }
+          allOperational = false;
+          // wait for the back off and for a state read after the last attempt.
+          if (lastUpdate < segmentRetries[i].notBefore)
+          {
+            continue;
+          }
+          auto &retry = segmentRetries[i];
+          // held during the attempt: inhibitSlaveRecovery() returns once no attempt is running.
+          std::unique_lock<std::mutex> inhibitLock(slaveRecoveryInhibitMutex_);
+          if (slaveRecoveryInhibits_ > 0)
+          {
+            continue;
+          }
+          if (recoverSlave(static_cast<uint16_t>(i + 1), segment))
+          {
+            retry.delay = std::chrono::milliseconds{0};
+          }
+          else
+          {
+            retry.delay = retry.delay.count() == 0 ? std::chrono::milliseconds(SLAVE_RECOVERY_RETRY_DELAY_MIN_MS)
+                                                   : std::min(2 * retry.delay, std::chrono::milliseconds(SLAVE_RECOVERY_RETRY_DELAY_MAX_MS));
+          }
+          retry.notBefore = std::chrono::system_clock::now() + retry.delay;
+        }
+      }
+      if (!allOperational)
+      {
+        // check again, the update thread does not report slaves which are still in SAFE_OP after a failed attempt.
+        slaveRecoveryRequested_ = true;
+      }
+    }
+  }
+
+  bool EthercatMaster::recoverSlave(uint16_t address, unsigned int segment)
+  {
+    EthercatBus *bus = getSegmentBus(segment);
+    if (bus == nullptr)
+    {
+      MELO_ERROR_STREAM("[EthercatMaster::" << bus_->getName() << "] Cannot recover slave " << address << ", segment " << segment
+                                            << " is not configured.")
+      return false;
+    }
+    std::vector<EthercatDevice::SharedPtr> devices;
+    for (const size_t index : devices_.findAt(segment, address))
+    {
+      devices.push_back(devices_[index]);
+    }
+    const std::string name = getDeviceName(address, segment);
+
+    MELO_WARN_STREAM("[EthercatMaster::" << bus->getName() << "] Slave " << address << " (" << name << ") left OPERATIONAL, recovering")
+    const auto start = std::chrono::system_clock::now();
+    // rerun the device startup in PRE_OP, it configures the PDO mapping and the device parameters.
+    const bool success = bus->recoverSlave(address,
+                                           [&devices]()
+                                           {
+                                             bool configured = true;
+                                             for (const auto &device : devices)
+                                             {
+                                               configured &= device->startup();
+                                             }
+                                             return configured;
+                                           });
+    const auto end = std::chrono::system_clock::now();
+
+    {
+      std::lock_guard<std::mutex> lock(slaveRecoveryMutex_);
+      auto &statistics = slaveRecoveryStatistics_[{segment, address}];
+      statistics.segment = segment;
+      statistics.slave = address;
+      statistics.name = name;
+      statistics.attempts++;
+      statistics.lastAttempt = start;
+      statistics.lastAttemptSucceeded = success;
+      if (success)
+      {
+        statistics.successes++;
+        statistics.lastRecoveryDuration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+      }
+    }
+
+    if (success)
+    {
+      // startup() configured the startup PDO mapping again.
+      for (const auto &device : devices)
+      {
+        device->setActivePdoMappingProfile(0);
+        device->flushSdoCache();
+      }
+      MELO_INFO_STREAM("[EthercatMaster::" << bus->getName() << "] Slave " << address << " (" << name << ") recovered in "
+                                          << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms")
+    }
+    else
+    {
+      MELO_ERROR_STREAM("[EthercatMaster::" << bus->getName() << "] Recovery of slave " << address << " (" << name << ") failed")
+    }
+    return success;
+  }
+
+  std::vector<SlaveRecoveryStatistics> EthercatMaster::getSlaveRecoveryStatistics()
+  {
+    std::lock_guard<std::mutex> lock(slaveRecoveryMutex_);
+    std::vector<SlaveRecoveryStatistics> statistics;
+    for (const auto &entry : slaveRecoveryStatistics_)
+    {
+      if (entry.second.attempts > 0)
+      {
+        statistics.push_back(entry.second);
+      }
+    }
+    return statistics;
+  }
+
+  void EthercatMaster::addEmergencySubscriber(EmergencySubscriber subscriber)
+  {
+    std::lock_guard<std::mutex> lock(emergencySubscribersMutex_);
+    emergencySubscribers_.push_back(std::move(subscriber));
+  }
+
+  void EthercatMaster::collectEmergencies()
+  {
+    if (!emergencyQueue_)
+    {
+      return;
+    }
+    for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+    {
+      getSegmentBus(segment)->popEmergencies(
+          [this, segment](const ec_errort &error)
+          {
+            EmergencyMessage message;
+            message.segment = segment;
+            message.slave = error.Slave;
+            message.stamp =
+                std::chrono::system_clock::time_point{std::chrono::seconds{error.Time.sec} + std::chrono::microseconds{error.Time.usec}};
+            message.errorCode = error.ErrorCode;
+            message.errorRegister = error.ErrorReg;
+            message.data = {error.b1, static_cast<uint8_t>(error.w1 & 0xff), static_cast<uint8_t>(error.w1 >> 8),
+                            static_cast<uint8_t>(error.w2 & 0xff), static_cast<uint8_t>(error.w2 >> 8)};
+            if (!emergencyQueue_->push(message))
+            {
+              droppedEmergencies_++;
+            }
+          });
+    }
+  }
+
+  void EthercatMaster::startEmergencyDispatch()
+  {
+    if (!configuration_.collectEmergencies || emergencyDispatchRunning_)
+    {
+      return;
+    }
+    if (!emergencyQueue_)
+    {
+      emergencyQueue_ = std::make_unique<SpscQueue<EmergencyMessage>>(EMERGENCY_QUEUE_CAPACITY);
+    }
+    // the devices are not accessed from the dispatch thread.
+    for (unsigned int segment = 0; segment < getNumberOfSegments(); segment++)
+    {
+      auto &deviceNames = emergencyDeviceNames_[segment];
+      deviceNames.clear();
+      for (int slave = 1; slave <= getSegmentBus(segment)->getNumberOfSlaves(); slave++)
+      {
+        deviceNames.push_back(getDeviceName(static_cast<uint16_t>(slave), segment));
+      }
+    }
+    emergencyDispatchRunning_ = true;
+    emergencyDispatchThread_ = std::thread(&EthercatMaster::emergencyDispatchLoop, this);
+  }
+
+  void EthercatMaster::stopEmergencyDispatch()
+  {
+    emergencyDispatchRunning_ = false;
+    if (emergencyDispatchThread_.joinable())
+    {
+      emergencyDispatchThread_.join();
+    }
+  }
+
+  void EthercatMaster::emergencyDispatchLoop()
+  {
+    const std::string busName = bus_->getName();
+    const std::string segmentBusName = segmentBus_ ? segmentBus_->getName() : busName;
+    uint64_t reportedDrops = 0;
+    EmergencyMessage message;
+    while (emergencyDispatchRunning_)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(EMERGENCY_DISPATCH_INTERVAL_MS));
+      while (emergencyQueue_->pop(message))
+      {
+        const auto &deviceNames = emergencyDeviceNames_[message.segment];
+        const std::string deviceName =
+            message.slave >= 1 && message.slave <= deviceNames.size() ? deviceNames[message.slave - 1] : "unknown";
+        MELO_WARN_STREAM("[EthercatMaster::" << (message.segment == 0 ? busName : segmentBusName) << "] Emergency of slave " << message.slave << " (" << deviceName
+                                             << "): " << message.toString())
+        std::lock_guard<std::mutex> lock(emergencySubscribersMutex_);
+        for (const auto &subscriber : emergencySubscribers_)
+        {
+          subscriber(message);
+        }
+      }
+      const uint64_t drops = droppedEmergencies_;
+      if (drops != reportedDrops)
+      {
+        MELO_WARN_STREAM("[EthercatMaster::" << busName << "] Emergency queue full, " << drops - reportedDrops << " emergencies dropped.")
+        reportedDrops = drops;
+      }
+    }
+  }
+
+  void EthercatMaster::setTriggerFd(int fd)
+  {
+    externalTrigger_.setFd(fd);
+  }
+
+  void EthercatMaster::setTrigger(const EthercatMaster &master)
+  {
+    externalTrigger_.setFd(master.cycleNotification_.getFd(), &master.cycleNotification_);
+  }
+
+  int EthercatMaster::getCycleNotificationFd() const
+  {
+    return cycleNotification_.getFd();
+  }
+
+  void EthercatMaster::waitForTrigger()
+  {
+    int64_t triggerTimeNs = 0;
+    uint64_t triggers = 0;
+    // the process data must not stop with the trigger: the cycle runs untriggered after two time steps.
+    if (!externalTrigger_.wait(2 * timestepNs_, triggerTimeNs, triggers))
+    {
+      triggerTimeNs_ = 0;
+      previousTriggerTimeNs_ = 0;
+      return;
+    }
+    // a timerfd reports the triggers missed meanwhile, the interval is averaged over them.
+    triggers = std::max<uint64_t>(triggers, 1);
+    triggerIntervalNs_ =
+        previousTriggerTimeNs_ != 0 ? static_cast<long>(triggerTimeNs - previousTriggerTimeNs_) / static_cast<long>(triggers) : 0;
+    triggerTimeNs_ = triggerTimeNs;
+    previousTriggerTimeNs_ = triggerTimeNs;
+    coalescedTriggers_ = triggers - 1;
+  }
+
+  void EthercatMaster::recordTrigger()
+  {
+    if (triggerTimeNs_ == 0)
+    {
+      cycleStatistics_.missedTriggers++;
+      return;
+    }
+    cycleStatistics_.addTrigger(static_cast<long>(sendTimeNs_ - triggerTimeNs_), triggerIntervalNs_, coalescedTriggers_);
+  }
+
+  void EthercatMaster::placeOnNumaNode()
+  {
+    numaPlacement_ = NumaPlacement{};
+    numaPlacement_.networkInterface = configuration_.networkInterface;
+    numaPlacement_.node = getNetworkInterfaceNumaNode(configuration_.networkInterface);
+    numaPlacement_.cpus = getNumaNodeCpus(numaPlacement_.node);
+    if (numaPlacement_.node < 0)
+    {
+      MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] " << numaPlacement_.toString())
+      return;
+    }
+    // the process image (IOmap) and the SOEM slave tables are part of the bus object.
+    auto move = [&](NumaPlacement::Region &region, const void *address, size_t size)
+    {
+      size_t pages = 0;
+      region.movedPages += moveToNumaNode(address, size, region.node, pages);
+      region.pages += pages;
+    };
+    NumaPlacement::Region busRegion{"bus " + bus_->getName(), numaPlacement_.node};
+    move(busRegion, bus_.get(), sizeof(EthercatBus));
+    numaPlacement_.regions.push_back(busRegion);
+    if (segmentBus_)
+    {
+      // the segment bus is exchanged by the same update thread, but its frames go through its own interface.
+      const int segmentNode = getNetworkInterfaceNumaNode(configuration_.segmentNetworkInterface);
+      NumaPlacement::Region segmentRegion{"bus " + segmentBus_->getName(), segmentNode >= 0 ? segmentNode : numaPlacement_.node};
+      move(segmentRegion, segmentBus_.get(), sizeof(EthercatBus));
+      numaPlacement_.regions.push_back(segmentRegion);
+    }
+    NumaPlacement::Region masterRegion{"master state", numaPlacement_.node};
+    move(masterRegion, this, sizeof(EthercatMaster));
+    numaPlacement_.regions.push_back(masterRegion);
+    // the update thread calls the devices every cycle. The size of the concrete device types is unknown here, the pages of
+    // their EthercatDevice part are moved.
+    NumaPlacement::Region deviceRegion{"devices", numaPlacement_.node};
+    for (const auto &device : devices_)
+    {
+      move(deviceRegion, device.get(), sizeof(EthercatDevice));
+    }
+    numaPlacement_.regions.push_back(deviceRegion);
+    MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] " << numaPlacement_.toString())
+  }
+
+  void EthercatMaster::pinUpdateThread()
+  {
+    numaThreadPinned_ = true;
+    if (numaPlacement_.cpus.empty())
+    {
+      return;
+    }
+    cpu_set_t current;
+    CPU_ZERO(&current);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(current), &current) != 0)
+    {
+      return;
+    }
+    cpu_set_t node;
+    CPU_ZERO(&node);
+    for (const int cpu : numaPlacement_.cpus)
+    {
+      CPU_SET(cpu, &node);
+    }
+    cpu_set_t outside;
+    CPU_XOR(&outside, &current, &node);
+    CPU_AND(&outside, &outside, &current);
+    if (CPU_COUNT(&outside) == 0)
+    {
+      // already on the node, e.g. pinned to a single core.
+      return;
+    }
+    cpu_set_t inside;
+    CPU_AND(&inside, &current, &node);
+    if (CPU_COUNT(&inside) == 0)
+    {
+      // an explicit placement of the application is kept.
+      MELO_WARN_STREAM("[EthercatMaster::" << bus_->getName() << "] Update thread runs outside NUMA node " << numaPlacement_.node
+                                           << " of " << numaPlacement_.networkInterface << ", not pinned.")
+      return;
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(inside), &inside) != 0)
+    {
+      MELO_WARN_STREAM("[EthercatMaster::" << bus_->getName() << "] Could not pin the update thread to NUMA node " << numaPlacement_.node)
+      return;
+    }
+    MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] Update thread pinned to NUMA node " << numaPlacement_.node << ".")
+  }
+
+  void EthercatMaster::samplePerfCounters()
+  {
+    if (!perfCountersOpened_)
+    {
+      perfCountersOpened_ = true;
+      if (perfCounters_.open())
+      {
+        MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] " << perfCounters_.toString())
+      }
+      else
+      {
+        MELO_WARN_STREAM("[EthercatMaster::" << bus_->getName()
+                                             << "] Performance counters unavailable (see kernel.perf_event_paranoid), not sampled.")
+      }
+    }
+    PerfCounterValues counters;
+    if (!perfCounters_.isOpen() || !perfCounters_.sample(counters) || cycleContext_.measuredPeriodNs == 0)
+    {
+      return;
+    }
+    const bool outlier = cycleContext_.measuredPeriodNs * PERF_COUNTER_OUTLIER_DENOMINATOR > timestepNs_ * PERF_COUNTER_OUTLIER_NUMERATOR;
+    cycleStatistics_.addCounters(counters, cycleContext_.measuredPeriodNs, outlier);
+  }
+
+  void EthercatMaster::samplePeriodicity(UpdateMode updateMode)
+  {
+    switch (updateMode)
+    {
+    case UpdateMode::StandaloneEnforceRate:
+    case UpdateMode::StandaloneEnforceStep:
+      periodicityDetector_.addSample(cycleContext_.startTimeNs, wakeupLatenessNs_);
+      break;
+    case UpdateMode::ExternalTrigger:
+      if (triggerTimeNs_ != 0)
+      {
+        periodicityDetector_.addSample(cycleContext_.startTimeNs, cycleContext_.startTimeNs - triggerTimeNs_);
+      }
+      break;
+    case UpdateMode::NonStandalone:
+      if (cycleContext_.measuredPeriodNs != 0)
+      {
+        periodicityDetector_.addSample(cycleContext_.startTimeNs, cycleContext_.measuredPeriodNs - timestepNs_);
+      }
+      break;
+    }
+  }
+
+  AutotuneResult EthercatMaster::autotuneTimeStep(const AutotuneOptions &options)
+  {
+    AutotuneResult result;
+    const double originalTimeStep = timeStep_;
+    const double maxTimeStep = options.maxTimeStep > 0.0 ? options.maxTimeStep : originalTimeStep;
+    const double minTimeStep = std::min(options.minTimeStep, maxTimeStep);
+    const unsigned int steps = std::max(options.steps, 1u);
+
+    if (!bus_)
+    {
+      result.error = "the bus is not started";
+    }
+    else if (!std::isfinite(maxTimeStep) || maxTimeStep <= 0.0 || !std::isfinite(minTimeStep) ||
+             std::floor(minTimeStep * 1e9) < 1.0)
+    {
+      std::stringstream ss;
+      ss << "invalid time step bounds " << minTimeStep << "s to " << maxTimeStep << "s";
+      result.error = ss.str();
+    }
+    else if (options.cyclesPerStep == 0)
+    {
+      result.error = "no cycles per time step";
+    }
+    else if (isUpdatedByOtherThread())
+    {
+      // the tried time steps would interleave with the cycles of the other thread.
+      result.error = "update() is called by another thread, call autotuneTimeStep() from the update thread instead";
+    }
+    if (!result.error.empty())
+    {
+      MELO_ERROR_STREAM("[EthercatMaster::" << (bus_ ? bus_->getName() : configuration_.networkInterface) << "] " << result.toString())
+      return result;
+    }
+
+    for (unsigned int step = 0; step < steps; step++)
+    {
+      AutotuneStepResult stepResult;
+      const double exponent = steps > 1 ? static_cast<double>(step) / (steps - 1) : 0.0;
+      stepResult.timeStep = maxTimeStep * std::pow(minTimeStep / maxTimeStep, exponent);
+
+      // devices and SYNC0 follow the tried time step.
+      applyTimeStep(stepResult.timeStep);
+      resetCycleStatistics();
+      for (unsigned int cycle = 0; cycle < options.cyclesPerStep; cycle++)
+      {
+        update(UpdateMode::StandaloneEnforceStep);
+      }
+
+      const CycleStatistics statistics = getCycleStatistics();
+      stepResult.cycles = statistics.cycles;
+      stepResult.overruns = statistics.overruns;
+      stepResult.meanRoundtripNs = statistics.meanRoundtripNs;
+      stepResult.maxRoundtripNs = statistics.maxRoundtripNs;
+      stepResult.workingCounterErrors = statistics.workingCounterErrors;
+      stepResult.maxDcSyncErrorNs = bus_->readMaxDcSyncErrorNs();
+      stepResult.passed = statistics.cycles > 0 &&
+                          static_cast<double>(statistics.overruns) <= options.maxOverrunRatio * static_cast<double>(statistics.cycles) &&
+                          statistics.workingCounterErrors <= options.maxWorkingCounterErrors &&
+                          stepResult.maxDcSyncErrorNs <= options.maxDcSyncErrorNs;
+      result.steps.push_back(stepResult);
+      MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] Autotune time step " << stepResult.timeStep * 1e6
+                                           << "us: " << (stepResult.passed ? "passed" : "failed"))
+      if (!stepResult.passed)
+      {
+        // shorter time steps will not perform better.
+        break;
+      }
+      result.success = true;
+      result.shortestSafeTimeStep = stepResult.timeStep;
+    }
+
+    if (result.success)
+    {
+      result.recommendedTimeStep = std::min(result.shortestSafeTimeStep * (1.0 + options.margin), maxTimeStep);
+    }
+
+    if (result.success && options.apply)
+    {
+      applyTimeStep(result.recommendedTimeStep);
+      result.applied = true;
+    }
+    else
+    {
+      applyTimeStep(originalTimeStep);
+    }
+    resetCycleStatistics();
+
+    MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] Autotune result:\n" << result.toString())
+    return result;
+  }
+
+  std::vector<FirmwareUpdateProgress> EthercatMaster::updateFirmware(const std::vector<FirmwareUpdateJob> &jobs,
+                                                                     const FirmwareUpdateOptions &options,
+                                                                     const FirmwareUpdateProgressCallback &progressCallback)
+  {
+    {
+      std::lock_guard<std::mutex> lock(firmwareUpdateMutex_);
+      firmwareUpdateProgress_.assign(jobs.size(), FirmwareUpdateProgress{});
+      for (size_t i = 0; i < jobs.size(); i++)
+      {
+        firmwareUpdateProgress_[i].slave = jobs[i].slave;
+      }
+    }
+    auto setProgress = [&](size_t job, const std::function<void(FirmwareUpdateProgress &)> &modify)
+    {
+      FirmwareUpdateProgress progress;
+      {
+        std::lock_guard<std::mutex> lock(firmwareUpdateMutex_);
+        modify(firmwareUpdateProgress_[job]);
+        progress = firmwareUpdateProgress_[job];
+      }
+      if (progressCallback)
+      {
+        progressCallback(progress);
+      }
+    };
+    auto fail = [&](size_t job, const std::string &error)
+    {
+      setProgress(job,
+                  [&](FirmwareUpdateProgress &progress)
+                  {
+                    progress.state = FirmwareUpdateState::Failed;
+                    progress.error = error;
+                  });
+      MELO_ERROR_STREAM("[EthercatMaster::" << bus_->getName() << "] Firmware update of slave " << jobs[job].slave << " failed: " << error)
+    };
+    // a failed transfer must not leave the slave in BOOT with the boot mailbox in the slave list.
+    auto failInBoot = [&](size_t job, const std::string &error)
+    {
+      if (!bus_->leaveBootState(jobs[job].slave))
+      {
+        fail(job, error + ", slave did not return to INIT");
+        return;
+      }
+      fail(job, error);
+    };
+
+    // slaves in BOOT drop out of the process data, they must not be recovered.
+    inhibitSlaveRecovery();
+
+    std::atomic<size_t> nextJob{0};
+    auto worker = [&]()
+    {
+      for (size_t job = nextJob++; job < jobs.size(); job = nextJob++)
+      {
+        const FirmwareUpdateJob &update = jobs[job];
+        const FirmwareImageCache::Image image = firmwareImageCache_.get(update.imagePath);
+        if (!image)
+        {
+          fail(job, "cannot read image " + update.imagePath);
+          continue;
+        }
+        setProgress(job,
+                    [&](FirmwareUpdateProgress &progress)
+                    {
+                      progress.state = FirmwareUpdateState::Transferring;
+                      progress.imageSize = image->size();
+                    });
+
+        // the boot mailbox replaces the standard mailbox until the slave leaves BOOT.
+        if (!bus_->enterBootState(update.slave))
+        {
+          fail(job, "slave did not enter BOOT");
+          continue;
+        }
+
+        const std::string fileName =
+            update.fileName.empty() ? std::filesystem::path(update.imagePath).filename().string() : update.fileName;
+        const size_t imageSize = image->size();
+        const bool written = bus_->writeFirmware(
+            update.slave, fileName, update.password, *image,
+            [&](size_t remainingBytes)
+            {
+              setProgress(job,
+                          [&](FirmwareUpdateProgress &progress)
+                          { progress.bytesTransferred = imageSize - std::min(remainingBytes, imageSize); });
+            },
+            options.packetTimeoutUs);
+        if (!written)
+        {
+          failInBoot(job, "FoE write failed");
+          continue;
+        }
+        setProgress(job, [&](FirmwareUpdateProgress &progress) { progress.bytesTransferred = imageSize; });
+
+        if (options.verify)
+        {
+          setProgress(job, [&](FirmwareUpdateProgress &progress) { progress.state = FirmwareUpdateState::Verifying; });
+          std::vector<char> readBack(imageSize);
+          if (!bus_->readFirmware(update.slave, fileName, update.password, readBack, options.packetTimeoutUs))
+          {
+            failInBoot(job, "FoE read back failed");
+            continue;
+          }
+          if (readBack != *image)
+          {
+            failInBoot(job, "read back image differs");
+            continue;
+          }
+        }
+
+        // the object dictionary of the new firmware may differ, cached objects must be read again.
+        for (const size_t index : devices_.findAt(0, update.slave))
+        {
+          devices_[index]->invalidateSdoCache();
+        }
+
+        if (options.returnToInit && !bus_->leaveBootState(update.slave))
+        {
+          fail(job, "slave did not return to INIT");
+          continue;
+        }
+        setProgress(job, [&](FirmwareUpdateProgress &progress) { progress.state = FirmwareUpdateState::Done; });
+        MELO_INFO_STREAM("[EthercatMaster::" << bus_->getName() << "] Firmware update of slave " << update.slave << " done.")
+      }
+    };
+
+    const size_t workerCount = std::min<size_t>(std::max(options.maxConcurrentTransfers, 1u), jobs.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; i++)
+    {
+      workers.emplace_back(worker);
+    }
+    for (auto &thread : workers)
+    {
+      thread.join();
+    }
+
+    releaseSlaveRecovery();
+    return getFirmwareUpdateProgress();
+  }
+
+  std::vector<FirmwareUpdateProgress> EthercatMaster::getFirmwareUpdateProgress()
+  {
+    std::lock_guard<std::mutex> lock(firmwareUpdateMutex_);
+    return firmwareUpdateProgress_;
+  }
+
 } // namespace ecat_master
@@ -0,0 +1,85 @@
+#include "ethercat_sdk_master/ExternalTrigger.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <ctime>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr int64_t billion{1000000000};
+
+int64_t toNs(const timespec& time) {
+  return billion * time.tv_sec + time.tv_nsec;
+}
+
+}  // namespace
+
+void ExternalTrigger::setFd(int fd, const CycleNotification* notification) {
+  fd_ = fd;
+  notification_ = notification;
+  // timerfd_gettime fails with EINVAL for other file descriptors.
+  itimerspec timer{};
+  timer_ = fd >= 0 && timerfd_gettime(fd, &timer) == 0;
+}
+
+bool ExternalTrigger::wait(long timeoutNs, int64_t& triggerTimeNs, uint64_t& triggers) {
+  const timespec timeout{timeoutNs / billion, timeoutNs % billion};
+  triggers = 0;
+  if (fd_ < 0) {
+    nanosleep(&timeout, nullptr);
+    return false;
+  }
+  pollfd descriptor{fd_, POLLIN, 0};
+  if (ppoll(&descriptor, 1, &timeout, nullptr) <= 0) {
+    return false;
+  }
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  // stored before the eventfd was signalled, at least as recent as the notification which woke us up.
+  const int64_t notifyTimeNs = notification_ != nullptr ? notification_->getNotifyTimeNs() : 0;
+  // eventfd and timerfd both return a 64 bit counter.
+  if (read(fd_, &triggers, sizeof(triggers)) != sizeof(triggers)) {
+    return false;
+  }
+  triggerTimeNs = toNs(now);
+  if (notifyTimeNs != 0) {
+    triggerTimeNs = notifyTimeNs;
+    return true;
+  }
+  itimerspec timer{};
+  if (timer_ && timerfd_gettime(fd_, &timer) == 0 && (timer.it_interval.tv_sec != 0 || timer.it_interval.tv_nsec != 0)) {
+    // the last expiration was one interval before the next one.
+    triggerTimeNs += toNs(timer.it_value) - toNs(timer.it_interval);
+  }
+  return true;
+}
+
+CycleNotification::~CycleNotification() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool CycleNotification::open() {
+  if (fd_ < 0) {
+    fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  }
+  return fd_ >= 0;
+}
+
+void CycleNotification::notify(int64_t timeNs) {
+  notifyTimeNs_.store(timeNs, std::memory_order_release);
+  if (fd_ >= 0) {
+    const uint64_t value = 1;
+    // fails only if the counter would overflow, i.e. nobody waits.
+    (void)!write(fd_, &value, sizeof(value));
+  }
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,51 @@
+#include "ethercat_sdk_master/FirmwareUpdate.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace ecat_master {
+
+std::string firmwareUpdateStateToString(FirmwareUpdateState state) {
+  switch (state) {
+    case FirmwareUpdateState::Pending:
+      return "pending";
+    case FirmwareUpdateState::Transferring:
+      return "transferring";
+    case FirmwareUpdateState::Verifying:
+      return "verifying";
+    case FirmwareUpdateState::Done:
+      return "done";
+    case FirmwareUpdateState::Failed:
+      return "failed";
+  }
+  return "unknown";
+}
+
+FirmwareImageCache::Image FirmwareImageCache::get(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto image = images_.find(path);
+  if (image != images_.end()) {
+    return image->second;
+  }
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return nullptr;
+  }
+  auto data = std::make_shared<std::vector<char>>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  if (data->empty()) {
+    return nullptr;
+  }
+  images_.emplace(path, data);
+  return data;
+}
+
+void FirmwareImageCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  images_.clear();
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,56 @@
+#include "ethercat_sdk_master/InputChangeDetector.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ecat_master {
+
+void InputChangeDetector::configure(const std::vector<Region>& regions) {
+  regions_ = regions;
+  shadowOffsets_.clear();
+  size_t size = 0;
+  for (const auto& region : regions_) {
+    shadowOffsets_.push_back(size);
+    size += region.size;
+  }
+  shadow_.assign(size, 0);
+  changed_.assign(regions_.size(), 1);
+  initialized_ = false;
+}
+
+void InputChangeDetector::update() {
+  for (size_t i = 0; i < regions_.size(); i++) {
+    const Region& region = regions_[i];
+    uint8_t* shadow = shadow_.data() + shadowOffsets_[i];
+    const bool regionChanged = !initialized_ || !equal(region.data, shadow, region.size);
+    if (regionChanged) {
+      std::memcpy(shadow, region.data, region.size);
+    }
+    changed_[i] = regionChanged ? 1 : 0;
+  }
+  initialized_ = true;
+}
+
+bool InputChangeDetector::equal(const uint8_t* a, const uint8_t* b, size_t size) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= size; i += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xffff) {
+      return false;
+    }
+  }
+#endif
+  for (; i < size; i++) {
+    if (a[i] != b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace ecat_master
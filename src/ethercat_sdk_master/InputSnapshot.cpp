@@ -0,0 +1,152 @@
+#include "ethercat_sdk_master/InputSnapshot.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+namespace ecat_master {
+
+namespace {
+
+// a reader racing with the update thread retries, the update thread never waits.
+constexpr int readAttempts{4};
+
+}  // namespace
+
+bool InputSnapshotBuffer::configure(size_t imageSize) {
+  if (configured_) {
+    return imageSize == imageSize_;
+  }
+  imageSize_ = imageSize;
+  for (auto& slot : slots_) {
+    slot.data.resize(imageSize);
+  }
+  configured_.store(true, std::memory_order_release);
+  return true;
+}
+
+void InputSnapshotBuffer::publish(uint64_t cycle, int64_t stampNs, const uint8_t* inputs) {
+  if (!configured_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  const uint64_t published = published_.load(std::memory_order_relaxed);
+  Slot& slot = slots_[published % depth];
+  const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.cycle.store(cycle, std::memory_order_relaxed);
+  slot.stampNs.store(stampNs, std::memory_order_relaxed);
+  if (imageSize_ > 0) {
+    std::memcpy(slot.data.data(), inputs, imageSize_);
+  }
+  slot.sequence.store(sequence + 2, std::memory_order_release);
+  published_.store(published + 1, std::memory_order_release);
+}
+
+bool InputSnapshotBuffer::readSlot(const Slot& slot, uint64_t& cycle, int64_t& stampNs, uint8_t* data) const {
+  const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+  if (sequence == 0 || (sequence & 1) != 0) {
+    return false;
+  }
+  cycle = slot.cycle.load(std::memory_order_relaxed);
+  stampNs = slot.stampNs.load(std::memory_order_relaxed);
+  if (data != nullptr && imageSize_ > 0) {
+    std::memcpy(data, slot.data.data(), imageSize_);
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+bool InputSnapshotBuffer::getLatestStamp(int64_t& stampNs) const {
+  if (!configured_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  for (int attempt = 0; attempt < readAttempts; attempt++) {
+    const uint64_t published = published_.load(std::memory_order_acquire);
+    if (published == 0) {
+      return false;
+    }
+    uint64_t cycle = 0;
+    if (readSlot(slots_[(published - 1) % depth], cycle, stampNs, nullptr)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool InputSnapshotBuffer::read(int64_t stampNs, BusInputSample& sample) const {
+  sample.valid = false;
+  if (!configured_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  sample.inputs.resize(imageSize_);
+  for (int attempt = 0; attempt < readAttempts; attempt++) {
+    const uint64_t published = published_.load(std::memory_order_acquire);
+    const uint64_t available = std::min<uint64_t>(published, depth);
+    // the slot closest to the stamp, its data is copied afterwards.
+    const Slot* best = nullptr;
+    int64_t bestDistance = std::numeric_limits<int64_t>::max();
+    for (uint64_t i = 1; i <= available; i++) {
+      const Slot& slot = slots_[(published - i) % depth];
+      uint64_t cycle = 0;
+      int64_t slotStampNs = 0;
+      if (!readSlot(slot, cycle, slotStampNs, nullptr)) {
+        continue;
+      }
+      const int64_t distance = slotStampNs > stampNs ? slotStampNs - stampNs : stampNs - slotStampNs;
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        best = &slot;
+      }
+    }
+    if (best == nullptr) {
+      return false;
+    }
+    if (readSlot(*best, sample.cycle, sample.stampNs, sample.inputs.data())) {
+      sample.valid = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool InputSnapshotReader::read(MultiBusSnapshot& snapshot) const {
+  snapshot.buses.resize(sources_.size());
+  int64_t referenceStampNs = std::numeric_limits<int64_t>::max();
+  bool complete = !sources_.empty();
+  for (const auto& source : sources_) {
+    int64_t stampNs = 0;
+    if (source.second->getLatestStamp(stampNs)) {
+      referenceStampNs = std::min(referenceStampNs, stampNs);
+    } else {
+      complete = false;
+    }
+  }
+  if (referenceStampNs == std::numeric_limits<int64_t>::max()) {
+    referenceStampNs = 0;
+  }
+  snapshot.referenceStampNs = referenceStampNs;
+
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  const int64_t nowNs = 1000000000LL * now.tv_sec + now.tv_nsec;
+  int64_t minStampNs = std::numeric_limits<int64_t>::max();
+  int64_t maxStampNs = std::numeric_limits<int64_t>::min();
+  for (size_t i = 0; i < sources_.size(); i++) {
+    BusInputSample& sample = snapshot.buses[i];
+    sample.networkInterface = sources_[i].first;
+    if (!sources_[i].second->read(referenceStampNs, sample)) {
+      complete = false;
+      continue;
+    }
+    sample.ageNs = nowNs - sample.stampNs;
+    sample.offsetNs = sample.stampNs - referenceStampNs;
+    minStampNs = std::min(minStampNs, sample.stampNs);
+    maxStampNs = std::max(maxStampNs, sample.stampNs);
+  }
+  snapshot.skewNs = maxStampNs >= minStampNs ? maxStampNs - minStampNs : 0;
+  return complete;
+}
+
+}  // namespace ecat_master
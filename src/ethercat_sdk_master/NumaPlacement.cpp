@@ -0,0 +1,107 @@
+#include "ethercat_sdk_master/NumaPlacement.hpp"
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+
+namespace ecat_master {
+
+namespace {
+
+// "0-3,8-11" to 0, 1, 2, 3, 8, 9, 10, 11.
+std::vector<int> parseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    std::stringstream rangeStream(range);
+    int first = 0;
+    if (!(rangeStream >> first)) {
+      continue;
+    }
+    int last = first;
+    char separator = 0;
+    if (rangeStream >> separator && separator == '-') {
+      rangeStream >> last;
+    }
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::string cpusToString(const std::vector<int>& cpus) {
+  std::stringstream ss;
+  for (size_t i = 0; i < cpus.size(); i++) {
+    ss << (i > 0 ? "," : "") << cpus[i];
+  }
+  return ss.str();
+}
+
+}  // namespace
+
+std::string NumaPlacement::toString() const {
+  std::stringstream ss;
+  if (node < 0) {
+    ss << networkInterface << ": NUMA node unknown, no placement.";
+    return ss.str();
+  }
+  ss << networkInterface << " on NUMA node " << node << " (CPUs " << cpusToString(cpus) << "), pages on the node:";
+  for (const auto& region : regions) {
+    ss << "\n  " << region.name << ": " << region.movedPages << " of " << region.pages;
+    if (region.node != node) {
+      ss << " on node " << region.node;
+    }
+  }
+  return ss.str();
+}
+
+int getNetworkInterfaceNumaNode(const std::string& networkInterface) {
+  std::ifstream file("/sys/class/net/" + networkInterface + "/device/numa_node");
+  int node = -1;
+  if (!(file >> node)) {
+    return -1;
+  }
+  return node;
+}
+
+std::vector<int> getNumaNodeCpus(int node) {
+  if (node < 0) {
+    return {};
+  }
+  std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  std::string list;
+  std::getline(file, list);
+  return parseCpuList(list);
+}
+
+size_t moveToNumaNode(const void* address, size_t size, int node, size_t& pages) {
+  const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(address) & ~(pageSize - 1);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(address) + size;
+  std::vector<void*> pageAddresses;
+  for (uintptr_t page = begin; page < end; page += pageSize) {
+    pageAddresses.push_back(reinterpret_cast<void*>(page));
+  }
+  pages = pageAddresses.size();
+  std::vector<int> nodes(pages, node);
+  std::vector<int> status(pages, -1);
+  // pages shared with other processes stay where they are.
+  if (syscall(SYS_move_pages, 0, pages, pageAddresses.data(), nodes.data(), status.data(), MPOL_MF_MOVE) < 0) {
+    return 0;
+  }
+  size_t moved = 0;
+  for (const int pageNode : status) {
+    moved += pageNode == node ? 1 : 0;
+  }
+  return moved;
+}
+
+}  // namespace ecat_master
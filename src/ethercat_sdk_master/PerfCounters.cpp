@@ -0,0 +1,167 @@
+#include "ethercat_sdk_master/PerfCounters.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <sstream>
+
+namespace ecat_master {
+
+namespace {
+
+const char* counterNames[PerfCounters::Size] = {"instructions", "cpu cycles", "cache misses", "context switches"};
+
+int openEvent(uint32_t type, uint64_t config, bool excludeKernel) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  // user space only is permitted up to perf_event_paranoid 2.
+  attr.exclude_kernel = excludeKernel ? 1 : 0;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+inline uint64_t rdpmc(uint32_t counter) {
+  uint32_t low = 0;
+  uint32_t high = 0;
+  asm volatile("rdpmc" : "=a"(low), "=d"(high) : "c"(counter));
+  return static_cast<uint64_t>(high) << 32 | low;
+}
+#endif
+
+}  // namespace
+
+PerfCounters::~PerfCounters() {
+  close();
+}
+
+bool PerfCounters::open() {
+  close();
+  const std::array<std::pair<uint32_t, uint64_t>, Size> configs{{{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                                                                 {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                                                                 {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+                                                                 {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}}};
+  const long pageSize = sysconf(_SC_PAGESIZE);
+  for (unsigned int counter = 0; counter < Size; counter++) {
+    const bool hardware = configs[counter].first == PERF_TYPE_HARDWARE;
+    // context switches happen in the kernel and are not counted with exclude_kernel.
+    Event& event = events_[counter];
+    event.fd = openEvent(configs[counter].first, configs[counter].second, hardware);
+    if (event.fd < 0 || !hardware) {
+      continue;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    void* page = mmap(nullptr, static_cast<size_t>(pageSize), PROT_READ, MAP_SHARED, event.fd, 0);
+    if (page == MAP_FAILED) {
+      continue;
+    }
+    if (static_cast<const perf_event_mmap_page*>(page)->cap_user_rdpmc) {
+      event.page = page;
+    } else {
+      munmap(page, static_cast<size_t>(pageSize));
+    }
+#else
+    (void)pageSize;
+#endif
+  }
+  return isOpen();
+}
+
+void PerfCounters::close() {
+  const long pageSize = sysconf(_SC_PAGESIZE);
+  for (auto& event : events_) {
+    if (event.page != nullptr) {
+      munmap(event.page, static_cast<size_t>(pageSize));
+    }
+    if (event.fd >= 0) {
+      ::close(event.fd);
+    }
+    event = Event{};
+  }
+  sampled_ = false;
+}
+
+bool PerfCounters::isOpen() const {
+  for (const auto& event : events_) {
+    if (event.fd >= 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t PerfCounters::read(const Event& event) const {
+  if (event.fd < 0) {
+    return 0;
+  }
+#if defined(__x86_64__) || defined(__i386__)
+  if (event.page != nullptr) {
+    // self-monitoring sequence of perf_event_open(2), retried if the kernel updated the page meanwhile.
+    const volatile perf_event_mmap_page* page = static_cast<const volatile perf_event_mmap_page*>(event.page);
+    uint32_t sequence = 0;
+    uint64_t count = 0;
+    bool scheduled = false;
+    do {
+      sequence = page->lock;
+      asm volatile("" ::: "memory");
+      const uint32_t index = page->index;
+      count = static_cast<uint64_t>(page->offset);
+      scheduled = page->cap_user_rdpmc && index != 0;
+      if (scheduled) {
+        const uint16_t width = page->pmc_width;
+        int64_t pmc = static_cast<int64_t>(rdpmc(index - 1));
+        pmc = static_cast<int64_t>(static_cast<uint64_t>(pmc) << (64 - width)) >> (64 - width);
+        count += static_cast<uint64_t>(pmc);
+      }
+      asm volatile("" ::: "memory");
+    } while (page->lock != sequence);
+    if (scheduled) {
+      return count;
+    }
+  }
+#endif
+  uint64_t count = 0;
+  if (::read(event.fd, &count, sizeof(count)) != sizeof(count)) {
+    return 0;
+  }
+  return count;
+}
+
+bool PerfCounters::sample(PerfCounterValues& values) {
+  std::array<uint64_t, Size> current{};
+  for (unsigned int counter = 0; counter < Size; counter++) {
+    current[counter] = read(events_[counter]);
+  }
+  const bool valid = sampled_;
+  values.instructions = static_cast<double>(current[Instructions] - previous_[Instructions]);
+  values.cpuCycles = static_cast<double>(current[CpuCycles] - previous_[CpuCycles]);
+  values.cacheMisses = static_cast<double>(current[CacheMisses] - previous_[CacheMisses]);
+  values.contextSwitches = static_cast<double>(current[ContextSwitches] - previous_[ContextSwitches]);
+  previous_ = current;
+  sampled_ = true;
+  return valid;
+}
+
+std::string PerfCounters::toString() const {
+  std::stringstream ss;
+  std::string unavailable;
+  for (unsigned int counter = 0; counter < Size; counter++) {
+    if (events_[counter].fd < 0) {
+      unavailable += unavailable.empty() ? counterNames[counter] : std::string{", "} + counterNames[counter];
+      continue;
+    }
+    ss << counterNames[counter] << (events_[counter].page != nullptr ? " (rdpmc)" : " (read)") << ", ";
+  }
+  std::string available = ss.str();
+  if (!available.empty()) {
+    available.resize(available.size() - 2);
+  }
+  return "Performance counters: " + (available.empty() ? std::string{"none"} : available) +
+         (unavailable.empty() ? "" : "; unavailable: " + unavailable);
+}
+
+}  // namespace ecat_master
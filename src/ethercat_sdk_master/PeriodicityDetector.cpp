@@ -0,0 +1,331 @@
+#include "ethercat_sdk_master/PeriodicityDetector.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+namespace ecat_master {
+
+namespace {
+
+// the update thread pushes one sample per cycle, the analysis of a window blocks the draining for a while.
+constexpr size_t sampleQueueCapacity{16384};
+constexpr std::chrono::milliseconds drainInterval{50};
+// lowest DFT bin analysed, the window covers at least two periods.
+constexpr size_t minBin{2};
+// Goertzel filters computed in one pass over the window.
+constexpr size_t interleavedFilters{4};
+// folds of the window to find the exact period.
+constexpr double maxFolds{256.0};
+// a period is reported if its autocorrelation exceeds this many standard deviations of the autocorrelation of noise.
+constexpr double detectionThreshold{6.0};
+// every multiple of a period correlates as well, the shortest lag correlating with this share of the strongest is the period.
+constexpr double multipleRatio{0.8};
+// harmonics counted if they exceed the noise by this many standard deviations.
+constexpr size_t maxHarmonics{16};
+constexpr double harmonicThreshold{3.0};
+constexpr size_t maxComponents{8};
+// half width of the main lobe of the Hann window [bins].
+constexpr size_t mainLobeBins{2};
+// mean and standard deviation of a Rayleigh distributed amplitude (noise only bins) relative to its median.
+constexpr double rayleighMean{1.0645};
+constexpr double rayleighDeviation{0.5564};
+
+}  // namespace
+
+std::string PeriodicityReport::toString() const {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(1) << "Cycle lateness, " << windows << " windows of " << windowDuration << "s (mean "
+     << meanLatenessNs / 1e3 << "us, max " << maxLatenessNs / 1e3 << "us, noise floor " << noiseFloorNs / 1e3 << "us, dropped samples "
+     << droppedSamples << "):";
+  if (components.empty()) {
+    ss << "\n  no periodic interference";
+  }
+  for (const auto& component : components) {
+    ss << "\n  period " << std::setprecision(4) << component.period << "s (" << std::setprecision(1) << component.periodCycles
+       << " cycles): amplitude " << component.amplitudeNs / 1e3 << "us peak to peak, correlation " << std::setprecision(2)
+       << component.correlation << ", " << component.harmonics << " harmonics";
+  }
+  return ss.str();
+}
+
+PeriodicityDetector::~PeriodicityDetector() { stop(); }
+
+void PeriodicityDetector::start(unsigned int windowCycles) {
+  stop();
+  windowCycles_ = std::max(windowCycles, static_cast<unsigned int>(4 * minBin));
+  if (!queue_) {
+    queue_ = std::make_unique<SpscQueue<Sample>>(sampleQueueCapacity);
+  }
+  cycleStarts_.clear();
+  cycleStarts_.reserve(windowCycles_);
+  lateness_.clear();
+  lateness_.reserve(windowCycles_);
+  hannWindow_.resize(windowCycles_);
+  for (size_t i = 0; i < windowCycles_; i++) {
+    hannWindow_[i] = 0.5 * (1.0 - std::cos(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(windowCycles_)));
+  }
+  droppedSamples_ = 0;
+  {
+    std::lock_guard<std::mutex> lock(reportMutex_);
+    report_ = PeriodicityReport{};
+  }
+  running_ = true;
+  analysisThread_ = std::thread(&PeriodicityDetector::analyse, this);
+}
+
+void PeriodicityDetector::stop() {
+  running_ = false;
+  if (analysisThread_.joinable()) {
+    analysisThread_.join();
+  }
+}
+
+PeriodicityReport PeriodicityDetector::getReport() const {
+  std::lock_guard<std::mutex> lock(reportMutex_);
+  PeriodicityReport report = report_;
+  report.droppedSamples = droppedSamples_;
+  return report;
+}
+
+void PeriodicityDetector::analyse() {
+  // the analysis must never compete with the real time threads.
+  sched_param param{};
+  param.sched_priority = 0;
+  pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+  Sample sample;
+  while (running_) {
+    std::this_thread::sleep_for(drainInterval);
+    while (running_ && queue_->pop(sample)) {
+      cycleStarts_.push_back(sample.cycleStartNs);
+      lateness_.push_back(static_cast<double>(sample.latenessNs));
+      if (lateness_.size() == windowCycles_) {
+        analyseWindow();
+        cycleStarts_.clear();
+        lateness_.clear();
+      }
+    }
+  }
+}
+
+void PeriodicityDetector::analyseWindow() {
+  const size_t n = lateness_.size();
+  const size_t maxBin = n / 2;
+  const size_t maxLag = n / minBin;
+  const double mean = std::accumulate(lateness_.begin(), lateness_.end(), 0.0) / static_cast<double>(n);
+  const double windowGain = std::accumulate(hannWindow_.begin(), hannWindow_.end(), 0.0);
+  std::vector<double> weighted(n);
+  for (size_t i = 0; i < n; i++) {
+    weighted[i] = (lateness_[i] - mean) * hannWindow_[i];
+  }
+
+  // one Goertzel filter per DFT bin, amplitude of a sine at the bin frequency. Several filters run interleaved, which
+  // hides the latency of the recursion.
+  amplitudes_.assign(maxBin + 1, 0.0);
+  for (size_t first = minBin; first <= maxBin; first += interleavedFilters) {
+    const size_t count = std::min(interleavedFilters, maxBin + 1 - first);
+    double coefficients[interleavedFilters] = {};
+    double s1[interleavedFilters] = {};
+    double s2[interleavedFilters] = {};
+    for (size_t j = 0; j < count; j++) {
+      coefficients[j] = 2.0 * std::cos(2.0 * M_PI * static_cast<double>(first + j) / static_cast<double>(n));
+    }
+    for (const double x : weighted) {
+      for (size_t j = 0; j < interleavedFilters; j++) {
+        const double s0 = x + coefficients[j] * s1[j] - s2[j];
+        s2[j] = s1[j];
+        s1[j] = s0;
+      }
+    }
+    for (size_t j = 0; j < count; j++) {
+      const double power = s1[j] * s1[j] + s2[j] * s2[j] - coefficients[j] * s1[j] * s2[j];
+      amplitudes_[first + j] = 2.0 * std::sqrt(std::max(power, 0.0)) / windowGain;
+    }
+  }
+  std::vector<double> sorted(amplitudes_.begin() + minBin, amplitudes_.end());
+  std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+  const double noiseFloor = sorted[sorted.size() / 2];
+
+  std::vector<double> power(maxBin + 1, 0.0);
+  for (size_t k = minBin; k <= maxBin; k++) {
+    power[k] = amplitudes_[k] * amplitudes_[k];
+  }
+  const double variance = std::accumulate(power.begin(), power.end(), 0.0);
+
+  PeriodicityReport report;
+  const double cyclePeriodNs = static_cast<double>(cycleStarts_.back() - cycleStarts_.front()) / static_cast<double>(n - 1);
+  report.windowDuration = cyclePeriodNs * static_cast<double>(n) / 1e9;
+  report.meanLatenessNs = mean;
+  report.maxLatenessNs = *std::max_element(lateness_.begin(), lateness_.end());
+  report.noiseFloorNs = noiseFloor;
+  if (variance <= 0.0) {
+    std::lock_guard<std::mutex> lock(reportMutex_);
+    report.windows = report_.windows + 1;
+    report_ = std::move(report);
+    return;
+  }
+
+  // autocorrelation from the power spectrum (Wiener-Khinchin) relative to the variance of the analysed bins, updated
+  // when a component is removed from the spectrum.
+  std::vector<double> cosines(n);
+  for (size_t i = 0; i < n; i++) {
+    cosines[i] = std::cos(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(n));
+  }
+  std::vector<double> correlation(maxLag + 2, 0.0);
+  auto addToCorrelation = [&](size_t k, double powerChange) {
+    const double weight = powerChange / variance;
+    // (k * lag) mod n
+    size_t index = 0;
+    for (size_t lag = 0; lag < correlation.size(); lag++) {
+      correlation[lag] += weight * cosines[index];
+      index += k;
+      if (index >= n) {
+        index -= n;
+      }
+    }
+  };
+  for (size_t k = minBin; k <= maxBin; k++) {
+    addToCorrelation(k, power[k]);
+  }
+  const double threshold = detectionThreshold / std::sqrt(static_cast<double>(maxBin - minBin + 1));
+
+  // peak to peak of the mean lateness per cycle of the period.
+  std::vector<double> foldSums;
+  std::vector<unsigned int> foldCounts;
+  auto fold = [&](double periodCycles) {
+    const size_t bins = std::clamp<size_t>(static_cast<size_t>(std::round(periodCycles)), 2, maxLag);
+    const double binsPerCycle = static_cast<double>(bins) / periodCycles;
+    foldSums.assign(bins, 0.0);
+    foldCounts.assign(bins, 0);
+    double phase = 0.0;
+    for (size_t i = 0; i < n; i++) {
+      const size_t bin = std::min(static_cast<size_t>(phase * binsPerCycle), bins - 1);
+      foldSums[bin] += lateness_[i];
+      foldCounts[bin]++;
+      phase += 1.0;
+      if (phase >= periodCycles) {
+        phase -= periodCycles;
+      }
+    }
+    double lowest = std::numeric_limits<double>::max();
+    double highest = std::numeric_limits<double>::lowest();
+    for (size_t bin = 0; bin < bins; bin++) {
+      if (foldCounts[bin] > 0) {
+        lowest = std::min(lowest, foldSums[bin] / foldCounts[bin]);
+        highest = std::max(highest, foldSums[bin] / foldCounts[bin]);
+      }
+    }
+    return highest - lowest;
+  };
+
+  auto isPeak = [&](size_t lag) {
+    return lag > minBin && lag < maxLag && correlation[lag] >= correlation[lag - 1] && correlation[lag] > correlation[lag + 1];
+  };
+  // rise of the correlation from half the lag, low for the slow trend of long periods at short lags.
+  auto prominence = [&](size_t lag) { return correlation[lag] - correlation[lag / 2]; };
+  const double harmonicPower = std::pow((rayleighMean + harmonicThreshold * rayleighDeviation) * noiseFloor, 2);
+
+  // strongest component first, it is removed from the spectrum before the next one is searched.
+  while (report.components.size() < maxComponents) {
+    size_t strongest = 0;
+    for (size_t lag = minBin + 1; lag < maxLag; lag++) {
+      if (isPeak(lag) && (strongest == 0 || prominence(lag) > prominence(strongest))) {
+        strongest = lag;
+      }
+    }
+    if (strongest == 0 || correlation[strongest] < threshold || prominence(strongest) < threshold) {
+      break;
+    }
+    size_t lag = strongest;
+    for (size_t divisor = strongest / (minBin + 1); divisor >= 2; divisor--) {
+      const size_t center = static_cast<size_t>(std::round(static_cast<double>(strongest) / static_cast<double>(divisor)));
+      for (size_t candidate = center - 1; candidate <= center + 1; candidate++) {
+        if (isPeak(candidate) && correlation[candidate] >= multipleRatio * correlation[strongest] && prominence(candidate) >= threshold &&
+            (lag == strongest || correlation[candidate] > correlation[lag])) {
+          lag = candidate;
+        }
+      }
+      if (lag != strongest) {
+        break;
+      }
+    }
+
+    // the lag is a whole number of cycles: the correlation peak is interpolated and the exact period is the one with the
+    // sharpest folded shape, searched in steps of half a cycle of phase drift over the window. Short periods would need
+    // too many folds, their frequency is precise in the spectrum: the strongest of their first harmonics is taken.
+    const double curvature = correlation[lag - 1] - 2.0 * correlation[lag] + correlation[lag + 1];
+    double center = static_cast<double>(lag) + (curvature < 0.0 ? 0.5 * (correlation[lag - 1] - correlation[lag + 1]) / curvature : 0.0);
+    const double step = 0.5 * center / static_cast<double>(n);
+    double range = 0.5;
+    if (range / step > maxFolds / 2) {
+      double strongestHarmonic = 0.0;
+      for (size_t m = 1; m <= maxHarmonics; m++) {
+        const size_t low = static_cast<size_t>(std::floor(m * n / (center + 0.5)));
+        const size_t high = std::min(static_cast<size_t>(std::ceil(m * n / (center - 0.5))), maxBin - 1);
+        for (size_t k = std::max(low, minBin + 1); k <= high; k++) {
+          if (power[k] > strongestHarmonic && power[k] >= power[k - 1] && power[k] >= power[k + 1]) {
+            strongestHarmonic = power[k];
+            const double left = std::sqrt(power[k - 1]);
+            const double middle = std::sqrt(power[k]);
+            const double right = std::sqrt(power[k + 1]);
+            const double peakCurvature = left - 2.0 * middle + right;
+            const double bin = static_cast<double>(k) + (peakCurvature < 0.0 ? 0.5 * (left - right) / peakCurvature : 0.0);
+            center = static_cast<double>(m * n) / bin;
+          }
+        }
+      }
+      range = step * maxFolds / 2;
+    }
+    PeriodicComponent component;
+    for (double period = std::max(center - range, static_cast<double>(minBin)); period <= center + range; period += step) {
+      const double amplitude = fold(period);
+      if (amplitude > component.amplitudeNs) {
+        component.amplitudeNs = amplitude;
+        component.periodCycles = period;
+      }
+    }
+    // a component which could not be removed from the spectrum.
+    if (std::any_of(report.components.begin(), report.components.end(), [&](const PeriodicComponent& reported) {
+          return std::abs(reported.periodCycles - component.periodCycles) < 1.0;
+        })) {
+      break;
+    }
+    component.period = component.periodCycles * cyclePeriodNs / 1e9;
+    component.correlation = correlation[lag];
+    // counted in the spectrum without the components found before.
+    const double bin = static_cast<double>(n) / component.periodCycles;
+    for (size_t m = 2; m <= maxHarmonics && m * bin + 1.0 < static_cast<double>(maxBin); m++) {
+      const size_t k = static_cast<size_t>(std::round(m * bin));
+      if (std::max({power[k - 1], power[k], power[k + 1]}) >= harmonicPower) {
+        component.harmonics++;
+      }
+    }
+    report.components.push_back(component);
+
+    // remove the main lobes of the component and its harmonics.
+    for (double harmonic = bin; harmonic < static_cast<double>(maxBin + mainLobeBins); harmonic += bin) {
+      const size_t middle = static_cast<size_t>(std::round(harmonic));
+      for (size_t k = std::max(middle, minBin + mainLobeBins) - mainLobeBins; k <= std::min(middle + mainLobeBins, maxBin); k++) {
+        const double masked = std::min(power[k], noiseFloor * noiseFloor);
+        if (masked < power[k]) {
+          addToCorrelation(k, masked - power[k]);
+          power[k] = masked;
+        }
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(reportMutex_);
+  report.windows = report_.windows + 1;
+  report_ = std::move(report);
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,121 @@
+#include "ethercat_sdk_master/ProcessImageLayout.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr uint32_t cacheLineSize{64};
+constexpr uint32_t maxNaturalAlignment{8};
+
+uint32_t naturalAlignment(uint32_t size) {
+  uint32_t alignment = 1;
+  while (alignment < size && alignment < maxNaturalAlignment) {
+    alignment *= 2;
+  }
+  return alignment;
+}
+
+uint32_t alignUp(uint32_t offset, uint32_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+std::string ProcessImageLayout::toString() const {
+  std::stringstream ss;
+  ss << "Process image: " << outputBytes << " bytes out / " << inputBytes << " bytes in, frames: " << frames
+     << (blockLRW ? ", separate LRD/LWR datagrams" : ", LRW datagrams") << "\n";
+  ss << std::left << std::setw(6) << "Slave" << std::setw(24) << "Name" << std::setw(22) << "Outputs (offset:size)" << std::setw(22)
+     << "Inputs (offset:size)" << "Frames\n";
+  for (const auto& entry : entries) {
+    std::stringstream outputs;
+    outputs << entry.outputOffset << ":" << entry.outputBytes;
+    if (entry.outputStartBit != 0) {
+      outputs << " bit " << static_cast<int>(entry.outputStartBit);
+    }
+    std::stringstream inputs;
+    inputs << entry.inputOffset << ":" << entry.inputBytes;
+    if (entry.inputStartBit != 0) {
+      inputs << " bit " << static_cast<int>(entry.inputStartBit);
+    }
+    ss << std::setw(6) << entry.slave << std::setw(24) << entry.name << std::setw(22) << outputs.str() << std::setw(22) << inputs.str()
+       << entry.outputFrame << "/" << entry.inputFrame << (entry.crossesFrame ? " (split)" : "") << "\n";
+  }
+  return ss.str();
+}
+
+bool planProcessImageLayout(const std::vector<ProcessImageBlock>& blocks, bool align, uint32_t maxFrameSize, uint32_t capacity,
+                            ProcessImagePlan& plan) {
+  plan = ProcessImagePlan{};
+  plan.blocks = blocks;
+
+  // outputs before inputs, hot before the others, otherwise in the current order.
+  std::vector<size_t> order(blocks.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), [&blocks](size_t a, size_t b) {
+    if (blocks[a].input != blocks[b].input) {
+      return !blocks[a].input;
+    }
+    if (blocks[a].hot != blocks[b].hot) {
+      return blocks[a].hot;
+    }
+    return blocks[a].offset < blocks[b].offset;
+  });
+
+  uint32_t offset = 0;
+  uint32_t frameSize = 0;
+  bool inputs = false;
+  for (const size_t index : order) {
+    ProcessImageBlock& block = plan.blocks[index];
+    uint32_t alignment = align ? naturalAlignment(block.size) : 1;
+    if (block.input && !inputs) {
+      inputs = true;
+      // the padding in front of the inputs is part of the outputs, SOEM expects the inputs right behind them.
+      alignment = align ? cacheLineSize : 1;
+      plan.outputBytes = alignUp(offset, alignment);
+    }
+    const uint32_t start = alignUp(offset, alignment);
+    // frames are split in front of a block which does not fit anymore, as SOEM does. Padding belongs to the next block.
+    const uint32_t size = start - offset + block.size;
+    if (plan.frames.empty() || frameSize + size > maxFrameSize) {
+      if (!plan.frames.empty()) {
+        plan.frames.back() = frameSize;
+      }
+      plan.frames.push_back(0);
+      frameSize = 0;
+    }
+    if (frameSize + size > maxFrameSize) {
+      return false;
+    }
+    frameSize += size;
+    block.plannedOffset = start;
+    offset = start + block.size;
+  }
+  if (!plan.frames.empty()) {
+    plan.frames.back() = frameSize;
+  }
+  if (!inputs) {
+    plan.outputBytes = offset;
+  }
+  plan.inputBytes = offset - plan.outputBytes;
+
+  // frame and offset of the first input byte, behind the end of the last frame without inputs.
+  uint32_t frameStart = 0;
+  for (size_t frame = 0; frame < plan.frames.size(); frame++) {
+    plan.inputFrame = static_cast<unsigned int>(frame);
+    plan.inputFrameOffset = plan.outputBytes - frameStart;
+    if (plan.outputBytes < frameStart + plan.frames[frame]) {
+      break;
+    }
+    frameStart += plan.frames[frame];
+  }
+  return offset <= capacity;
+}
+
+}  // namespace ecat_master
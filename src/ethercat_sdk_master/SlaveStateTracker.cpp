@@ -0,0 +1,98 @@
+#include "ethercat_sdk_master/SlaveStateTracker.hpp"
+
+#include <algorithm>
+
+namespace ecat_master {
+
+std::string alStateToString(uint16_t state) {
+  std::string name;
+  switch (state & 0x0f) {
+    case 0x01:
+      name = "INIT";
+      break;
+    case 0x02:
+      name = "PRE_OP";
+      break;
+    case 0x03:
+      name = "BOOT";
+      break;
+    case 0x04:
+      name = "SAFE_OP";
+      break;
+    case 0x08:
+      name = "OPERATIONAL";
+      break;
+    default:
+      name = "NONE";
+      break;
+  }
+  if (state & 0x10) {
+    name += " + ERROR";
+  }
+  return name;
+}
+
+void SlaveStateTracker::reset(size_t numberOfSlaves) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  current_.assign(numberOfSlaves, SlaveStateSample{});
+  lastUpdate_ = {};
+  history_.assign(numberOfSlaves, std::vector<SlaveStateSample>(historyLength_));
+  historyHead_.assign(numberOfSlaves, 0);
+  historySize_.assign(numberOfSlaves, 0);
+}
+
+std::vector<uint16_t> SlaveStateTracker::update(const std::vector<SlaveAlStatus>& states, std::chrono::system_clock::time_point stamp) {
+  std::vector<uint16_t> changedSlaves;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (states.size() != current_.size() || historyLength_ == 0) {
+    return changedSlaves;
+  }
+  lastUpdate_ = stamp;
+
+  for (size_t i = 0; i < states.size(); i++) {
+    if (historySize_[i] > 0 && current_[i].status == states[i]) {
+      continue;
+    }
+    current_[i] = SlaveStateSample{stamp, states[i]};
+    history_[i][historyHead_[i]] = current_[i];
+    historyHead_[i] = (historyHead_[i] + 1) % historyLength_;
+    historySize_[i] = std::min(historySize_[i] + 1, historyLength_);
+    changedSlaves.push_back(static_cast<uint16_t>(i + 1));
+  }
+  return changedSlaves;
+}
+
+std::vector<SlaveStateSample> SlaveStateTracker::getCurrentStates() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return current_;
+}
+
+SlaveStateSample SlaveStateTracker::getCurrentState(uint16_t slave) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slave == 0 || slave > current_.size()) {
+    return SlaveStateSample{};
+  }
+  return current_[slave - 1];
+}
+
+std::vector<SlaveStateSample> SlaveStateTracker::getHistory(uint16_t slave) const {
+  std::vector<SlaveStateSample> history;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slave == 0 || slave > current_.size()) {
+    return history;
+  }
+  const size_t index = slave - 1;
+  const size_t size = historySize_[index];
+  const size_t oldest = (historyHead_[index] + historyLength_ - size) % historyLength_;
+  for (size_t i = 0; i < size; i++) {
+    history.push_back(history_[index][(oldest + i) % historyLength_]);
+  }
+  return history;
+}
+
+std::chrono::system_clock::time_point SlaveStateTracker::getLastUpdate() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return lastUpdate_;
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,216 @@
+#include "ethercat_sdk_master/StallWatchdog.hpp"
+
+#include <execinfo.h>
+#include <sched.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+
+namespace ecat_master {
+
+namespace {
+
+// real time signal used to capture the stack of the monitored thread.
+const int backtraceSignal = SIGRTMIN + 4;
+constexpr int maxBacktraceFrames{64};
+// time the monitored thread gets to run the signal handler.
+constexpr std::chrono::milliseconds backtraceTimeout{100};
+
+// one capture at a time, serialized by backtraceMutex. The handler only writes into this preallocated storage.
+std::mutex backtraceMutex;
+void* backtraceFrames[maxBacktraceFrames];
+std::atomic<int> backtraceSize{-1};
+// stack of the monitored thread, the frame pointer walk stops at its bounds.
+uintptr_t backtraceStackLow{0};
+uintptr_t backtraceStackHigh{0};
+
+// async signal safe: walks the frame pointer chain instead of calling backtrace(), which may allocate.
+void backtraceSignalHandler(int /*signal*/, siginfo_t* /*info*/, void* context) {
+  int size = 0;
+  const uintptr_t* frame = nullptr;
+#if defined(__x86_64__)
+  // start at the interrupted function, the handler frame is followed by the signal trampoline.
+  const auto* userContext = static_cast<const ucontext_t*>(context);
+  backtraceFrames[size++] = reinterpret_cast<void*>(userContext->uc_mcontext.gregs[REG_RIP]);
+  frame = reinterpret_cast<const uintptr_t*>(userContext->uc_mcontext.gregs[REG_RBP]);
+#else
+  (void)context;
+  frame = static_cast<const uintptr_t*>(__builtin_frame_address(0));
+#endif
+  while (size < maxBacktraceFrames) {
+    const auto address = reinterpret_cast<uintptr_t>(frame);
+    if (address < backtraceStackLow || address + 2 * sizeof(uintptr_t) > backtraceStackHigh || address % sizeof(uintptr_t) != 0) {
+      break;
+    }
+    // frame[0]: frame pointer of the caller, frame[1]: return address.
+    if (frame[1] == 0) {
+      break;
+    }
+    backtraceFrames[size++] = reinterpret_cast<void*>(frame[1]);
+    const auto* caller = reinterpret_cast<const uintptr_t*>(frame[0]);
+    if (caller <= frame) {
+      break;
+    }
+    frame = caller;
+  }
+  backtraceSize.store(size, std::memory_order_release);
+}
+
+// disarms the watchdogs which monitor a thread when the thread exits.
+struct MonitoredThreadExit {
+  std::vector<std::shared_ptr<std::atomic<bool>>> armed;
+
+  ~MonitoredThreadExit() {
+    for (const auto& flag : armed) {
+      flag->store(false, std::memory_order_release);
+    }
+  }
+};
+
+thread_local MonitoredThreadExit monitoredThreadExit;
+
+}  // namespace
+
+std::string StallReport::toString() const {
+  std::stringstream ss;
+  ss << "No heartbeat for " << std::chrono::duration_cast<std::chrono::microseconds>(stallDuration).count() << "us after " << heartbeats
+     << " heartbeats";
+  if (!state.empty()) {
+    ss << "\n" << state;
+  }
+  if (backtrace.empty()) {
+    ss << "\nBacktrace of the stalled thread not available";
+  } else {
+    ss << "\nBacktrace of the stalled thread:";
+    for (size_t i = 0; i < backtrace.size(); i++) {
+      ss << "\n  #" << i << " " << backtrace[i];
+    }
+  }
+  return ss.str();
+}
+
+StallWatchdog::~StallWatchdog() { stop(); }
+
+void StallWatchdog::start(std::chrono::nanoseconds timeout, StateCallback stateCallback, StallCallback stallCallback) {
+  stop();
+  std::lock_guard<std::mutex> lock(monitorMutex_);
+  timeout_ = timeout;
+  stateCallback_ = std::move(stateCallback);
+  stallCallback_ = std::move(stallCallback);
+  armed_->store(false);
+  heartbeats_ = 0;
+  stalls_ = 0;
+
+  struct sigaction action {};
+  action.sa_sigaction = backtraceSignalHandler;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART | SA_SIGINFO;
+  sigaction(backtraceSignal, &action, nullptr);
+
+  running_ = true;
+  monitorThread_ = std::thread(&StallWatchdog::monitor, this);
+}
+
+void StallWatchdog::stop() {
+  std::lock_guard<std::mutex> lock(monitorMutex_);
+  running_ = false;
+  if (monitorThread_.joinable()) {
+    monitorThread_.join();
+  }
+}
+
+void StallWatchdog::arm() {
+  monitoredThread_ = pthread_self();
+  auto& armed = monitoredThreadExit.armed;
+  if (std::find(armed.begin(), armed.end(), armed_) == armed.end()) {
+    armed.push_back(armed_);
+  }
+  armed_->store(true, std::memory_order_release);
+}
+
+void StallWatchdog::monitor() {
+  // the monitor must never compete with the real time threads.
+  sched_param param{};
+  param.sched_priority = 0;
+  pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+  const auto checkInterval = std::max(timeout_ / 4, std::chrono::nanoseconds{std::chrono::microseconds{100}});
+  uint64_t lastHeartbeats = 0;
+  auto lastChange = std::chrono::steady_clock::now();
+  bool stalled = false;
+  while (running_) {
+    std::this_thread::sleep_for(checkInterval);
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t heartbeats = heartbeats_.load(std::memory_order_relaxed);
+    if (!armed_->load(std::memory_order_acquire) || heartbeats != lastHeartbeats) {
+      lastHeartbeats = heartbeats;
+      lastChange = now;
+      stalled = false;
+      continue;
+    }
+    if (stalled || now - lastChange < timeout_) {
+      continue;
+    }
+
+    stalled = true;
+    stalls_++;
+    StallReport report;
+    report.heartbeats = heartbeats;
+    report.stallDuration = now - lastChange;
+    report.backtrace = captureBacktrace();
+    if (stateCallback_) {
+      report.state = stateCallback_();
+    }
+    if (stallCallback_) {
+      stallCallback_(report);
+    }
+  }
+}
+
+std::vector<std::string> StallWatchdog::captureBacktrace() {
+  std::lock_guard<std::mutex> lock(backtraceMutex);
+  // the monitored thread handle is only valid while the thread runs.
+  if (!armed_->load(std::memory_order_acquire)) {
+    return {};
+  }
+  pthread_attr_t attributes;
+  if (pthread_getattr_np(monitoredThread_, &attributes) != 0) {
+    return {};
+  }
+  void* stack = nullptr;
+  size_t stackSize = 0;
+  const bool stackKnown = pthread_attr_getstack(&attributes, &stack, &stackSize) == 0;
+  pthread_attr_destroy(&attributes);
+  if (!stackKnown) {
+    return {};
+  }
+  backtraceStackLow = reinterpret_cast<uintptr_t>(stack);
+  backtraceStackHigh = backtraceStackLow + stackSize;
+  backtraceSize.store(-1, std::memory_order_release);
+  if (pthread_kill(monitoredThread_, backtraceSignal) != 0) {
+    return {};
+  }
+  const auto deadline = std::chrono::steady_clock::now() + backtraceTimeout;
+  int size = -1;
+  while ((size = backtraceSize.load(std::memory_order_acquire)) < 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  }
+  std::vector<std::string> frames;
+  if (size <= 0) {
+    return frames;
+  }
+  char** symbols = backtrace_symbols(backtraceFrames, size);
+  if (symbols == nullptr) {
+    return frames;
+  }
+  for (int i = 0; i < size; i++) {
+    frames.emplace_back(symbols[i]);
+  }
+  free(symbols);
+  return frames;
+}
+
+}  // namespace ecat_master
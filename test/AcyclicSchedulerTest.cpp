@@ -0,0 +1,170 @@
+#include "ethercat_sdk_master/AcyclicScheduler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <time.h>
+
+#include <chrono>
+#include <thread>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr long millisecond{1000000};
+
+long monotonicNs() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+void busyWait(long durationNs) {
+  const long endNs = monotonicNs() + durationNs;
+  while (monotonicNs() < endNs) {
+  }
+}
+
+size_t index(AcyclicPriority priority) {
+  return static_cast<size_t>(priority);
+}
+
+}  // namespace
+
+TEST(AcyclicSchedulerTest, UnlimitedBudgetRunsEverything) {
+  AcyclicScheduler scheduler;
+  int first = 0;
+  int second = 0;
+  scheduler.addTask("first", AcyclicPriority::Parameter, 1, [&]() { first++; });
+  scheduler.addTask("second", AcyclicPriority::Diagnostics, 2, [&]() { second++; });
+  for (int cycle = 0; cycle < 4; cycle++) {
+    scheduler.run(monotonicNs(), -1);
+  }
+  EXPECT_EQ(first, 4);
+  EXPECT_EQ(second, 2);
+  EXPECT_EQ(scheduler.getStatistics()[index(AcyclicPriority::Parameter)].deferrals, 0u);
+}
+
+TEST(AcyclicSchedulerTest, ChangesPeriod) {
+  AcyclicScheduler scheduler;
+  int runs = 0;
+  scheduler.addTask("task", AcyclicPriority::Diagnostics, 10, [&]() { runs++; });
+  for (int cycle = 0; cycle < 5; cycle++) {
+    scheduler.run(monotonicNs(), -1);
+  }
+  EXPECT_EQ(runs, 0);
+  // the countdown of 5 cycles exceeds the new period, the task runs in the next cycle.
+  EXPECT_TRUE(scheduler.setPeriod("task", 2));
+  EXPECT_FALSE(scheduler.setPeriod("missing", 2));
+  for (int cycle = 0; cycle < 5; cycle++) {
+    scheduler.run(monotonicNs(), -1);
+  }
+  EXPECT_EQ(runs, 3);
+}
+
+TEST(AcyclicSchedulerTest, ZeroBudgetRunsOnlySafety) {
+  AcyclicScheduler scheduler;
+  int safety = 0;
+  int parameter = 0;
+  scheduler.addTask("safety", AcyclicPriority::Safety, 1, [&]() { safety++; });
+  scheduler.addTask("parameter", AcyclicPriority::Parameter, 1, [&]() { parameter++; });
+  for (int cycle = 0; cycle < 3; cycle++) {
+    scheduler.run(monotonicNs(), 0);
+  }
+  EXPECT_EQ(safety, 3);
+  EXPECT_EQ(parameter, 0);
+  EXPECT_EQ(scheduler.getStatistics()[index(AcyclicPriority::Parameter)].deferrals, 3u);
+}
+
+TEST(AcyclicSchedulerTest, EnforcesBudget) {
+  AcyclicScheduler scheduler;
+  int executions = 0;
+  int first = 0;
+  int second = 0;
+  // two tasks of 2ms within a budget of 3ms: once their execution time is known, one of them runs per cycle.
+  scheduler.addTask("first", AcyclicPriority::Parameter, 1, [&]() {
+    busyWait(2 * millisecond);
+    executions++;
+    first++;
+  });
+  scheduler.addTask("second", AcyclicPriority::Parameter, 1, [&]() {
+    busyWait(2 * millisecond);
+    executions++;
+    second++;
+  });
+  scheduler.run(monotonicNs(), 3 * millisecond);
+
+  for (int cycle = 0; cycle < 10; cycle++) {
+    executions = 0;
+    scheduler.run(monotonicNs(), 3 * millisecond);
+    EXPECT_EQ(executions, 1);
+  }
+  // the deferred task is the longest waiting one in the next cycle.
+  EXPECT_GE(first, 5);
+  EXPECT_GE(second, 5);
+  EXPECT_GE(scheduler.getStatistics()[index(AcyclicPriority::Parameter)].deferrals, 10u);
+}
+
+TEST(AcyclicSchedulerTest, ChargesServiceExecution) {
+  AcyclicScheduler scheduler;
+  AcyclicService service;
+  int task = 0;
+  scheduler.addService("service", AcyclicPriority::Diagnostics, 1, service);
+  scheduler.addTask("task", AcyclicPriority::Parameter, 1, [&]() { task++; });
+
+  scheduler.run(monotonicNs(), 3 * millisecond);
+  EXPECT_EQ(task, 1);
+  ASSERT_TRUE(service.waitForGrant(millisecond));
+  // the service used more than the budget: the next cycle has none left.
+  service.finish(5 * millisecond);
+  scheduler.run(monotonicNs(), 3 * millisecond);
+  EXPECT_EQ(task, 1);
+  const auto statistics = scheduler.getStatistics()[index(AcyclicPriority::Diagnostics)];
+  EXPECT_EQ(statistics.executed, 1u);
+  EXPECT_EQ(statistics.maxExecutionNs, 5 * millisecond);
+  EXPECT_EQ(statistics.budgetOverruns, 1u);
+
+  scheduler.run(monotonicNs(), 3 * millisecond);
+  EXPECT_EQ(task, 2);
+  ASSERT_TRUE(service.waitForGrant(millisecond));
+  service.finish(0);
+}
+
+TEST(AcyclicSchedulerTest, SkipsBusyService) {
+  AcyclicScheduler scheduler;
+  AcyclicService service;
+  scheduler.addService("service", AcyclicPriority::Diagnostics, 1, service);
+
+  scheduler.run(monotonicNs(), -1);
+  ASSERT_TRUE(service.waitForGrant(millisecond));
+  // the run has not finished: no further grant.
+  scheduler.run(monotonicNs(), -1);
+  scheduler.run(monotonicNs(), -1);
+  EXPECT_EQ(scheduler.getStatistics()[index(AcyclicPriority::Diagnostics)].executed, 1u);
+  EXPECT_EQ(scheduler.getStatistics()[index(AcyclicPriority::Diagnostics)].deferrals, 2u);
+  EXPECT_FALSE(service.waitForGrant(millisecond));
+
+  service.finish(0);
+  scheduler.run(monotonicNs(), -1);
+  EXPECT_TRUE(service.waitForGrant(millisecond));
+  service.finish(0);
+}
+
+TEST(AcyclicSchedulerTest, ServiceRunsWithoutScheduler) {
+  AcyclicScheduler scheduler;
+  AcyclicService service;
+  scheduler.addService("service", AcyclicPriority::Diagnostics, 1, service);
+  // no update loop yet.
+  EXPECT_TRUE(service.waitForGrant(millisecond));
+  service.finish(0);
+
+  // a scheduler which keeps deferring the service is not bypassed.
+  scheduler.run(monotonicNs(), 0);
+  EXPECT_FALSE(service.waitForGrant(10 * millisecond));
+  // the update loop stopped.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_TRUE(service.waitForGrant(millisecond));
+  service.finish(0);
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,93 @@
+#include "ethercat_sdk_master/BusCapacity.hpp"
+
+#include <gtest/gtest.h>
+
+namespace ecat_master {
+
+namespace {
+
+ProcessImageInfo smallImage() {
+  ProcessImageInfo image;
+  image.slaves = 4;
+  image.outputBytes = 40;
+  image.inputBytes = 60;
+  image.frames = 1;
+  return image;
+}
+
+}  // namespace
+
+TEST(BusCapacityTest, MinimalFrame) {
+  const auto estimate = estimateBusCapacity(ProcessImageInfo{}, CycleStatistics{}, 1e6);
+  // a single frame padded to the minimal Ethernet payload: (46 + 38) bytes at 80ns.
+  EXPECT_EQ(estimate.image.frames, 1u);
+  EXPECT_DOUBLE_EQ(estimate.wireTimeNs, 84 * 80.0);
+  EXPECT_DOUBLE_EQ(estimate.loopDelayNs, 0.0);
+  EXPECT_DOUBLE_EQ(estimate.minCycleTimeNs, estimate.estimatedRoundtripNs);
+}
+
+TEST(BusCapacityTest, EstimatedRoundtrip) {
+  const auto estimate = estimateBusCapacity(smallImage(), CycleStatistics{}, 1e6);
+  // EtherCAT header, one datagram and the process data.
+  EXPECT_DOUBLE_EQ(estimate.wireTimeNs, (2 + 12 + 100 + 38) * 80.0);
+  // 1us per slave without a DC propagation delay.
+  EXPECT_DOUBLE_EQ(estimate.loopDelayNs, 4000.0);
+  EXPECT_DOUBLE_EQ(estimate.estimatedRoundtripNs, estimate.wireTimeNs + estimate.loopDelayNs);
+  EXPECT_DOUBLE_EQ(estimate.busUtilisation, estimate.wireTimeNs / 1e6);
+  EXPECT_DOUBLE_EQ(estimate.headroom, 1.0 - estimate.estimatedRoundtripNs / 1e6);
+
+  auto image = smallImage();
+  image.propagationDelayNs = 3000;
+  EXPECT_DOUBLE_EQ(estimateBusCapacity(image, CycleStatistics{}, 1e6).loopDelayNs, 6000.0);
+}
+
+TEST(BusCapacityTest, LargeImageNeedsSeveralFrames) {
+  auto image = smallImage();
+  image.outputBytes = 2000;
+  image.inputBytes = 1000;
+  EXPECT_EQ(estimateBusCapacity(image, CycleStatistics{}, 1e6).image.frames, 3u);
+}
+
+TEST(BusCapacityTest, MeasuredRoundtripLimitsTheCycle) {
+  CycleStatistics statistics;
+  statistics.addRoundtrip(40000);
+  statistics.addRoundtrip(500000);
+  statistics.recentRoundtripP99Ns = 45000;
+
+  const auto estimate = estimateBusCapacity(smallImage(), statistics, 100000);
+  EXPECT_DOUBLE_EQ(estimate.measuredRoundtripNs, 270000.0);
+  EXPECT_DOUBLE_EQ(estimate.maxMeasuredRoundtripNs, 500000.0);
+  // the recent percentile is used, the outlier is ignored.
+  EXPECT_DOUBLE_EQ(estimate.minCycleTimeNs, 45000.0);
+  EXPECT_DOUBLE_EQ(estimate.headroom, 0.55);
+}
+
+TEST(BusCapacityTest, ProjectsAdditionalSlaves) {
+  const double cycleTimeNs = 100000.0;
+  const auto estimate = estimateBusCapacity(smallImage(), CycleStatistics{}, cycleTimeNs, 10, 32, 32);
+  EXPECT_GT(estimate.projectedMinCycleTimeNs, estimate.minCycleTimeNs);
+  EXPECT_LT(estimate.projectedHeadroom, estimate.headroom);
+
+  const unsigned int maxSlaves = estimate.maxAdditionalSlaves;
+  ASSERT_GT(maxSlaves, 10u);
+  EXPECT_LE(estimateBusCapacity(smallImage(), CycleStatistics{}, cycleTimeNs, maxSlaves, 32, 32).projectedMinCycleTimeNs, cycleTimeNs);
+  EXPECT_GT(estimateBusCapacity(smallImage(), CycleStatistics{}, cycleTimeNs, maxSlaves + 1, 32, 32).projectedMinCycleTimeNs, cycleTimeNs);
+}
+
+TEST(BusCapacityTest, RoundtripWindowPercentile) {
+  RoundtripWindow window;
+  EXPECT_EQ(window.percentile(0.99), 0);
+  for (long i = 1; i <= 100; i++) {
+    window.add(i * 1000);
+  }
+  EXPECT_EQ(window.percentile(0.99), 99000);
+  EXPECT_EQ(window.percentile(1.0), 100000);
+
+  // the oldest samples are replaced once the window is full.
+  for (size_t i = 0; i < RoundtripWindow::size; i++) {
+    window.add(5000);
+  }
+  EXPECT_EQ(window.percentile(1.0), 5000);
+}
+
+}  // namespace ecat_master
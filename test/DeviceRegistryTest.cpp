@@ -0,0 +1,120 @@
+#include "ethercat_sdk_master/DeviceRegistry.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ecat_master {
+
+namespace {
+
+class Drive : public EthercatDevice {
+ public:
+  Drive(const std::string& name, uint32_t address) {
+    name_ = name;
+    address_ = address;
+  }
+
+  bool startup() override { return true; }
+  void updateRead() override {}
+  void updateWrite() override {}
+  void shutdown() override {}
+  PdoInfo getCurrentPdoInfo() const override { return PdoInfo{}; }
+};
+
+// registered under its own dynamic type, found as a Drive as well.
+class GripperDrive : public Drive {
+ public:
+  using Drive::Drive;
+};
+
+class Sensor : public Drive {
+ public:
+  using Drive::Drive;
+};
+
+class IoModule : public EthercatDevice {
+ public:
+  IoModule(const std::string& name, uint32_t address) {
+    name_ = name;
+    address_ = address;
+  }
+
+  bool startup() override { return true; }
+  void updateRead() override {}
+  void updateWrite() override {}
+  void shutdown() override {}
+  PdoInfo getCurrentPdoInfo() const override { return PdoInfo{}; }
+};
+
+template <typename Device>
+std::vector<std::string> names(const std::vector<std::shared_ptr<Device>>& devices) {
+  std::vector<std::string> result;
+  for (const auto& device : devices) {
+    result.push_back(device->getName());
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(DeviceRegistryTest, FindsDevicesByName) {
+  DeviceRegistry registry;
+  EXPECT_EQ(registry.add(std::make_shared<Drive>("drive", 1)), 0u);
+  EXPECT_EQ(registry.add(std::make_shared<IoModule>("io", 2)), 1u);
+  // the name is taken.
+  EXPECT_EQ(registry.add(std::make_shared<IoModule>("drive", 3)), DeviceRegistry::npos);
+  EXPECT_EQ(registry.size(), 2u);
+
+  EXPECT_TRUE(registry.contains("io"));
+  EXPECT_FALSE(registry.contains("missing"));
+  EXPECT_EQ(registry.find("io"), 1u);
+  EXPECT_EQ(registry.find("missing"), DeviceRegistry::npos);
+  ASSERT_NE(registry.get<Drive>("drive"), nullptr);
+  EXPECT_EQ(registry.get<Drive>("drive")->getAddress(), 1u);
+  // the type differs.
+  EXPECT_EQ(registry.get<IoModule>("drive"), nullptr);
+  EXPECT_EQ(registry.get<Drive>("missing"), nullptr);
+}
+
+TEST(DeviceRegistryTest, FindsDevicesByAddress) {
+  DeviceRegistry registry;
+  registry.add(std::make_shared<Drive>("first", 3), 0);
+  // a second device of the same slave.
+  registry.add(std::make_shared<IoModule>("second", 3), 0);
+  registry.add(std::make_shared<Drive>("other segment", 3), 1);
+  registry.add(std::make_shared<Drive>("low address", 1), 1);
+
+  EXPECT_EQ(registry.findAt(0, 3), (std::vector<size_t>{0, 1}));
+  EXPECT_EQ(registry.findAt(1, 3), (std::vector<size_t>{2}));
+  EXPECT_EQ(registry.findAt(1, 1), (std::vector<size_t>{3}));
+  EXPECT_EQ(registry.getSegment(2), 1u);
+  EXPECT_TRUE(registry.findAt(0, 1).empty());
+  EXPECT_TRUE(registry.findAt(0, 100).empty());
+  EXPECT_TRUE(registry.findAt(2, 3).empty());
+}
+
+TEST(DeviceRegistryTest, GetsDevicesByType) {
+  DeviceRegistry registry;
+  // the types interleaved, getAll() returns the devices in attachment order.
+  registry.add(std::make_shared<GripperDrive>("gripper", 1));
+  registry.add(std::make_shared<IoModule>("io", 2));
+  registry.add(std::make_shared<Drive>("drive", 3));
+  registry.add(std::make_shared<Sensor>("sensor", 4));
+  registry.add(std::make_shared<GripperDrive>("second gripper", 5));
+
+  EXPECT_EQ(names(registry.getAll<Drive>()), (std::vector<std::string>{"gripper", "drive", "sensor", "second gripper"}));
+  EXPECT_EQ(names(registry.getAll<GripperDrive>()), (std::vector<std::string>{"gripper", "second gripper"}));
+  EXPECT_EQ(names(registry.getAll<IoModule>()), (std::vector<std::string>{"io"}));
+  EXPECT_EQ(registry.getAll<EthercatDevice>().size(), 5u);
+
+  registry.clear();
+  EXPECT_TRUE(registry.empty());
+  EXPECT_TRUE(registry.getAll<Drive>().empty());
+  EXPECT_FALSE(registry.contains("io"));
+  EXPECT_TRUE(registry.findAt(0, 2).empty());
+}
+
+}  // namespace ecat_master
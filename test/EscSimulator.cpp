@@ -0,0 +1,1032 @@
+#include "EscSimulator.hpp"
+
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr uint16_t ethercatEtherType{0x88a4};
+constexpr size_t ethernetHeaderSize{14};
+constexpr size_t ethercatHeaderSize{2};
+constexpr size_t datagramHeaderSize{10};
+constexpr size_t workingCounterSize{2};
+constexpr size_t maxFrameSize{1518};
+constexpr int pollTimeoutMs{10};
+
+// datagram commands.
+enum Command : uint8_t { NOP, APRD, APWR, APRW, FPRD, FPWR, FPRW, BRD, BWR, BRW, LRD, LWR, LRW, ARMW, FRMW };
+
+// ESC registers.
+constexpr size_t escMemorySize{0x10000};
+constexpr uint16_t registerType{0x0000};
+constexpr uint16_t registerFmmuCount{0x0004};
+constexpr uint16_t registerSmCount{0x0005};
+constexpr uint16_t registerRamSize{0x0006};
+constexpr uint16_t registerPortDescriptor{0x0007};
+constexpr uint16_t registerStationAddress{0x0010};
+constexpr uint16_t registerDlStatus{0x0110};
+constexpr uint16_t registerAlControl{0x0120};
+constexpr uint16_t registerAlStatus{0x0130};
+constexpr uint16_t registerAlStatusCode{0x0134};
+constexpr uint16_t registerEepromControl{0x0502};
+constexpr uint16_t registerEepromAddress{0x0504};
+constexpr uint16_t registerEepromData{0x0508};
+constexpr uint16_t registerFmmu{0x0600};
+constexpr uint16_t registerSm{0x0800};
+constexpr uint16_t processRamStart{0x1000};
+constexpr unsigned int fmmuCount{8};
+constexpr unsigned int smCount{8};
+constexpr size_t fmmuSize{16};
+constexpr size_t smSize{8};
+
+// AL states and status codes.
+constexpr uint8_t stateInit{0x01};
+constexpr uint8_t statePreOp{0x02};
+constexpr uint8_t stateBoot{0x03};
+constexpr uint8_t stateSafeOp{0x04};
+constexpr uint8_t stateOp{0x08};
+constexpr uint16_t alStatusError{0x0010};
+constexpr uint16_t alCodeInvalidStateChange{0x0011};
+constexpr uint16_t alCodeUnknownState{0x0012};
+constexpr uint16_t alCodeInvalidMailboxBoot{0x0015};
+constexpr uint16_t alCodeInvalidMailboxPreOp{0x0016};
+
+// SM control: mode and direction bits, SM status: mailbox full.
+constexpr uint8_t smModeMask{0x03};
+constexpr uint8_t smModeMailbox{0x02};
+constexpr uint8_t smDirectionMask{0x0c};
+constexpr uint8_t smDirectionWrite{0x04};
+constexpr uint8_t smStatusFull{0x08};
+
+// EEPROM commands.
+constexpr uint16_t eepromRead{0x01};
+constexpr uint16_t eepromWrite{0x02};
+
+// process data RAM behind the mailboxes.
+constexpr uint16_t mailboxStart{0x1000};
+constexpr uint16_t bootMailboxStart{0x1400};
+constexpr uint16_t outputsStart{0x1800};
+constexpr uint16_t inputsStart{0x1c00};
+
+// mailbox types and errors.
+constexpr size_t mailboxHeaderSize{6};
+constexpr uint8_t mailboxTypeError{0x00};
+constexpr uint16_t mailboxErrorUnsupportedProtocol{0x0002};
+constexpr uint8_t mailboxTypeFoe{0x04};
+
+// FoE: op code, reserved byte, password / packet number / error code.
+constexpr size_t foeHeaderSize{6};
+constexpr uint8_t foeRead{1};
+constexpr uint8_t foeWrite{2};
+constexpr uint8_t foeData{3};
+constexpr uint8_t foeAck{4};
+constexpr uint8_t foeError{5};
+constexpr uint32_t foeErrorNotFound{0x8001};
+constexpr uint32_t foeErrorIllegal{0x8004};
+constexpr uint32_t foeErrorPacketNumber{0x8005};
+
+// CoE: number and service, then the SDO command byte, index, subindex and 4 bytes of data or size.
+constexpr uint8_t mailboxTypeCoe{0x03};
+constexpr size_t coeHeaderSize{2};
+constexpr size_t sdoHeaderSize{8};
+constexpr uint8_t coeServiceSdoRequest{0x02};
+constexpr uint8_t coeServiceSdoResponse{0x03};
+// client command specifiers (bits 5-7 of the command byte).
+constexpr uint8_t sdoDownloadInitiate{1};
+constexpr uint8_t sdoUploadInitiate{2};
+constexpr uint8_t sdoAbort{0x80};
+constexpr uint32_t sdoAbortCommand{0x05040001};
+constexpr uint32_t sdoAbortNotFound{0x06020000};
+constexpr uint32_t sdoAbortGeneral{0x08000000};
+
+uint16_t readU16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t readU32(const uint8_t* data) {
+  return static_cast<uint32_t>(readU16(data)) | (static_cast<uint32_t>(readU16(data + 2)) << 16);
+}
+
+void writeU16(uint8_t* data, uint16_t value) {
+  data[0] = static_cast<uint8_t>(value);
+  data[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void appendU16(std::vector<uint8_t>& data, uint16_t value) {
+  data.push_back(static_cast<uint8_t>(value));
+  data.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void appendU32(std::vector<uint8_t>& data, uint32_t value) {
+  appendU16(data, static_cast<uint16_t>(value));
+  appendU16(data, static_cast<uint16_t>(value >> 16));
+}
+
+bool overlaps(size_t start, size_t size, size_t otherStart, size_t otherSize) {
+  return start < otherStart + otherSize && otherStart < start + size;
+}
+
+// registers the master cannot write: ESC information, DL status, AL status and the SM status bytes.
+bool isReadOnly(size_t address) {
+  if (address < registerStationAddress || (address >= registerDlStatus && address < registerDlStatus + 2) ||
+      (address >= registerAlStatus && address < registerAlStatus + 6)) {
+    return true;
+  }
+  return address >= registerSm && address < registerSm + smCount * smSize && (address - registerSm) % smSize == 5;
+}
+
+// SII checksum: CRC8 with polynomial x^8 + x^2 + x + 1 over the first 14 bytes.
+uint8_t siiChecksum(const std::vector<uint8_t>& eeprom) {
+  uint8_t crc = 0xff;
+  for (size_t i = 0; i < 14; i++) {
+    crc ^= eeprom[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = static_cast<uint8_t>((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+  }
+  return crc;
+}
+
+}  // namespace
+
+EscSimulator::EscSimulator(std::string primaryInterface, std::string secondaryInterface)
+    : primaryInterface_(std::move(primaryInterface)), secondaryInterface_(std::move(secondaryInterface)) {}
+
+EscSimulator::~EscSimulator() {
+  stop();
+}
+
+void EscSimulator::addSlave(const SlaveDescription& description) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Slave slave;
+  slave.description = description;
+  slave.memory.assign(escMemorySize, 0);
+  slave.memory[registerType] = 0x11;
+  slave.memory[registerFmmuCount] = fmmuCount;
+  slave.memory[registerSmCount] = smCount;
+  slave.memory[registerRamSize] = 8;
+  // ports 0 and 1 MII, ports 2 and 3 not implemented.
+  slave.memory[registerPortDescriptor] = 0x0f;
+  writeU16(&slave.memory[registerAlStatus], stateInit);
+  slave.eeprom = buildEeprom(description);
+  slave.objects[{0x1018, 0}] = {4};
+  const uint32_t identity[] = {description.vendorId, description.productCode, description.revision, description.serial};
+  for (uint8_t subindex = 1; subindex <= 4; subindex++) {
+    std::vector<uint8_t> value;
+    appendU32(value, identity[subindex - 1]);
+    slave.objects[{0x1018, subindex}] = value;
+  }
+  slaves_.push_back(std::move(slave));
+}
+
+bool EscSimulator::start() {
+  if (running_) {
+    return true;
+  }
+  primarySocket_ = openInterface(primaryInterface_);
+  if (!secondaryInterface_.empty()) {
+    secondarySocket_ = openInterface(secondaryInterface_);
+  }
+  controlSocket_ = socket(AF_INET, SOCK_DGRAM, 0);
+  if (primarySocket_ < 0 || (!secondaryInterface_.empty() && secondarySocket_ < 0) || controlSocket_ < 0) {
+    stop();
+    return false;
+  }
+  frames_ = 0;
+  running_ = true;
+  thread_ = std::thread(&EscSimulator::run, this);
+  return true;
+}
+
+void EscSimulator::stop() {
+  running_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  for (int* fd : {&primarySocket_, &secondarySocket_, &controlSocket_}) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
+void EscSimulator::setLineBreak(uint16_t slave) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lineBreak_ = slave;
+}
+
+uint16_t EscSimulator::getAlStatus(uint16_t slave) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slave == 0 || slave > slaves_.size()) {
+    return 0;
+  }
+  return readU16(&slaves_[slave - 1].memory[registerAlStatus]);
+}
+
+std::vector<uint8_t> EscSimulator::getFile(uint16_t slave, const std::string& fileName) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slave == 0 || slave > slaves_.size()) {
+    return {};
+  }
+  const auto file = slaves_[slave - 1].files.find(fileName);
+  return file != slaves_[slave - 1].files.end() ? file->second : std::vector<uint8_t>{};
+}
+
+void EscSimulator::setObject(uint16_t slave, uint16_t index, uint8_t subindex, const std::vector<uint8_t>& value) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slave > 0 && slave <= slaves_.size()) {
+    slaves_[slave - 1].objects[{index, subindex}] = value;
+  }
+}
+
+std::vector<uint8_t> EscSimulator::getObject(uint16_t slave, uint16_t index, uint8_t subindex) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (slave == 0 || slave > slaves_.size()) {
+    return {};
+  }
+  const auto object = slaves_[slave - 1].objects.find({index, subindex});
+  return object != slaves_[slave - 1].objects.end() ? object->second : std::vector<uint8_t>{};
+}
+
+uint64_t EscSimulator::getSdoUploads(uint16_t slave) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return slave > 0 && slave <= slaves_.size() ? slaves_[slave - 1].sdoUploads : 0;
+}
+
+void EscSimulator::setStateCallback(const StateCallback& callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stateCallback_ = callback;
+}
+
+int EscSimulator::openInterface(const std::string& networkInterface) {
+  const int fd = socket(AF_PACKET, SOCK_RAW, htons(ethercatEtherType));
+  if (fd < 0) {
+    return -1;
+  }
+  sockaddr_ll address{};
+  address.sll_family = AF_PACKET;
+  address.sll_protocol = htons(ethercatEtherType);
+  address.sll_ifindex = static_cast<int>(if_nametoindex(networkInterface.c_str()));
+  if (address.sll_ifindex == 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+void EscSimulator::run() {
+  std::vector<uint8_t> buffer(maxFrameSize + 64);
+  std::vector<uint8_t> frame;
+  while (running_) {
+    pollfd fds[2];
+    int* sockets[2] = {&primarySocket_, &secondarySocket_};
+    nfds_t count = 0;
+    for (int* fd : sockets) {
+      if (*fd >= 0) {
+        fds[count++] = pollfd{*fd, POLLIN, 0};
+      }
+    }
+    if (poll(fds, count, pollTimeoutMs) <= 0) {
+      continue;
+    }
+    for (nfds_t i = 0; i < count; i++) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      sockaddr_ll from{};
+      socklen_t fromLength = sizeof(from);
+      const ssize_t size = recvfrom(fds[i].fd, buffer.data(), buffer.size(), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&from), &fromLength);
+      if (size < 0) {
+        if (errno != EAGAIN && errno != EINTR) {
+          // the interface was removed.
+          int* fd = fds[i].fd == primarySocket_ ? &primarySocket_ : &secondarySocket_;
+          close(*fd);
+          *fd = -1;
+        }
+        continue;
+      }
+      if (from.sll_pkttype == PACKET_OUTGOING) {
+        continue;
+      }
+      frame.assign(buffer.begin(), buffer.begin() + size);
+      handleFrame(frame, fds[i].fd == secondarySocket_);
+    }
+  }
+}
+
+bool EscSimulator::secondaryLinkUp() const {
+  if (secondarySocket_ < 0) {
+    return false;
+  }
+  ifreq request{};
+  std::strncpy(request.ifr_name, secondaryInterface_.c_str(), IFNAMSIZ - 1);
+  return ioctl(controlSocket_, SIOCGIFFLAGS, &request) >= 0 && (request.ifr_flags & IFF_UP) && (request.ifr_flags & IFF_RUNNING);
+}
+
+void EscSimulator::handleFrame(std::vector<uint8_t>& frame, bool fromSecondary) {
+  if (frame.size() < ethernetHeaderSize + ethercatHeaderSize || ((frame[12] << 8) | frame[13]) != ethercatEtherType ||
+      (readU16(&frame[ethernetHeaderSize]) >> 12) != 1) {
+    return;
+  }
+
+  // datagram headers, the data is processed in place.
+  std::vector<Datagram> datagrams;
+  std::vector<size_t> offsets;
+  size_t offset = ethernetHeaderSize + ethercatHeaderSize;
+  while (offset + datagramHeaderSize + workingCounterSize <= frame.size()) {
+    Datagram datagram;
+    datagram.command = frame[offset];
+    datagram.adp = readU16(&frame[offset + 2]);
+    datagram.ado = readU16(&frame[offset + 4]);
+    const uint16_t lengthField = readU16(&frame[offset + 6]);
+    datagram.length = lengthField & 0x07ff;
+    if (offset + datagramHeaderSize + datagram.length + workingCounterSize > frame.size()) {
+      return;
+    }
+    datagram.data = &frame[offset + datagramHeaderSize];
+    datagram.workingCounter = readU16(&frame[offset + datagramHeaderSize + datagram.length]);
+    datagrams.push_back(datagram);
+    offsets.push_back(offset);
+    offset += datagramHeaderSize + datagram.length + workingCounterSize;
+    if (!(lengthField & 0x8000)) {
+      break;
+    }
+  }
+
+  const bool secondaryUp = secondaryLinkUp();
+  int outputSocket = -1;
+  std::vector<std::pair<uint16_t, uint8_t>> stateChanges;
+  StateCallback stateCallback;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t slaveCount = slaves_.size();
+    const bool lineBroken = lineBreak_ >= 1 && lineBreak_ <= slaveCount + 1;
+    const bool secondaryConnected = secondaryUp && !(lineBroken && lineBreak_ == slaveCount + 1);
+    updateDlStatus(secondaryUp);
+
+    // slaves [first, last) process the frame.
+    size_t first = 0;
+    size_t last = 0;
+    if (!fromSecondary) {
+      if (lineBroken && lineBreak_ == 1) {
+        return;
+      }
+      last = lineBroken && lineBreak_ <= slaveCount ? lineBreak_ - 1 : slaveCount;
+      outputSocket = last == slaveCount && secondaryConnected ? secondarySocket_ : primarySocket_;
+    } else {
+      if (!secondaryConnected) {
+        return;
+      }
+      if (lineBroken) {
+        first = lineBreak_ - 1;
+        last = slaveCount;
+        outputSocket = secondarySocket_;
+      } else {
+        outputSocket = primarySocket_;
+      }
+    }
+    for (size_t slave = first; slave < last; slave++) {
+      for (auto& datagram : datagrams) {
+        processDatagram(slaves_[slave], datagram);
+      }
+    }
+    for (auto& slave : slaves_) {
+      runApplication(slave);
+    }
+    stateChanges.swap(stateChanges_);
+    stateCallback = stateCallback_;
+  }
+
+  for (size_t i = 0; i < datagrams.size(); i++) {
+    writeU16(&frame[offsets[i] + 2], datagrams[i].adp);
+    writeU16(&frame[offsets[i] + datagramHeaderSize + datagrams[i].length], datagrams[i].workingCounter);
+  }
+  if (stateCallback) {
+    for (const auto& change : stateChanges) {
+      stateCallback(change.first, change.second);
+    }
+  }
+  if (outputSocket >= 0 && send(outputSocket, frame.data(), frame.size(), 0) > 0) {
+    frames_++;
+  }
+}
+
+void EscSimulator::updateDlStatus(bool secondaryUp) {
+  const size_t slaveCount = slaves_.size();
+  for (size_t i = 0; i < slaveCount; i++) {
+    const size_t slavePosition = i + 1;
+    const bool port0 = lineBreak_ != slavePosition;
+    const bool port1 = slavePosition < slaveCount ? lineBreak_ != slavePosition + 1
+                                                  : !secondaryInterface_.empty() && secondaryUp && lineBreak_ != slaveCount + 1;
+    // PDI operational, watchdog not expired.
+    uint16_t status = 0x0003;
+    auto setPort = [&status](unsigned int port, bool link) {
+      // physical link and communication, or the loop closed.
+      status |= link ? static_cast<uint16_t>((1 << (4 + port)) | (1 << (9 + 2 * port))) : static_cast<uint16_t>(1 << (8 + 2 * port));
+    };
+    setPort(0, port0);
+    setPort(1, port1);
+    setPort(2, false);
+    setPort(3, false);
+    writeU16(&slaves_[i].memory[registerDlStatus], status);
+  }
+}
+
+void EscSimulator::processDatagram(Slave& slave, Datagram& datagram) {
+  const uint16_t stationAddress = readU16(&slave.memory[registerStationAddress]);
+  bool read = false;
+  bool write = false;
+  bool combine = false;
+  switch (datagram.command) {
+    case APRD:
+    case APWR:
+    case APRW:
+      read = datagram.adp == 0 && datagram.command != APWR;
+      write = datagram.adp == 0 && datagram.command != APRD;
+      datagram.adp++;
+      break;
+    case FPRD:
+    case FPWR:
+    case FPRW:
+      read = datagram.adp == stationAddress && datagram.command != FPWR;
+      write = datagram.adp == stationAddress && datagram.command != FPRD;
+      break;
+    case BRD:
+    case BWR:
+    case BRW:
+      read = datagram.command != BWR;
+      write = datagram.command != BRD;
+      combine = true;
+      datagram.adp++;
+      break;
+    case ARMW:
+      // the addressed slave reads, all others write.
+      read = datagram.adp == 0;
+      write = !read;
+      datagram.adp++;
+      break;
+    case FRMW:
+      read = datagram.adp == stationAddress;
+      write = !read;
+      break;
+    case LRD:
+    case LWR:
+    case LRW:
+      processLogical(slave, datagram, std::vector<uint8_t>(datagram.data, datagram.data + datagram.length));
+      return;
+    default:
+      return;
+  }
+
+  const std::vector<uint8_t> writeData(datagram.data, datagram.data + datagram.length);
+  if (read && readPhysical(slave, datagram.ado, datagram.data, datagram.length, combine)) {
+    datagram.workingCounter++;
+  }
+  if (write && writePhysical(slave, datagram.ado, writeData.data(), writeData.size())) {
+    // a read-write counts 1 for the read and 2 for the write.
+    datagram.workingCounter += read ? 2 : 1;
+  }
+}
+
+void EscSimulator::processLogical(Slave& slave, Datagram& datagram, const std::vector<uint8_t>& writeData) {
+  const uint64_t logicalStart = static_cast<uint64_t>(datagram.adp) | (static_cast<uint64_t>(datagram.ado) << 16);
+  const uint64_t logicalEnd = logicalStart + datagram.length;
+  bool read = false;
+  bool write = false;
+  for (unsigned int fmmu = 0; fmmu < fmmuCount; fmmu++) {
+    const uint8_t* configuration = &slave.memory[registerFmmu + fmmu * fmmuSize];
+    if (!(configuration[12] & 0x01)) {
+      continue;
+    }
+    const uint64_t mappedStart = readU32(configuration);
+    const uint64_t mappedEnd = mappedStart + readU16(configuration + 4);
+    const uint16_t physicalStart = readU16(configuration + 8);
+    const uint8_t type = configuration[11];
+    const uint64_t start = std::max(logicalStart, mappedStart);
+    const uint64_t end = std::min(logicalEnd, mappedEnd);
+    if (start >= end) {
+      continue;
+    }
+    // byte granularity, the simulated slaves map whole bytes.
+    const size_t frameOffset = static_cast<size_t>(start - logicalStart);
+    const auto physical = static_cast<uint16_t>(physicalStart + (start - mappedStart));
+    const auto size = static_cast<size_t>(end - start);
+    if ((type & 0x02) && datagram.command != LRD) {
+      write |= writePhysical(slave, physical, writeData.data() + frameOffset, size);
+    }
+    if ((type & 0x01) && datagram.command != LWR) {
+      read |= readPhysical(slave, physical, datagram.data + frameOffset, size, false);
+    }
+  }
+  datagram.workingCounter += (read ? 1 : 0) + (write ? (datagram.command == LRW ? 2 : 1) : 0);
+}
+
+EscSimulator::SyncManager EscSimulator::getSyncManager(const Slave& slave, unsigned int index) const {
+  const uint8_t* configuration = &slave.memory[registerSm + index * smSize];
+  SyncManager syncManager;
+  syncManager.start = readU16(configuration);
+  syncManager.length = readU16(configuration + 2);
+  syncManager.control = configuration[4];
+  syncManager.enabled = (configuration[6] & 0x01) != 0 && syncManager.length > 0;
+  return syncManager;
+}
+
+void EscSimulator::setMailboxFull(Slave& slave, unsigned int index, bool full) {
+  uint8_t& status = slave.memory[registerSm + index * smSize + 5];
+  status = full ? static_cast<uint8_t>(status | smStatusFull) : static_cast<uint8_t>(status & ~smStatusFull);
+}
+
+bool EscSimulator::readPhysical(Slave& slave, uint16_t address, uint8_t* data, size_t size, bool combine) {
+  size = std::min(size, escMemorySize - address);
+  // the input mailbox can only be read while it is full, reading its last byte empties it.
+  std::vector<unsigned int> emptied;
+  for (unsigned int index = 0; index < smCount; index++) {
+    const SyncManager syncManager = getSyncManager(slave, index);
+    if (!syncManager.enabled || (syncManager.control & smModeMask) != smModeMailbox ||
+        !overlaps(address, size, syncManager.start, syncManager.length)) {
+      continue;
+    }
+    if ((syncManager.control & smDirectionMask) == smDirectionWrite || !(slave.memory[registerSm + index * smSize + 5] & smStatusFull)) {
+      return false;
+    }
+    if (address + size >= static_cast<size_t>(syncManager.start) + syncManager.length) {
+      emptied.push_back(index);
+    }
+  }
+  for (size_t i = 0; i < size; i++) {
+    data[i] = combine ? static_cast<uint8_t>(data[i] | slave.memory[address + i]) : slave.memory[address + i];
+  }
+  for (const auto index : emptied) {
+    setMailboxFull(slave, index, false);
+  }
+  return true;
+}
+
+bool EscSimulator::writePhysical(Slave& slave, uint16_t address, const uint8_t* data, size_t size) {
+  size = std::min(size, escMemorySize - address);
+  // the output mailbox can only be written while it is empty, writing its last byte fills it.
+  std::vector<unsigned int> filled;
+  for (unsigned int index = 0; index < smCount; index++) {
+    const SyncManager syncManager = getSyncManager(slave, index);
+    if (!syncManager.enabled || (syncManager.control & smModeMask) != smModeMailbox ||
+        !overlaps(address, size, syncManager.start, syncManager.length)) {
+      continue;
+    }
+    if ((syncManager.control & smDirectionMask) != smDirectionWrite || (slave.memory[registerSm + index * smSize + 5] & smStatusFull)) {
+      return false;
+    }
+    if (address + size >= static_cast<size_t>(syncManager.start) + syncManager.length) {
+      filled.push_back(index);
+    }
+  }
+  for (size_t i = 0; i < size; i++) {
+    if (address + i >= processRamStart || !isReadOnly(address + i)) {
+      slave.memory[address + i] = data[i];
+    }
+  }
+  for (const auto index : filled) {
+    setMailboxFull(slave, index, true);
+    slave.mailboxRequest = true;
+  }
+  if (address < processRamStart) {
+    afterRegisterWrite(slave, address, size);
+  }
+  return true;
+}
+
+void EscSimulator::afterRegisterWrite(Slave& slave, uint16_t address, size_t size) {
+  for (unsigned int index = 0; index < smCount; index++) {
+    // a reconfigured sync manager starts empty.
+    if (overlaps(address, size, registerSm + index * smSize, 5) || overlaps(address, size, registerSm + index * smSize + 6, 1)) {
+      setMailboxFull(slave, index, false);
+    }
+  }
+  if (overlaps(address, size, registerEepromControl, 2)) {
+    executeEepromCommand(slave);
+  }
+  if (overlaps(address, size, registerAlControl, 2)) {
+    requestState(slave, readU16(&slave.memory[registerAlControl]));
+  }
+}
+
+void EscSimulator::executeEepromCommand(Slave& slave) {
+  const uint16_t command = (readU16(&slave.memory[registerEepromControl]) >> 8) & 0x07;
+  const size_t byteAddress = static_cast<size_t>(readU32(&slave.memory[registerEepromAddress])) * 2;
+  if (command == eepromRead) {
+    // 4 bytes per read, an erased EEPROM reads 0xff.
+    for (size_t i = 0; i < 4; i++) {
+      slave.memory[registerEepromData + i] = byteAddress + i < slave.eeprom.size() ? slave.eeprom[byteAddress + i] : 0xff;
+    }
+  } else if (command == eepromWrite) {
+    if (slave.eeprom.size() < byteAddress + 2) {
+      slave.eeprom.resize(byteAddress + 2, 0xff);
+    }
+    slave.eeprom[byteAddress] = slave.memory[registerEepromData];
+    slave.eeprom[byteAddress + 1] = slave.memory[registerEepromData + 1];
+  }
+  // executed immediately: never busy, no error.
+  writeU16(&slave.memory[registerEepromControl], 0);
+}
+
+bool EscSimulator::mailboxConfigured(const Slave& slave, uint16_t start, uint16_t size) const {
+  const SyncManager out = getSyncManager(slave, 0);
+  const SyncManager in = getSyncManager(slave, 1);
+  return out.enabled && in.enabled && out.start == start && out.length == size && in.start == start + size && in.length == size &&
+         (out.control & (smModeMask | smDirectionMask)) == (smModeMailbox | smDirectionWrite) &&
+         (in.control & (smModeMask | smDirectionMask)) == smModeMailbox;
+}
+
+uint16_t EscSimulator::checkTransition(const Slave& slave, uint8_t current, uint8_t requested) const {
+  switch (requested) {
+    case stateInit:
+      return 0;
+    case statePreOp:
+      if (current == stateBoot) {
+        return alCodeInvalidStateChange;
+      }
+      if (current == stateInit && slave.description.mailboxSize > 0 && !mailboxConfigured(slave, mailboxStart, slave.description.mailboxSize)) {
+        return alCodeInvalidMailboxPreOp;
+      }
+      return 0;
+    case stateSafeOp:
+      return current == statePreOp || current == stateSafeOp || current == stateOp ? 0 : alCodeInvalidStateChange;
+    case stateOp:
+      return current == stateSafeOp || current == stateOp ? 0 : alCodeInvalidStateChange;
+    case stateBoot:
+      if (slave.description.bootMailboxSize == 0 || (current != stateInit && current != stateBoot)) {
+        return alCodeInvalidStateChange;
+      }
+      // the master has to program the boot mailbox of the SII.
+      return mailboxConfigured(slave, bootMailboxStart, slave.description.bootMailboxSize) ? 0 : alCodeInvalidMailboxBoot;
+    default:
+      return alCodeUnknownState;
+  }
+}
+
+void EscSimulator::requestState(Slave& slave, uint16_t control) {
+  const uint16_t status = readU16(&slave.memory[registerAlStatus]);
+  const auto current = static_cast<uint8_t>(status & 0x0f);
+  const auto requested = static_cast<uint8_t>(control & 0x0f);
+  const bool acknowledge = (control & alStatusError) != 0;
+  // an error is kept until it is acknowledged.
+  if ((status & alStatusError) && !acknowledge) {
+    return;
+  }
+  const uint16_t code = checkTransition(slave, current, requested);
+  if (code != 0) {
+    writeU16(&slave.memory[registerAlStatus], static_cast<uint16_t>(current | alStatusError));
+    writeU16(&slave.memory[registerAlStatusCode], code);
+    return;
+  }
+  writeU16(&slave.memory[registerAlStatus], requested);
+  writeU16(&slave.memory[registerAlStatusCode], 0);
+  if (requested == stateInit) {
+    slave.outbox.clear();
+    slave.mailboxRequest = false;
+    slave.foe = FoeTransfer{};
+  }
+  if (requested != current) {
+    stateChanges_.emplace_back(position(slave), requested);
+  }
+}
+
+void EscSimulator::runApplication(Slave& slave) {
+  int outMailbox = -1;
+  int inMailbox = -1;
+  int outputs = -1;
+  int inputs = -1;
+  for (unsigned int index = 0; index < smCount; index++) {
+    const SyncManager syncManager = getSyncManager(slave, index);
+    if (!syncManager.enabled) {
+      continue;
+    }
+    const bool ecatWrites = (syncManager.control & smDirectionMask) == smDirectionWrite;
+    if ((syncManager.control & smModeMask) == smModeMailbox) {
+      (ecatWrites ? outMailbox : inMailbox) = static_cast<int>(index);
+    } else {
+      (ecatWrites ? outputs : inputs) = static_cast<int>(index);
+    }
+  }
+
+  if (slave.mailboxRequest && outMailbox >= 0) {
+    const SyncManager syncManager = getSyncManager(slave, static_cast<unsigned int>(outMailbox));
+    const std::vector<uint8_t> request(slave.memory.begin() + syncManager.start, slave.memory.begin() + syncManager.start + syncManager.length);
+    setMailboxFull(slave, static_cast<unsigned int>(outMailbox), false);
+    slave.mailboxRequest = false;
+    handleMailbox(slave, request);
+  }
+  if (inMailbox >= 0 && !slave.outbox.empty() && !(slave.memory[registerSm + inMailbox * smSize + 5] & smStatusFull)) {
+    const SyncManager syncManager = getSyncManager(slave, static_cast<unsigned int>(inMailbox));
+    std::vector<uint8_t>& response = slave.outbox.front();
+    response.resize(syncManager.length, 0);
+    std::copy(response.begin(), response.end(), slave.memory.begin() + syncManager.start);
+    slave.outbox.pop_front();
+    setMailboxFull(slave, static_cast<unsigned int>(inMailbox), true);
+  }
+
+  const uint8_t state = slave.memory[registerAlStatus] & 0x0f;
+  if ((state == stateSafeOp || state == stateOp) && outputs >= 0 && inputs >= 0) {
+    const SyncManager out = getSyncManager(slave, static_cast<unsigned int>(outputs));
+    const SyncManager in = getSyncManager(slave, static_cast<unsigned int>(inputs));
+    std::copy_n(slave.memory.begin() + out.start, std::min(out.length, in.length), slave.memory.begin() + in.start);
+  }
+}
+
+void EscSimulator::handleMailbox(Slave& slave, const std::vector<uint8_t>& request) {
+  if (request.size() < mailboxHeaderSize) {
+    return;
+  }
+  const size_t length = std::min<size_t>(readU16(request.data()), request.size() - mailboxHeaderSize);
+  if ((request[5] & 0x0f) == mailboxTypeFoe && slave.description.bootMailboxSize > 0 && length >= foeHeaderSize) {
+    handleFoe(slave, request.data() + mailboxHeaderSize, length);
+    return;
+  }
+  if ((request[5] & 0x0f) == mailboxTypeCoe && slave.description.mailboxSize > 0 && length >= coeHeaderSize + sdoHeaderSize) {
+    handleSdo(slave, request.data() + mailboxHeaderSize, length);
+    return;
+  }
+  // no other mailbox protocol is supported.
+  std::vector<uint8_t> response;
+  appendU16(response, 4);
+  appendU16(response, 0);
+  response.push_back(0);
+  response.push_back(mailboxTypeError);
+  appendU16(response, 0x0001);
+  appendU16(response, mailboxErrorUnsupportedProtocol);
+  queueMailbox(slave, std::move(response));
+}
+
+void EscSimulator::queueMailbox(Slave& slave, std::vector<uint8_t> response) {
+  // 3 bit counter, 0 is reserved.
+  slave.mailboxCounter = static_cast<uint8_t>(slave.mailboxCounter % 7 + 1);
+  response[5] = static_cast<uint8_t>((response[5] & 0x0f) | (slave.mailboxCounter << 4));
+  slave.outbox.push_back(std::move(response));
+}
+
+void EscSimulator::handleFoe(Slave& slave, const uint8_t* request, size_t size) {
+  const uint8_t opCode = request[0];
+  const uint32_t value = readU32(request + 2);
+  const uint8_t* data = request + foeHeaderSize;
+  const size_t dataSize = size - foeHeaderSize;
+  // as SOEM: a packet shorter than the output mailbox allows ends the file, in both directions.
+  const size_t maxData = getSyncManager(slave, 0).length - mailboxHeaderSize - foeHeaderSize;
+  FoeTransfer& foe = slave.foe;
+  switch (opCode) {
+    case foeWrite:
+      foe = FoeTransfer{};
+      foe.writing = true;
+      foe.fileName.assign(data, std::find(data, data + dataSize, 0));
+      queueFoe(slave, foeAck, 0);
+      return;
+    case foeData:
+      if (!foe.writing || value != foe.packetNumber + 1) {
+        foe = FoeTransfer{};
+        queueFoe(slave, foeError, foeErrorPacketNumber);
+        return;
+      }
+      foe.packetNumber = value;
+      foe.data.insert(foe.data.end(), data, data + dataSize);
+      if (dataSize < maxData) {
+        slave.files[foe.fileName] = foe.data;
+        foe = FoeTransfer{};
+      }
+      queueFoe(slave, foeAck, value);
+      return;
+    case foeRead: {
+      const auto file = slave.files.find(std::string(data, std::find(data, data + dataSize, 0)));
+      if (file == slave.files.end()) {
+        foe = FoeTransfer{};
+        queueFoe(slave, foeError, foeErrorNotFound);
+        return;
+      }
+      foe = FoeTransfer{};
+      foe.reading = true;
+      foe.fileName = file->first;
+      foe.data = file->second;
+      if (slave.description.corruptFoeRead && !foe.data.empty()) {
+        foe.data[0] ^= 0xff;
+      }
+      sendFoeData(slave, maxData);
+      return;
+    }
+    case foeAck:
+      if (!foe.reading || value != foe.packetNumber) {
+        foe = FoeTransfer{};
+        queueFoe(slave, foeError, foeErrorPacketNumber);
+      } else if (foe.lastPacketSent) {
+        foe = FoeTransfer{};
+      } else {
+        sendFoeData(slave, maxData);
+      }
+      return;
+    default:
+      foe = FoeTransfer{};
+      queueFoe(slave, foeError, foeErrorIllegal);
+      return;
+  }
+}
+
+void EscSimulator::handleSdo(Slave& slave, const uint8_t* request, size_t size) {
+  const uint8_t command = request[coeHeaderSize];
+  const uint16_t index = readU16(request + coeHeaderSize + 1);
+  const uint8_t subindex = request[coeHeaderSize + 3];
+  const uint8_t* data = request + coeHeaderSize + 4;
+  // segmented and complete access transfers are not supported.
+  if ((readU16(request) >> 12) != coeServiceSdoRequest || (command & 0x10) != 0) {
+    queueSdo(slave, coeServiceSdoRequest, sdoAbort, index, subindex, sdoAbortCommand);
+    return;
+  }
+  switch (command >> 5) {
+    case sdoDownloadInitiate: {
+      std::vector<uint8_t> value;
+      if (command & 0x02) {
+        // expedited: the size is given by the unused bytes, if indicated.
+        const size_t valueSize = (command & 0x01) ? 4 - ((command >> 2) & 0x03) : 4;
+        value.assign(data, data + valueSize);
+      } else {
+        const size_t valueSize = readU32(data);
+        if (coeHeaderSize + sdoHeaderSize + valueSize > size) {
+          queueSdo(slave, coeServiceSdoRequest, sdoAbort, index, subindex, sdoAbortGeneral);
+          return;
+        }
+        value.assign(data + 4, data + 4 + valueSize);
+      }
+      slave.objects[{index, subindex}] = value;
+      queueSdo(slave, coeServiceSdoResponse, 0x60, index, subindex, 0);
+      return;
+    }
+    case sdoUploadInitiate: {
+      const auto object = slave.objects.find({index, subindex});
+      if (object == slave.objects.end()) {
+        queueSdo(slave, coeServiceSdoRequest, sdoAbort, index, subindex, sdoAbortNotFound);
+        return;
+      }
+      const std::vector<uint8_t>& value = object->second;
+      const size_t maxData = getSyncManager(slave, 1).length - mailboxHeaderSize - coeHeaderSize - sdoHeaderSize;
+      if (value.size() > maxData) {
+        queueSdo(slave, coeServiceSdoRequest, sdoAbort, index, subindex, sdoAbortGeneral);
+        return;
+      }
+      slave.sdoUploads++;
+      if (value.size() <= 4) {
+        std::vector<uint8_t> padded(value);
+        padded.resize(4, 0);
+        queueSdo(slave, coeServiceSdoResponse, static_cast<uint8_t>(0x43 | ((4 - value.size()) << 2)), index, subindex,
+                 readU32(padded.data()));
+      } else {
+        queueSdo(slave, coeServiceSdoResponse, 0x41, index, subindex, static_cast<uint32_t>(value.size()), value);
+      }
+      return;
+    }
+    default:
+      queueSdo(slave, coeServiceSdoRequest, sdoAbort, index, subindex, sdoAbortCommand);
+      return;
+  }
+}
+
+void EscSimulator::queueSdo(Slave& slave, uint8_t service, uint8_t command, uint16_t index, uint8_t subindex, uint32_t value,
+                            const std::vector<uint8_t>& data) {
+  std::vector<uint8_t> response;
+  appendU16(response, static_cast<uint16_t>(coeHeaderSize + sdoHeaderSize + data.size()));
+  appendU16(response, 0);
+  response.push_back(0);
+  response.push_back(mailboxTypeCoe);
+  appendU16(response, static_cast<uint16_t>(service << 12));
+  response.push_back(command);
+  appendU16(response, index);
+  response.push_back(subindex);
+  appendU32(response, value);
+  response.insert(response.end(), data.begin(), data.end());
+  queueMailbox(slave, std::move(response));
+}
+
+void EscSimulator::sendFoeData(Slave& slave, size_t maxData) {
+  FoeTransfer& foe = slave.foe;
+  const size_t size = std::min(maxData, foe.data.size() - foe.offset);
+  foe.packetNumber++;
+  queueFoe(slave, foeData, foe.packetNumber, foe.data.data() + foe.offset, size);
+  foe.offset += size;
+  foe.lastPacketSent = size < maxData;
+}
+
+void EscSimulator::queueFoe(Slave& slave, uint8_t opCode, uint32_t value, const uint8_t* data, size_t size) {
+  std::vector<uint8_t> response;
+  appendU16(response, static_cast<uint16_t>(foeHeaderSize + size));
+  appendU16(response, 0);
+  response.push_back(0);
+  response.push_back(mailboxTypeFoe);
+  response.push_back(opCode);
+  response.push_back(0);
+  appendU32(response, value);
+  if (size > 0) {
+    response.insert(response.end(), data, data + size);
+  }
+  queueMailbox(slave, std::move(response));
+}
+
+uint16_t EscSimulator::position(const Slave& slave) const {
+  return static_cast<uint16_t>(&slave - slaves_.data() + 1);
+}
+
+std::vector<uint8_t> EscSimulator::buildEeprom(const SlaveDescription& description) {
+  const uint16_t mailboxSize = description.mailboxSize;
+  std::vector<uint8_t> eeprom(0x80, 0);
+  auto setWord = [&eeprom](size_t word, uint16_t value) { writeU16(&eeprom[word * 2], value); };
+  setWord(0x0008, static_cast<uint16_t>(description.vendorId));
+  setWord(0x0009, static_cast<uint16_t>(description.vendorId >> 16));
+  setWord(0x000a, static_cast<uint16_t>(description.productCode));
+  setWord(0x000b, static_cast<uint16_t>(description.productCode >> 16));
+  setWord(0x000c, static_cast<uint16_t>(description.revision));
+  setWord(0x000d, static_cast<uint16_t>(description.revision >> 16));
+  setWord(0x000e, static_cast<uint16_t>(description.serial));
+  setWord(0x000f, static_cast<uint16_t>(description.serial >> 16));
+  if (mailboxSize > 0) {
+    setWord(0x0018, mailboxStart);
+    setWord(0x0019, mailboxSize);
+    setWord(0x001a, static_cast<uint16_t>(mailboxStart + mailboxSize));
+    setWord(0x001b, mailboxSize);
+  }
+  if (description.bootMailboxSize > 0) {
+    setWord(0x0014, bootMailboxStart);
+    setWord(0x0015, description.bootMailboxSize);
+    setWord(0x0016, static_cast<uint16_t>(bootMailboxStart + description.bootMailboxSize));
+    setWord(0x0017, description.bootMailboxSize);
+  }
+  // 2 KiBit EEPROM, SII version 1.
+  setWord(0x003e, 0x0001);
+  setWord(0x003f, 0x0001);
+  setWord(0x0007, siiChecksum(eeprom));
+
+  auto appendCategory = [&eeprom](uint16_t type, std::vector<uint8_t> data) {
+    if (data.size() % 2 != 0) {
+      data.push_back(0);
+    }
+    appendU16(eeprom, type);
+    appendU16(eeprom, static_cast<uint16_t>(data.size() / 2));
+    eeprom.insert(eeprom.end(), data.begin(), data.end());
+  };
+
+  // strings: the name is string 1.
+  std::vector<uint8_t> strings{1, static_cast<uint8_t>(description.name.size())};
+  strings.insert(strings.end(), description.name.begin(), description.name.end());
+  appendCategory(10, strings);
+
+  // general: name index 1.
+  std::vector<uint8_t> general(32, 0);
+  general[3] = 1;
+  appendCategory(30, general);
+
+  // FMMU usage: outputs, inputs.
+  appendCategory(40, {0x01, 0x02});
+
+  // sync managers: start, length, control, status, enable, type.
+  std::vector<uint8_t> syncManagers;
+  auto appendSyncManager = [&syncManagers](uint16_t start, uint16_t length, uint8_t control, bool enable, uint8_t type) {
+    appendU16(syncManagers, start);
+    appendU16(syncManagers, length);
+    syncManagers.insert(syncManagers.end(), {control, 0, static_cast<uint8_t>(enable ? 1 : 0), type});
+  };
+  appendSyncManager(mailboxStart, mailboxSize, 0x26, mailboxSize > 0, 1);
+  appendSyncManager(static_cast<uint16_t>(mailboxStart + mailboxSize), mailboxSize, 0x22, mailboxSize > 0, 2);
+  appendSyncManager(outputsStart, description.outputBytes, 0x64, description.outputBytes > 0, 3);
+  appendSyncManager(inputsStart, description.inputBytes, 0x20, description.inputBytes > 0, 4);
+  appendCategory(41, syncManagers);
+
+  // one PDO per direction with one byte entries: TxPDO 0x1a00 in SM3, RxPDO 0x1600 in SM2.
+  auto appendPdo = [&appendCategory](uint16_t category, uint16_t pdoIndex, uint16_t entryIndex, uint8_t syncManager, uint16_t bytes) {
+    if (bytes == 0) {
+      return;
+    }
+    std::vector<uint8_t> pdo;
+    appendU16(pdo, pdoIndex);
+    pdo.insert(pdo.end(), {static_cast<uint8_t>(bytes), syncManager, 0, 0});
+    appendU16(pdo, 0);
+    for (uint16_t byte = 0; byte < bytes; byte++) {
+      appendU16(pdo, entryIndex);
+      // subindex, name, data type UNSIGNED8, bit length.
+      pdo.insert(pdo.end(), {static_cast<uint8_t>(byte + 1), 0, 0x05, 8});
+      appendU16(pdo, 0);
+    }
+    appendCategory(category, pdo);
+  };
+  appendPdo(50, 0x1a00, 0x6000, 3, description.inputBytes);
+  appendPdo(51, 0x1600, 0x7000, 2, description.outputBytes);
+
+  appendU16(eeprom, 0xffff);
+  return eeprom;
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ecat_master {
+
+/*!
+ * Line of simulated EtherCAT slave controllers for tests, attached to the peer ends of veth pairs.
+ * The slaves answer the datagrams of SOEM on the register level: SII EEPROM interface, AL control and status,
+ * DL status, station addresses, sync managers with mailbox handshake and FMMUs for the logical commands.
+ * The first slave is connected to the primary interface, the last one optionally to a secondary interface for cable
+ * redundancy. As in a real ESC a frame is processed on the way from port 0 to port 1 only: frames from the primary
+ * interface are processed by all slaves up to a line break, frames from the secondary interface pass unprocessed up
+ * to the break, are looped back there and processed on the way back.
+ * The inputs of every slave mirror its outputs, slaves with a boot mailbox keep the files written with FoE in memory.
+ * Requires CAP_NET_RAW.
+ */
+class EscSimulator {
+ public:
+  struct SlaveDescription {
+    std::string name{"SimulatedSlave"};
+    uint32_t vendorId{0x00000999};
+    uint32_t productCode{0x00000001};
+    uint32_t revision{0x00000001};
+    uint32_t serial{0};
+    uint16_t outputBytes{1};
+    uint16_t inputBytes{1};
+    /// Size of the standard mailbox, 0 for a slave without mailbox.
+    uint16_t mailboxSize{128};
+    /// Size of the boot mailbox (at most 512 bytes), 0 for a slave without BOOT state. Slaves with BOOT state support FoE.
+    uint16_t bootMailboxSize{0};
+    /// Flip the first byte of every file read with FoE, e.g. to fail the verification of a firmware update.
+    bool corruptFoeRead{false};
+  };
+
+  /*!
+   * @param[in] primaryInterface veth end of the line connected to the network interface of the master.
+   * @param[in] secondaryInterface veth end connected to the redundant interface of the master, empty for an open line.
+   */
+  explicit EscSimulator(std::string primaryInterface, std::string secondaryInterface = "");
+  ~EscSimulator();
+
+  EscSimulator(const EscSimulator&) = delete;
+  EscSimulator& operator=(const EscSimulator&) = delete;
+
+  /*!
+   * Append a slave to the line. Call before start().
+   */
+  void addSlave(const SlaveDescription& description);
+
+  /*!
+   * Open the interfaces and answer frames in a background thread.
+   * @return false if an interface could not be opened.
+   */
+  bool start();
+  void stop();
+
+  /*!
+   * Break the line in front of a slave: 1 disconnects the first slave from the primary interface, number of slaves + 1
+   * disconnects the last slave from the secondary interface. 0 closes the line again.
+   */
+  void setLineBreak(uint16_t slave);
+
+  /*!
+   * AL status of a slave (bus position, starting at 1).
+   */
+  uint16_t getAlStatus(uint16_t slave) const;
+
+  using StateCallback = std::function<void(uint16_t slave, uint8_t state)>;
+
+  /*!
+   * Called by the simulator thread whenever a slave changed its AL state, before the frame which requested the state
+   * is answered. Blocking in the callback delays the answer.
+   */
+  void setStateCallback(const StateCallback& callback);
+
+  /*!
+   * Content of a file written with FoE, empty if the slave has no such file.
+   */
+  std::vector<uint8_t> getFile(uint16_t slave, const std::string& fileName) const;
+
+  /*!
+   * Object of the CoE object dictionary of a slave, read and written with expedited and normal SDO transfers. The
+   * identity object 0x1018 is filled from the slave description.
+   */
+  void setObject(uint16_t slave, uint16_t index, uint8_t subindex, const std::vector<uint8_t>& value);
+  std::vector<uint8_t> getObject(uint16_t slave, uint16_t index, uint8_t subindex) const;
+
+  /*!
+   * Successful SDO uploads answered by a slave.
+   */
+  uint64_t getSdoUploads(uint16_t slave) const;
+
+  /*!
+   * Frames answered since start().
+   */
+  uint64_t getFrameCount() const { return frames_; }
+
+ private:
+  struct SyncManager {
+    uint16_t start{0};
+    uint16_t length{0};
+    uint8_t control{0};
+    bool enabled{false};
+  };
+
+  // FoE transfer in progress, write or read.
+  struct FoeTransfer {
+    bool writing{false};
+    bool reading{false};
+    std::string fileName;
+    std::vector<uint8_t> data;
+    uint32_t packetNumber{0};
+    size_t offset{0};
+    bool lastPacketSent{false};
+  };
+
+  struct Slave {
+    SlaveDescription description;
+    // 64 KiB ESC address space: registers below 0x1000, process data RAM above.
+    std::vector<uint8_t> memory;
+    std::vector<uint8_t> eeprom;
+    // responses waiting for the input mailbox to be read by the master.
+    std::deque<std::vector<uint8_t>> outbox;
+    bool mailboxRequest{false};
+    uint8_t mailboxCounter{0};
+    FoeTransfer foe;
+    std::map<std::string, std::vector<uint8_t>> files;
+    // object dictionary: index, subindex.
+    std::map<std::pair<uint16_t, uint8_t>, std::vector<uint8_t>> objects;
+    uint64_t sdoUploads{0};
+  };
+
+  struct Datagram {
+    uint8_t command{0};
+    uint16_t adp{0};
+    uint16_t ado{0};
+    uint8_t* data{nullptr};
+    uint16_t length{0};
+    uint16_t workingCounter{0};
+  };
+
+  void run();
+  void handleFrame(std::vector<uint8_t>& frame, bool fromSecondary);
+  bool secondaryLinkUp() const;
+  void updateDlStatus(bool secondaryUp);
+
+  void processDatagram(Slave& slave, Datagram& datagram);
+  void processLogical(Slave& slave, Datagram& datagram, const std::vector<uint8_t>& writeData);
+  bool readPhysical(Slave& slave, uint16_t address, uint8_t* data, size_t size, bool combine);
+  bool writePhysical(Slave& slave, uint16_t address, const uint8_t* data, size_t size);
+  void afterRegisterWrite(Slave& slave, uint16_t address, size_t size);
+
+  void requestState(Slave& slave, uint16_t control);
+  uint16_t checkTransition(const Slave& slave, uint8_t current, uint8_t requested) const;
+  bool mailboxConfigured(const Slave& slave, uint16_t start, uint16_t size) const;
+  void executeEepromCommand(Slave& slave);
+  void runApplication(Slave& slave);
+  void handleMailbox(Slave& slave, const std::vector<uint8_t>& request);
+  void queueMailbox(Slave& slave, std::vector<uint8_t> response);
+  void handleFoe(Slave& slave, const uint8_t* request, size_t size);
+  void handleSdo(Slave& slave, const uint8_t* request, size_t size);
+  void queueSdo(Slave& slave, uint8_t service, uint8_t command, uint16_t index, uint8_t subindex, uint32_t value,
+                const std::vector<uint8_t>& data = {});
+  void sendFoeData(Slave& slave, size_t maxData);
+  void queueFoe(Slave& slave, uint8_t opCode, uint32_t value, const uint8_t* data = nullptr, size_t size = 0);
+
+  SyncManager getSyncManager(const Slave& slave, unsigned int index) const;
+  void setMailboxFull(Slave& slave, unsigned int index, bool full);
+  uint16_t position(const Slave& slave) const;
+
+  static std::vector<uint8_t> buildEeprom(const SlaveDescription& description);
+  static int openInterface(const std::string& networkInterface);
+
+  std::string primaryInterface_;
+  std::string secondaryInterface_;
+  int primarySocket_{-1};
+  int secondarySocket_{-1};
+  int controlSocket_{-1};
+
+  mutable std::mutex mutex_;
+  std::vector<Slave> slaves_;
+  uint16_t lineBreak_{0};
+  StateCallback stateCallback_;
+  // state changes of the current frame, reported after it was processed.
+  std::vector<std::pair<uint16_t, uint8_t>> stateChanges_;
+
+  std::atomic<bool> running_{false};
+  std::atomic<uint64_t> frames_{0};
+  std::thread thread_;
+};
+
+}  // namespace ecat_master
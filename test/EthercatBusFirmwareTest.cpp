@@ -0,0 +1,115 @@
+#include "EscSimulator.hpp"
+#include "VethPair.hpp"
+
+#include "ethercat_sdk_master/EthercatBus.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr uint16_t bootSlave{2};
+constexpr uint16_t bootMailboxSize{256};
+constexpr int packetTimeoutUs{500000};
+
+// access to the mailbox configuration of the slave list.
+class TestBus : public EthercatBus {
+ public:
+  using EthercatBus::EthercatBus;
+
+  const ec_slavet& getSlave(uint16_t slave) const { return ecatSlavelist_[slave]; }
+};
+
+uint8_t getState(const EscSimulator& simulator, uint16_t slave) {
+  return static_cast<uint8_t>(simulator.getAlStatus(slave) & 0x0f);
+}
+
+}  // namespace
+
+class EthercatBusFirmwareTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    line_ = std::make_unique<VethPair>("ecatf");
+    if (!line_->isCreated()) {
+      GTEST_SKIP() << "Creating veth pairs requires CAP_NET_ADMIN.";
+    }
+    simulator_ = std::make_unique<EscSimulator>(line_->getSimulatorEnd());
+    EscSimulator::SlaveDescription description;
+    description.name = "Slave1";
+    simulator_->addSlave(description);
+    description.name = "Slave2";
+    description.bootMailboxSize = bootMailboxSize;
+    simulator_->addSlave(description);
+    ASSERT_TRUE(simulator_->start());
+    bus_ = std::make_unique<TestBus>(line_->getMasterEnd());
+    ASSERT_TRUE(bus_->startup(abort_, false));
+  }
+
+  void TearDown() override {
+    if (bus_) {
+      bus_->shutdown();
+    }
+    if (simulator_) {
+      simulator_->stop();
+    }
+  }
+
+  std::unique_ptr<VethPair> line_;
+  std::unique_ptr<EscSimulator> simulator_;
+  std::unique_ptr<TestBus> bus_;
+  std::atomic<bool> abort_{false};
+};
+
+TEST_F(EthercatBusFirmwareTest, FirmwareIsWrittenThroughBootMailbox) {
+  const ec_slavet standardMailbox = bus_->getSlave(bootSlave);
+  ASSERT_TRUE(bus_->enterBootState(bootSlave));
+  EXPECT_EQ(getState(*simulator_, bootSlave), 0x03);
+  EXPECT_EQ(bus_->getSlave(bootSlave).mbx_l, bootMailboxSize);
+  EXPECT_EQ(bus_->getSlave(bootSlave).mbx_rl, bootMailboxSize);
+  EXPECT_NE(bus_->getSlave(bootSlave).mbx_wo, standardMailbox.mbx_wo);
+
+  // several packets and a final one which is not full.
+  std::vector<char> image(3 * bootMailboxSize);
+  std::iota(image.begin(), image.end(), 0);
+  std::vector<size_t> remaining;
+  ASSERT_TRUE(bus_->writeFirmware(
+      bootSlave, "firmware.bin", 0, image, [&remaining](size_t remainingBytes) { remaining.push_back(remainingBytes); }, packetTimeoutUs));
+  const std::vector<uint8_t> written = simulator_->getFile(bootSlave, "firmware.bin");
+  EXPECT_EQ(std::vector<char>(written.begin(), written.end()), image);
+  ASSERT_GE(remaining.size(), 2u);
+  EXPECT_EQ(remaining.front(), image.size());
+  EXPECT_TRUE(std::is_sorted(remaining.rbegin(), remaining.rend()));
+
+  std::vector<char> readBack(image.size());
+  ASSERT_TRUE(bus_->readFirmware(bootSlave, "firmware.bin", 0, readBack, packetTimeoutUs));
+  EXPECT_EQ(readBack, image);
+  std::vector<char> missing(image.size());
+  EXPECT_FALSE(bus_->readFirmware(bootSlave, "missing.bin", 0, missing, packetTimeoutUs));
+
+  ASSERT_TRUE(bus_->leaveBootState(bootSlave));
+  EXPECT_EQ(getState(*simulator_, bootSlave), 0x01);
+  const ec_slavet& restored = bus_->getSlave(bootSlave);
+  EXPECT_EQ(restored.mbx_wo, standardMailbox.mbx_wo);
+  EXPECT_EQ(restored.mbx_l, standardMailbox.mbx_l);
+  EXPECT_EQ(restored.mbx_ro, standardMailbox.mbx_ro);
+  EXPECT_EQ(restored.mbx_rl, standardMailbox.mbx_rl);
+  // PRE_OP requires the standard mailbox in the sync managers again.
+  bus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::PRE_OP, bootSlave);
+  EXPECT_TRUE(bus_->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::PRE_OP, bootSlave, 50, 0.01));
+}
+
+TEST_F(EthercatBusFirmwareTest, SlaveWithoutBootMailboxStaysOutOfBoot) {
+  const ec_slavet standardMailbox = bus_->getSlave(1);
+  EXPECT_FALSE(bus_->enterBootState(1));
+  EXPECT_NE(getState(*simulator_, 1), 0x03);
+  EXPECT_EQ(bus_->getSlave(1).mbx_wo, standardMailbox.mbx_wo);
+  EXPECT_EQ(bus_->getSlave(1).mbx_l, standardMailbox.mbx_l);
+}
+
+}  // namespace ecat_master
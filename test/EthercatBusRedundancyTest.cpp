@@ -0,0 +1,143 @@
+#include "EscSimulator.hpp"
+#include "VethPair.hpp"
+
+#include "ethercat_sdk_master/EthercatBus.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr uint16_t slaveCount{3};
+
+// access to the process image of the slaves.
+class TestBus : public EthercatBus {
+ public:
+  using EthercatBus::EthercatBus;
+
+  uint8_t* getOutputs(uint16_t slave) { return ecatSlavelist_[slave].outputs; }
+  const uint8_t* getInputs(uint16_t slave) const { return ecatSlavelist_[slave].inputs; }
+};
+
+uint8_t getState(const EscSimulator& simulator, uint16_t slave) {
+  return static_cast<uint8_t>(simulator.getAlStatus(slave) & 0x0f);
+}
+
+}  // namespace
+
+class EthercatBusRedundancyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    primary_ = std::make_unique<VethPair>("ecatp");
+    secondary_ = std::make_unique<VethPair>("ecatr");
+    if (!primary_->isCreated() || !secondary_->isCreated()) {
+      GTEST_SKIP() << "Creating veth pairs requires CAP_NET_ADMIN.";
+    }
+  }
+
+  void startSimulator(bool connectSecondary) {
+    simulator_ = std::make_unique<EscSimulator>(primary_->getSimulatorEnd(), connectSecondary ? secondary_->getSimulatorEnd() : "");
+    for (uint16_t slave = 1; slave <= slaveCount; slave++) {
+      EscSimulator::SlaveDescription description;
+      description.name = "Slave" + std::to_string(slave);
+      simulator_->addSlave(description);
+    }
+    ASSERT_TRUE(simulator_->start());
+  }
+
+  void TearDown() override {
+    if (bus_) {
+      bus_->shutdown();
+    }
+    if (simulator_) {
+      simulator_->stop();
+    }
+  }
+
+  // one cycle with the outputs set to value, true if the working counter is complete.
+  bool cycle(uint8_t value) {
+    for (uint16_t slave = 1; slave <= slaveCount; slave++) {
+      bus_->getOutputs(slave)[0] = static_cast<uint8_t>(value + slave);
+    }
+    bus_->updateWrite();
+    bus_->updateRead();
+    return bus_->workingCounterIsOk();
+  }
+
+  std::unique_ptr<VethPair> primary_;
+  std::unique_ptr<VethPair> secondary_;
+  std::unique_ptr<EscSimulator> simulator_;
+  std::unique_ptr<TestBus> bus_;
+  std::atomic<bool> abort_{false};
+};
+
+TEST_F(EthercatBusRedundancyTest, ProcessDataSurvivesLineBreak) {
+  startSimulator(true);
+  bus_ = std::make_unique<TestBus>(primary_->getMasterEnd());
+  bus_->setRedundantInterface(secondary_->getMasterEnd());
+  ASSERT_TRUE(bus_->startup(abort_, false));
+  bus_->setState(soem_interface_rsl::ETHERCAT_SM_STATE::OPERATIONAL);
+  ASSERT_TRUE(bus_->waitForState(soem_interface_rsl::ETHERCAT_SM_STATE::OPERATIONAL, 0, 50, 0.01));
+
+  RedundancyState state = bus_->readRedundancyState();
+  ASSERT_TRUE(state.enabled);
+  EXPECT_FALSE(state.lineBreak);
+  for (uint8_t value = 0; value < 10; value++) {
+    ASSERT_TRUE(cycle(value));
+  }
+
+  // failover within the same cycle, for a break inside the line and at the primary interface.
+  for (const uint16_t lineBreak : {uint16_t{3}, uint16_t{1}}) {
+    simulator_->setLineBreak(lineBreak);
+    for (uint8_t value = 10; value < 20; value++) {
+      ASSERT_TRUE(cycle(value)) << "line break in front of slave " << lineBreak << ", cycle " << static_cast<int>(value);
+    }
+    // the inputs mirror the outputs of the previous cycle.
+    for (uint16_t slave = 1; slave <= slaveCount; slave++) {
+      EXPECT_EQ(bus_->getInputs(slave)[0], static_cast<uint8_t>(18 + slave));
+    }
+    state = bus_->readRedundancyState();
+    EXPECT_TRUE(state.lineBreak);
+    EXPECT_EQ(state.breakLink.downstream.slave, lineBreak);
+  }
+
+  simulator_->setLineBreak(0);
+  ASSERT_TRUE(cycle(0));
+  EXPECT_FALSE(bus_->readRedundancyState().lineBreak);
+}
+
+TEST_F(EthercatBusRedundancyTest, StartupFailsWithoutRedundantInterface) {
+  startSimulator(false);
+  bus_ = std::make_unique<TestBus>(primary_->getMasterEnd());
+  bus_->setRedundantInterface("ecatmissing0");
+  EXPECT_FALSE(bus_->startup(abort_, false));
+  for (uint16_t slave = 1; slave <= slaveCount; slave++) {
+    EXPECT_EQ(getState(*simulator_, slave), 0x01);
+  }
+  bus_.reset();
+}
+
+TEST_F(EthercatBusRedundancyTest, BusIsShutDownIfRedundantInterfaceDisappears) {
+  startSimulator(false);
+  // the redundant interface is removed while the slaves are configured: it cannot be set up again after the startup.
+  std::atomic<bool> removed{false};
+  simulator_->setStateCallback([this, &removed](uint16_t /*slave*/, uint8_t state) {
+    if (state == 0x02 && !removed.exchange(true)) {
+      secondary_->remove();
+    }
+  });
+  bus_ = std::make_unique<TestBus>(primary_->getMasterEnd());
+  bus_->setRedundantInterface(secondary_->getMasterEnd());
+  EXPECT_FALSE(bus_->startup(abort_, false));
+  ASSERT_TRUE(removed);
+  for (uint16_t slave = 1; slave <= slaveCount; slave++) {
+    EXPECT_EQ(getState(*simulator_, slave), 0x01) << "slave " << slave;
+  }
+  bus_.reset();
+}
+
+}  // namespace ecat_master
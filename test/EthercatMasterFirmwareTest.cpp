@@ -0,0 +1,124 @@
+#include "EscSimulator.hpp"
+#include "VethPair.hpp"
+
+#include "ethercat_sdk_master/EthercatMaster.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr uint16_t slaves{3};
+// the read back of this slave differs from the written image.
+constexpr uint16_t corruptSlave{2};
+constexpr uint16_t bootMailboxSize{256};
+
+uint8_t getState(const EscSimulator& simulator, uint16_t slave) {
+  return static_cast<uint8_t>(simulator.getAlStatus(slave) & 0x0f);
+}
+
+}  // namespace
+
+class EthercatMasterFirmwareTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    line_ = std::make_unique<VethPair>("ecatm");
+    if (!line_->isCreated()) {
+      GTEST_SKIP() << "Creating veth pairs requires CAP_NET_ADMIN.";
+    }
+    simulator_ = std::make_unique<EscSimulator>(line_->getSimulatorEnd());
+    for (uint16_t slave = 1; slave <= slaves; slave++) {
+      EscSimulator::SlaveDescription description;
+      description.name = "Slave" + std::to_string(slave);
+      description.bootMailboxSize = bootMailboxSize;
+      description.corruptFoeRead = slave == corruptSlave;
+      simulator_->addSlave(description);
+    }
+    ASSERT_TRUE(simulator_->start());
+
+    EthercatMasterConfiguration configuration;
+    configuration.name = "FirmwareTest";
+    configuration.networkInterface = line_->getMasterEnd();
+    configuration.timeStep = 0.001;
+    master_ = std::make_unique<EthercatMaster>();
+    master_->loadEthercatMasterConfiguration(configuration);
+    ASSERT_TRUE(master_->startup());
+
+    // several packets and a final one which is not full.
+    image_.resize(3 * bootMailboxSize + 17);
+    std::iota(image_.begin(), image_.end(), 0);
+    imagePath_ = ::testing::TempDir() + "/firmware.bin";
+    std::ofstream file(imagePath_, std::ios::binary | std::ios::trunc);
+    file.write(image_.data(), static_cast<std::streamsize>(image_.size()));
+  }
+
+  void TearDown() override {
+    if (master_) {
+      master_->shutdown();
+    }
+    if (simulator_) {
+      simulator_->stop();
+    }
+  }
+
+  std::unique_ptr<VethPair> line_;
+  std::unique_ptr<EscSimulator> simulator_;
+  std::unique_ptr<EthercatMaster> master_;
+  std::vector<char> image_;
+  std::string imagePath_;
+};
+
+TEST_F(EthercatMasterFirmwareTest, FailedVerificationLeavesBoot) {
+  std::vector<FirmwareUpdateJob> jobs;
+  for (uint16_t slave = 1; slave <= slaves; slave++) {
+    FirmwareUpdateJob job;
+    job.slave = slave;
+    job.imagePath = imagePath_;
+    jobs.push_back(job);
+  }
+  FirmwareUpdateOptions options;
+  options.maxConcurrentTransfers = 2;
+  options.verify = true;
+  options.packetTimeoutUs = 500000;
+
+  // transfers in progress, seen by the progress callback of the workers.
+  std::mutex transfersMutex;
+  std::map<uint16_t, FirmwareUpdateState> states;
+  size_t maxTransfers = 0;
+  const auto progress = master_->updateFirmware(jobs, options, [&](const FirmwareUpdateProgress& update) {
+    std::lock_guard<std::mutex> lock(transfersMutex);
+    states[update.slave] = update.state;
+    const size_t transfers = std::count_if(states.begin(), states.end(), [](const auto& state) {
+      return state.second == FirmwareUpdateState::Transferring || state.second == FirmwareUpdateState::Verifying;
+    });
+    maxTransfers = std::max(maxTransfers, transfers);
+  });
+
+  EXPECT_GE(maxTransfers, 1u);
+  EXPECT_LE(maxTransfers, options.maxConcurrentTransfers);
+  ASSERT_EQ(progress.size(), jobs.size());
+  for (const auto& update : progress) {
+    EXPECT_EQ(update.imageSize, image_.size());
+    const std::vector<uint8_t> written = simulator_->getFile(update.slave, "firmware.bin");
+    EXPECT_EQ(std::vector<char>(written.begin(), written.end()), image_) << "slave " << update.slave;
+    if (update.slave == corruptSlave) {
+      EXPECT_EQ(update.state, FirmwareUpdateState::Failed);
+      EXPECT_EQ(update.error, "read back image differs");
+    } else {
+      EXPECT_EQ(update.state, FirmwareUpdateState::Done) << update.error;
+    }
+    // the failed slave is taken out of BOOT as well.
+    EXPECT_EQ(getState(*simulator_, update.slave), 0x01) << "slave " << update.slave;
+  }
+}
+
+}  // namespace ecat_master
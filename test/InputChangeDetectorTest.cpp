@@ -0,0 +1,62 @@
+#include "ethercat_sdk_master/InputChangeDetector.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace ecat_master {
+
+TEST(InputChangeDetectorTest, EqualComparesEveryByte) {
+  // sizes below, at and above the 16 byte blocks, the bytes after the last full block are compared one by one.
+  for (const size_t size : {0u, 1u, 15u, 16u, 17u, 31u, 32u, 45u}) {
+    std::vector<uint8_t> a(size, 0x5a);
+    std::vector<uint8_t> b = a;
+    EXPECT_TRUE(InputChangeDetector::equal(a.data(), b.data(), size)) << "size " << size;
+    for (size_t i = 0; i < size; i++) {
+      b[i] ^= 0x01;
+      EXPECT_FALSE(InputChangeDetector::equal(a.data(), b.data(), size)) << "size " << size << ", byte " << i;
+      b[i] = a[i];
+    }
+  }
+}
+
+TEST(InputChangeDetectorTest, EqualHandlesUnalignedData) {
+  std::vector<uint8_t> a(64, 0);
+  std::vector<uint8_t> b(64, 0);
+  for (size_t i = 0; i < a.size(); i++) {
+    a[i] = static_cast<uint8_t>(i);
+    b[i] = static_cast<uint8_t>(i + 1);
+  }
+  // a + 3 and b + 2 hold the same bytes.
+  EXPECT_TRUE(InputChangeDetector::equal(a.data() + 3, b.data() + 2, 40));
+  EXPECT_FALSE(InputChangeDetector::equal(a.data() + 3, b.data() + 3, 40));
+}
+
+TEST(InputChangeDetectorTest, ReportsChangedRegions) {
+  std::vector<uint8_t> image(40, 0);
+  // a region of two full blocks and a tail, one of a single block and one shorter than a block.
+  InputChangeDetector detector;
+  detector.configure({{image.data(), 21}, {image.data() + 21, 16}, {image.data() + 37, 3}});
+
+  // every region is reported as changed by the first update.
+  detector.update();
+  EXPECT_EQ(detector.getChanged(), (std::vector<uint8_t>{1, 1, 1}));
+  detector.update();
+  EXPECT_EQ(detector.getChanged(), (std::vector<uint8_t>{0, 0, 0}));
+
+  // last byte of the first region, in the tail after its full block.
+  image[20] = 1;
+  detector.update();
+  EXPECT_EQ(detector.getChanged(), (std::vector<uint8_t>{1, 0, 0}));
+  EXPECT_TRUE(detector.changed(0));
+  detector.update();
+  EXPECT_FALSE(detector.changed(0));
+
+  image[21] = 1;
+  image[39] = 1;
+  detector.update();
+  EXPECT_EQ(detector.getChanged(), (std::vector<uint8_t>{0, 1, 1}));
+  EXPECT_FALSE(detector.changed(3));
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,102 @@
+#include "ethercat_sdk_master/InputSnapshot.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+namespace ecat_master {
+
+namespace {
+
+// cycles 1 to cycles, stamped cycle * 1000 + offsetNs, every input byte set to the cycle.
+void publishCycles(InputSnapshotBuffer& buffer, size_t imageSize, uint64_t cycles, int64_t offsetNs = 0) {
+  for (uint64_t cycle = 1; cycle <= cycles; cycle++) {
+    const std::vector<uint8_t> inputs(imageSize, static_cast<uint8_t>(cycle));
+    buffer.publish(cycle, static_cast<int64_t>(cycle) * 1000 + offsetNs, inputs.data());
+  }
+}
+
+}  // namespace
+
+TEST(InputSnapshotTest, ConfigureRejectsSizeChange) {
+  InputSnapshotBuffer buffer;
+  EXPECT_TRUE(buffer.configure(4));
+  EXPECT_TRUE(buffer.configure(4));
+  EXPECT_FALSE(buffer.configure(8));
+
+  // the samples keep the first size.
+  publishCycles(buffer, 8, 1);
+  BusInputSample sample;
+  ASSERT_TRUE(buffer.read(1000, sample));
+  EXPECT_EQ(sample.inputs.size(), 4u);
+}
+
+TEST(InputSnapshotTest, ReadsClosestSample) {
+  InputSnapshotBuffer buffer;
+  BusInputSample sample;
+  int64_t stampNs = 0;
+  buffer.configure(4);
+  EXPECT_FALSE(buffer.getLatestStamp(stampNs));
+  EXPECT_FALSE(buffer.read(0, sample));
+  EXPECT_FALSE(sample.valid);
+
+  publishCycles(buffer, 4, 10);
+  ASSERT_TRUE(buffer.getLatestStamp(stampNs));
+  EXPECT_EQ(stampNs, 10000);
+
+  ASSERT_TRUE(buffer.read(5400, sample));
+  EXPECT_TRUE(sample.valid);
+  EXPECT_EQ(sample.cycle, 5u);
+  EXPECT_EQ(sample.stampNs, 5000);
+  EXPECT_EQ(sample.inputs, std::vector<uint8_t>(4, 5));
+
+  // only the last depth cycles are kept.
+  ASSERT_TRUE(buffer.read(0, sample));
+  EXPECT_EQ(sample.cycle, 10u - InputSnapshotBuffer::depth + 1);
+  ASSERT_TRUE(buffer.read(1000000, sample));
+  EXPECT_EQ(sample.cycle, 10u);
+}
+
+TEST(InputSnapshotTest, ReaderAlignsBuses) {
+  auto first = std::make_shared<InputSnapshotBuffer>();
+  auto second = std::make_shared<InputSnapshotBuffer>();
+  first->configure(4);
+  second->configure(2);
+  // the second bus is two cycles behind and its cycles start 100ns later.
+  publishCycles(*first, 4, 10);
+  publishCycles(*second, 2, 8, 100);
+
+  InputSnapshotReader reader({{"eth0", first}, {"eth1", second}});
+  MultiBusSnapshot snapshot;
+  ASSERT_TRUE(reader.read(snapshot));
+  EXPECT_EQ(snapshot.referenceStampNs, 8100);
+  EXPECT_EQ(snapshot.skewNs, 100);
+  ASSERT_EQ(snapshot.buses.size(), 2u);
+  EXPECT_EQ(snapshot.buses[0].networkInterface, "eth0");
+  EXPECT_EQ(snapshot.buses[0].cycle, 8u);
+  EXPECT_EQ(snapshot.buses[0].offsetNs, -100);
+  EXPECT_EQ(snapshot.buses[0].inputs, std::vector<uint8_t>(4, 8));
+  EXPECT_EQ(snapshot.buses[1].networkInterface, "eth1");
+  EXPECT_EQ(snapshot.buses[1].cycle, 8u);
+  EXPECT_EQ(snapshot.buses[1].offsetNs, 0);
+  EXPECT_EQ(snapshot.buses[1].inputs, std::vector<uint8_t>(2, 8));
+}
+
+TEST(InputSnapshotTest, ReaderIsIncompleteWithoutSample) {
+  auto first = std::make_shared<InputSnapshotBuffer>();
+  auto second = std::make_shared<InputSnapshotBuffer>();
+  first->configure(4);
+  second->configure(4);
+  publishCycles(*first, 4, 3);
+
+  InputSnapshotReader reader({{"eth0", first}, {"eth1", second}});
+  MultiBusSnapshot snapshot;
+  EXPECT_FALSE(reader.read(snapshot));
+  ASSERT_EQ(snapshot.buses.size(), 2u);
+  EXPECT_TRUE(snapshot.buses[0].valid);
+  EXPECT_EQ(snapshot.buses[0].cycle, 3u);
+  EXPECT_FALSE(snapshot.buses[1].valid);
+}
+
+}  // namespace ecat_master
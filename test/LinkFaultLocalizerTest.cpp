@@ -0,0 +1,81 @@
+#include "ethercat_sdk_master/BusTopology.hpp"
+
+#include <gtest/gtest.h>
+
+namespace ecat_master {
+
+namespace {
+
+// master NIC -> slave 1 (port 0 -> 1) -> slave 2 (port 0 -> 1) -> slave 3.
+BusTopology lineTopology() {
+  BusTopology topology;
+  topology.links.push_back(PortLink{PortEndpoint{0, 0}, PortEndpoint{1, 0}});
+  topology.links.push_back(PortLink{PortEndpoint{1, 1}, PortEndpoint{2, 0}});
+  topology.links.push_back(PortLink{PortEndpoint{2, 1}, PortEndpoint{3, 0}});
+  return topology;
+}
+
+}  // namespace
+
+TEST(LinkFaultLocalizerTest, FirstCountersAreBaseline) {
+  LinkFaultLocalizer localizer;
+  localizer.setTopology(lineTopology());
+
+  std::vector<PortErrorCounters> counters(3);
+  counters[1].rxErrors[0] = 200;
+  localizer.update(counters);
+  EXPECT_FALSE(localizer.getEstimate().valid);
+}
+
+TEST(LinkFaultLocalizerTest, LocalizesReceivingPort) {
+  LinkFaultLocalizer localizer;
+  localizer.setTopology(lineTopology());
+
+  std::vector<PortErrorCounters> counters(3);
+  localizer.update(counters);
+  // physical layer errors (high byte) on the entry port of slave 3.
+  counters[2].rxErrors[0] = 0x0500;
+  localizer.update(counters);
+
+  const auto estimate = localizer.getEstimate();
+  ASSERT_TRUE(estimate.valid);
+  EXPECT_EQ(estimate.link.upstream.slave, 2);
+  EXPECT_EQ(estimate.link.downstream.slave, 3);
+  EXPECT_FALSE(estimate.bothDirections);
+  EXPECT_DOUBLE_EQ(estimate.confidence, 1.0);
+}
+
+TEST(LinkFaultLocalizerTest, LostLinksOnBothEnds) {
+  LinkFaultLocalizer localizer;
+  localizer.setTopology(lineTopology());
+
+  std::vector<PortErrorCounters> counters(3);
+  localizer.update(counters);
+  counters[0].lostLinks[1] = 3;
+  counters[1].lostLinks[0] = 2;
+  localizer.update(counters);
+
+  const auto estimate = localizer.getEstimate();
+  ASSERT_TRUE(estimate.valid);
+  EXPECT_EQ(estimate.link.upstream.slave, 1);
+  EXPECT_EQ(estimate.link.downstream.slave, 2);
+  EXPECT_TRUE(estimate.bothDirections);
+}
+
+TEST(LinkFaultLocalizerTest, EstimateDecays) {
+  LinkFaultLocalizer localizer;
+  localizer.setTopology(lineTopology());
+
+  std::vector<PortErrorCounters> counters(3);
+  localizer.update(counters);
+  counters[0].rxErrors[0] = 1;
+  localizer.update(counters);
+  ASSERT_TRUE(localizer.getEstimate().valid);
+
+  for (int i = 0; i < 10; i++) {
+    localizer.update(counters);
+  }
+  EXPECT_FALSE(localizer.getEstimate().valid);
+}
+
+}  // namespace ecat_master
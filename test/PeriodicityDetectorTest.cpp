@@ -0,0 +1,72 @@
+#include "ethercat_sdk_master/PeriodicityDetector.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr unsigned int windowCycles{2000};
+constexpr int64_t cycleTimeNs{1000000};
+
+// lateness of a 1ms cycle: noise of about 2us and optionally a spike of 200us every spikePeriod cycles.
+void addWindow(PeriodicityDetector& detector, unsigned int spikePeriod) {
+  std::mt19937 generator(42);
+  std::normal_distribution<double> noise(10000.0, 2000.0);
+  for (unsigned int i = 0; i < windowCycles; i++) {
+    double latenessNs = noise(generator);
+    if (spikePeriod > 0 && i % spikePeriod == 0) {
+      latenessNs += 200000.0;
+    }
+    detector.addSample(i * cycleTimeNs, static_cast<int64_t>(latenessNs));
+  }
+}
+
+PeriodicityReport waitForReport(const PeriodicityDetector& detector) {
+  const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (detector.getReport().windows == 0 && std::chrono::steady_clock::now() < timeout) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return detector.getReport();
+}
+
+}  // namespace
+
+TEST(PeriodicityDetectorTest, FindsPeriodicSpike) {
+  PeriodicityDetector detector;
+  detector.start(windowCycles);
+  addWindow(detector, 50);
+  const auto report = waitForReport(detector);
+  detector.stop();
+
+  ASSERT_EQ(report.windows, 1u);
+  EXPECT_EQ(report.droppedSamples, 0u);
+  EXPECT_NEAR(report.windowDuration, 2.0, 1e-3);
+  ASSERT_FALSE(report.components.empty());
+  const auto& component = report.components.front();
+  EXPECT_NEAR(component.periodCycles, 50.0, 0.5);
+  EXPECT_NEAR(component.period, 0.05, 0.5e-3);
+  // the folded spike keeps most of its height, the noise averages out.
+  EXPECT_GT(component.amplitudeNs, 150000.0);
+  // a short spike spreads over many harmonics.
+  EXPECT_GT(component.harmonics, 8u);
+}
+
+TEST(PeriodicityDetectorTest, NoComponentInNoise) {
+  PeriodicityDetector detector;
+  detector.start(windowCycles);
+  addWindow(detector, 0);
+  const auto report = waitForReport(detector);
+  detector.stop();
+
+  ASSERT_EQ(report.windows, 1u);
+  EXPECT_TRUE(report.components.empty());
+  EXPECT_GT(report.noiseFloorNs, 0.0);
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,83 @@
+#include "ethercat_sdk_master/ProcessImageLayout.hpp"
+
+#include <gtest/gtest.h>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr uint32_t maxFrameSize{1466};
+constexpr uint32_t capacity{4096};
+
+ProcessImageBlock block(bool input, uint32_t offset, uint32_t size, bool hot = false) {
+  return ProcessImageBlock{input, offset, size, hot, 0};
+}
+
+}  // namespace
+
+TEST(ProcessImageLayoutTest, UnalignedKeepsTheOrder) {
+  const std::vector<ProcessImageBlock> blocks{block(false, 0, 3), block(false, 3, 5), block(true, 8, 7), block(true, 15, 2)};
+  ProcessImagePlan plan;
+  ASSERT_TRUE(planProcessImageLayout(blocks, false, maxFrameSize, capacity, plan));
+  for (const auto& planned : plan.blocks) {
+    EXPECT_EQ(planned.plannedOffset, planned.offset);
+  }
+  EXPECT_EQ(plan.outputBytes, 8u);
+  EXPECT_EQ(plan.inputBytes, 9u);
+  ASSERT_EQ(plan.frames.size(), 1u);
+  EXPECT_EQ(plan.frames[0], 17u);
+  EXPECT_EQ(plan.inputFrame, 0u);
+  EXPECT_EQ(plan.inputFrameOffset, 8u);
+}
+
+TEST(ProcessImageLayoutTest, AlignsBlocksAndInputs) {
+  const std::vector<ProcessImageBlock> blocks{block(false, 0, 1), block(false, 1, 3), block(false, 4, 12), block(true, 16, 2)};
+  ProcessImagePlan plan;
+  ASSERT_TRUE(planProcessImageLayout(blocks, true, maxFrameSize, capacity, plan));
+  EXPECT_EQ(plan.blocks[0].plannedOffset, 0u);
+  // 3 bytes on a 4 byte boundary, larger blocks on 8 bytes.
+  EXPECT_EQ(plan.blocks[1].plannedOffset, 4u);
+  EXPECT_EQ(plan.blocks[2].plannedOffset, 8u);
+  // the inputs start on a cache line, the padding belongs to the outputs.
+  EXPECT_EQ(plan.blocks[3].plannedOffset, 64u);
+  EXPECT_EQ(plan.outputBytes, 64u);
+  EXPECT_EQ(plan.inputBytes, 2u);
+  EXPECT_EQ(plan.frames[0], 66u);
+}
+
+TEST(ProcessImageLayoutTest, GroupsHotBlocks) {
+  const std::vector<ProcessImageBlock> blocks{block(false, 0, 4), block(false, 4, 4, true), block(true, 8, 4), block(true, 12, 4, true)};
+  ProcessImagePlan plan;
+  ASSERT_TRUE(planProcessImageLayout(blocks, false, maxFrameSize, capacity, plan));
+  EXPECT_EQ(plan.blocks[1].plannedOffset, 0u);
+  EXPECT_EQ(plan.blocks[0].plannedOffset, 4u);
+  EXPECT_EQ(plan.blocks[3].plannedOffset, 8u);
+  EXPECT_EQ(plan.blocks[2].plannedOffset, 12u);
+}
+
+TEST(ProcessImageLayoutTest, SplitsFramesAtBlocks) {
+  const std::vector<ProcessImageBlock> blocks{block(false, 0, 1000), block(false, 1000, 1000), block(true, 2000, 100)};
+  ProcessImagePlan plan;
+  ASSERT_TRUE(planProcessImageLayout(blocks, false, maxFrameSize, capacity, plan));
+  ASSERT_EQ(plan.frames.size(), 2u);
+  EXPECT_EQ(plan.frames[0], 1000u);
+  EXPECT_EQ(plan.frames[1], 1100u);
+  EXPECT_EQ(plan.inputFrame, 1u);
+  EXPECT_EQ(plan.inputFrameOffset, 1000u);
+
+  // a block larger than a frame cannot be placed.
+  EXPECT_FALSE(planProcessImageLayout({block(false, 0, 2000)}, false, maxFrameSize, capacity, plan));
+  // nor an image larger than the memory.
+  EXPECT_FALSE(planProcessImageLayout(blocks, false, maxFrameSize, 2000, plan));
+}
+
+TEST(ProcessImageLayoutTest, InputsStartingInTheNextFrame) {
+  const std::vector<ProcessImageBlock> blocks{block(false, 0, 1000), block(true, 1000, 1000)};
+  ProcessImagePlan plan;
+  ASSERT_TRUE(planProcessImageLayout(blocks, false, maxFrameSize, capacity, plan));
+  ASSERT_EQ(plan.frames.size(), 2u);
+  EXPECT_EQ(plan.inputFrame, 1u);
+  EXPECT_EQ(plan.inputFrameOffset, 0u);
+}
+
+}  // namespace ecat_master
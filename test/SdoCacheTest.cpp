@@ -0,0 +1,162 @@
+#include "EscSimulator.hpp"
+#include "VethPair.hpp"
+
+#include "ethercat_sdk_master/EthercatBus.hpp"
+#include "ethercat_sdk_master/EthercatDevice.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr uint16_t slave{1};
+constexpr uint32_t serial{0x00001234};
+
+class TestDevice : public EthercatDevice {
+ public:
+  TestDevice(EthercatBus* bus, uint32_t address) {
+    name_ = "TestDevice";
+    address_ = address;
+    setEthercatBusBasePointer(bus);
+  }
+
+  bool startup() override { return true; }
+  void updateRead() override {}
+  void updateWrite() override {}
+  void shutdown() override {}
+  PdoInfo getCurrentPdoInfo() const override { return PdoInfo{}; }
+
+  using EthercatDevice::getSdoCacheFile;
+};
+
+}  // namespace
+
+class SdoCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    line_ = std::make_unique<VethPair>("ecats");
+    if (!line_->isCreated()) {
+      GTEST_SKIP() << "Creating veth pairs requires CAP_NET_ADMIN.";
+    }
+    // the disk cache is written below $HOME.
+    const char* home = std::getenv("HOME");
+    home_ = home != nullptr ? home : "";
+    cacheHome_ = ::testing::TempDir() + "/sdo_cache_home";
+    std::filesystem::remove_all(cacheHome_);
+    setenv("HOME", cacheHome_.c_str(), 1);
+
+    simulator_ = std::make_unique<EscSimulator>(line_->getSimulatorEnd());
+    EscSimulator::SlaveDescription description;
+    description.serial = serial;
+    simulator_->addSlave(description);
+    ASSERT_TRUE(simulator_->start());
+    bus_ = std::make_unique<EthercatBus>(line_->getMasterEnd());
+    ASSERT_TRUE(bus_->startup(abort_, false));
+  }
+
+  void TearDown() override {
+    if (bus_) {
+      bus_->shutdown();
+    }
+    if (simulator_) {
+      simulator_->stop();
+    }
+    if (!cacheHome_.empty()) {
+      setenv("HOME", home_.c_str(), 1);
+      std::filesystem::remove_all(cacheHome_);
+    }
+  }
+
+  std::unique_ptr<VethPair> line_;
+  std::unique_ptr<EscSimulator> simulator_;
+  std::unique_ptr<EthercatBus> bus_;
+  std::atomic<bool> abort_{false};
+  std::string home_;
+  std::string cacheHome_;
+};
+
+TEST_F(SdoCacheTest, WriteThroughServesReads) {
+  TestDevice device(bus_.get(), slave);
+  ASSERT_TRUE(device.cachedSdoWrite(0x2000, 1, false, static_cast<uint32_t>(0x12345678)));
+  EXPECT_EQ(simulator_->getObject(slave, 0x2000, 1), (std::vector<uint8_t>{0x78, 0x56, 0x34, 0x12}));
+
+  const uint64_t uploads = simulator_->getSdoUploads(slave);
+  uint32_t value = 0;
+  ASSERT_TRUE(device.cachedSdoRead(0x2000, 1, false, value));
+  EXPECT_EQ(value, 0x12345678u);
+  EXPECT_EQ(simulator_->getSdoUploads(slave), uploads);
+}
+
+TEST_F(SdoCacheTest, ReadIsCachedUntilInvalidated) {
+  TestDevice device(bus_.get(), slave);
+  simulator_->setObject(slave, 0x2001, 0, {1, 0});
+  uint16_t value = 0;
+  ASSERT_TRUE(device.cachedSdoRead(0x2001, 0, false, value));
+  EXPECT_EQ(value, 1);
+
+  // served from the cache, the object of the slave changed meanwhile.
+  const uint64_t uploads = simulator_->getSdoUploads(slave);
+  simulator_->setObject(slave, 0x2001, 0, {2, 0});
+  ASSERT_TRUE(device.cachedSdoRead(0x2001, 0, false, value));
+  EXPECT_EQ(value, 1);
+  EXPECT_EQ(simulator_->getSdoUploads(slave), uploads);
+
+  device.invalidateSdoCache(0x2001, 0);
+  ASSERT_TRUE(device.cachedSdoRead(0x2001, 0, false, value));
+  EXPECT_EQ(value, 2);
+  EXPECT_EQ(simulator_->getSdoUploads(slave), uploads + 1);
+
+  simulator_->setObject(slave, 0x2001, 0, {3, 0});
+  device.invalidateSdoCache();
+  ASSERT_TRUE(device.cachedSdoRead(0x2001, 0, false, value));
+  EXPECT_EQ(value, 3);
+
+  // an object the slave does not have is not cached.
+  uint32_t missing = 0;
+  EXPECT_FALSE(device.cachedSdoRead(0x2fff, 0, false, missing));
+}
+
+TEST_F(SdoCacheTest, DiskCacheRoundTrip) {
+  simulator_->setObject(slave, 0x2002, 0, {7, 0, 0, 0});
+  std::string cacheFile;
+  {
+    TestDevice device(bus_.get(), slave);
+    device.setSdoDiskCacheEnabled(true);
+    uint32_t value = 0;
+    ASSERT_TRUE(device.cachedSdoRead(0x2002, 0, false, value));
+    EXPECT_EQ(value, 7u);
+    // written objects are kept in memory only.
+    ASSERT_TRUE(device.cachedSdoWrite(0x2003, 0, false, static_cast<uint8_t>(5)));
+    ASSERT_TRUE(device.flushSdoCache());
+    cacheFile = device.getSdoCacheFile();
+  }
+  ASSERT_FALSE(cacheFile.empty());
+  EXPECT_EQ(cacheFile.rfind(cacheHome_ + "/.ethercat_master/sdo_cache/", 0), 0u);
+  EXPECT_TRUE(std::filesystem::exists(cacheFile));
+
+  // a new device of the same slave loads the read object from disk, the slave has a newer value meanwhile.
+  simulator_->setObject(slave, 0x2002, 0, {8, 0, 0, 0});
+  simulator_->setObject(slave, 0x2003, 0, {6});
+  TestDevice device(bus_.get(), slave);
+  device.setSdoDiskCacheEnabled(true);
+  uint32_t value = 0;
+  ASSERT_TRUE(device.cachedSdoRead(0x2002, 0, false, value));
+  EXPECT_EQ(value, 7u);
+  uint8_t written = 0;
+  ASSERT_TRUE(device.cachedSdoRead(0x2003, 0, false, written));
+  EXPECT_EQ(written, 6);
+
+  // e.g. after a firmware update: the disk copy is removed as well.
+  device.invalidateSdoCache();
+  EXPECT_FALSE(std::filesystem::exists(cacheFile));
+  ASSERT_TRUE(device.cachedSdoRead(0x2002, 0, false, value));
+  EXPECT_EQ(value, 8u);
+}
+
+}  // namespace ecat_master
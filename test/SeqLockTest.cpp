@@ -0,0 +1,62 @@
+#include "ethercat_sdk_master/SeqLock.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+namespace ecat_master {
+
+namespace {
+
+// spans several words, a torn read shows up as differing fields.
+struct Sample {
+  uint64_t values[5];
+  uint8_t tail;
+};
+
+}  // namespace
+
+TEST(SeqLockTest, StoreAndLoad) {
+  SeqLock<Sample> lock;
+  EXPECT_EQ(lock.load().values[0], 0u);
+
+  Sample sample{{1, 2, 3, 4, 5}, 6};
+  lock.store(sample);
+  const Sample loaded = lock.load();
+  for (size_t i = 0; i < 5; i++) {
+    EXPECT_EQ(loaded.values[i], sample.values[i]);
+  }
+  EXPECT_EQ(loaded.tail, 6);
+}
+
+TEST(SeqLockTest, ReadersNeverSeeTornValues) {
+  SeqLock<Sample> lock;
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> tornReads{0};
+
+  std::thread reader([&]() {
+    while (!done) {
+      const Sample sample = lock.load();
+      for (size_t i = 1; i < 5; i++) {
+        if (sample.values[i] != sample.values[0]) {
+          tornReads++;
+        }
+      }
+      if (sample.tail != static_cast<uint8_t>(sample.values[0])) {
+        tornReads++;
+      }
+    }
+  });
+
+  for (uint64_t i = 1; i <= 200000; i++) {
+    lock.store(Sample{{i, i, i, i, i}, static_cast<uint8_t>(i)});
+  }
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(tornReads, 0u);
+  EXPECT_EQ(lock.load().values[4], 200000u);
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,73 @@
+#include "ethercat_sdk_master/SlaveStateTracker.hpp"
+
+#include <gtest/gtest.h>
+
+namespace ecat_master {
+
+namespace {
+
+constexpr uint16_t safeOp{0x04};
+constexpr uint16_t operational{0x08};
+constexpr uint16_t error{0x10};
+
+std::chrono::system_clock::time_point stampAt(int seconds) {
+  return std::chrono::system_clock::time_point{} + std::chrono::seconds(seconds);
+}
+
+}  // namespace
+
+TEST(SlaveStateTrackerTest, AlStateToString) {
+  EXPECT_EQ(alStateToString(operational), "OPERATIONAL");
+  EXPECT_EQ(alStateToString(safeOp | error), "SAFE_OP + ERROR");
+  EXPECT_EQ(alStateToString(0), "NONE");
+}
+
+TEST(SlaveStateTrackerTest, ReportsChangesOnly) {
+  SlaveStateTracker tracker;
+  tracker.reset(2);
+
+  std::vector<SlaveAlStatus> states(2, SlaveAlStatus{operational, 0});
+  // the first update records every slave.
+  EXPECT_EQ(tracker.update(states, stampAt(1)), (std::vector<uint16_t>{1, 2}));
+  EXPECT_TRUE(tracker.update(states, stampAt(2)).empty());
+  EXPECT_EQ(tracker.getLastUpdate(), stampAt(2));
+
+  states[1] = SlaveAlStatus{safeOp | error, 0x001b};
+  EXPECT_EQ(tracker.update(states, stampAt(3)), (std::vector<uint16_t>{2}));
+
+  const auto current = tracker.getCurrentState(2);
+  EXPECT_EQ(current.status, states[1]);
+  EXPECT_EQ(current.stamp, stampAt(3));
+  EXPECT_EQ(tracker.getCurrentState(1).stamp, stampAt(1));
+
+  const auto history = tracker.getHistory(2);
+  ASSERT_EQ(history.size(), 2u);
+  EXPECT_EQ(history[0].status.state, operational);
+  EXPECT_EQ(history[1].status.alStatusCode, 0x001b);
+}
+
+TEST(SlaveStateTrackerTest, HistoryIsBounded) {
+  SlaveStateTracker tracker(3);
+  tracker.reset(1);
+
+  for (int i = 0; i < 5; i++) {
+    tracker.update({SlaveAlStatus{operational, static_cast<uint16_t>(i)}}, stampAt(i));
+  }
+
+  const auto history = tracker.getHistory(1);
+  ASSERT_EQ(history.size(), 3u);
+  // oldest first.
+  EXPECT_EQ(history[0].status.alStatusCode, 2);
+  EXPECT_EQ(history[2].status.alStatusCode, 4);
+}
+
+TEST(SlaveStateTrackerTest, IgnoresMismatchedSlaveCount) {
+  SlaveStateTracker tracker;
+  tracker.reset(2);
+
+  EXPECT_TRUE(tracker.update({SlaveAlStatus{operational, 0}}, stampAt(1)).empty());
+  EXPECT_TRUE(tracker.getHistory(1).empty());
+  EXPECT_TRUE(tracker.getHistory(3).empty());
+}
+
+}  // namespace ecat_master
@@ -0,0 +1,70 @@
+#include "ethercat_sdk_master/SpscQueue.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace ecat_master {
+
+TEST(SpscQueueTest, CapacityIsPowerOfTwo) {
+  EXPECT_EQ(SpscQueue<int>(0).capacity(), 2u);
+  EXPECT_EQ(SpscQueue<int>(5).capacity(), 8u);
+  EXPECT_EQ(SpscQueue<int>(256).capacity(), 256u);
+}
+
+TEST(SpscQueueTest, FifoAndFull) {
+  SpscQueue<int> queue(4);
+  EXPECT_TRUE(queue.empty());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(queue.push(i));
+  }
+  // the element is dropped, the queue keeps the oldest ones.
+  EXPECT_FALSE(queue.push(4));
+
+  int value = -1;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.pop(value));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueueTest, WrapsAround) {
+  SpscQueue<int> queue(2);
+  int value = -1;
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(queue.push(i));
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, i);
+  }
+}
+
+TEST(SpscQueueTest, ProducerAndConsumerThreads) {
+  constexpr uint64_t count{100000};
+  SpscQueue<uint64_t> queue(64);
+
+  std::thread producer([&]() {
+    for (uint64_t i = 0; i < count; i++) {
+      while (!queue.push(i)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  // every element arrives once and in order.
+  uint64_t expected = 0;
+  uint64_t value = 0;
+  while (expected < count) {
+    if (queue.pop(value)) {
+      ASSERT_EQ(value, expected);
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace ecat_master
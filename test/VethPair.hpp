@@ -0,0 +1,59 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <string>
+
+namespace ecat_master {
+
+/*!
+ * veth pair for the tests, removed again on destruction. Creating it requires CAP_NET_ADMIN.
+ */
+class VethPair {
+ public:
+  /*!
+   * @param[in] name unique name of this pair in the test, the ends are named after it and the process id.
+   */
+  explicit VethPair(const std::string& name)
+      : masterEnd_(name + std::to_string(getpid() % 100000)), simulatorEnd_(masterEnd_ + "s") {
+    created_ = run("ip link add " + masterEnd_ + " type veth peer name " + simulatorEnd_);
+    if (created_ && !(run("ip link set " + masterEnd_ + " up") && run("ip link set " + simulatorEnd_ + " up"))) {
+      remove();
+    }
+  }
+
+  ~VethPair() {
+    if (created_) {
+      remove();
+    }
+  }
+
+  VethPair(const VethPair&) = delete;
+  VethPair& operator=(const VethPair&) = delete;
+
+  bool isCreated() const { return created_; }
+
+  /*!
+   * End used by the master and end used by the simulator.
+   */
+  const std::string& getMasterEnd() const { return masterEnd_; }
+  const std::string& getSimulatorEnd() const { return simulatorEnd_; }
+
+  /*!
+   * Remove both ends, e.g. to simulate an interface which disappears.
+   */
+  void remove() {
+    run("ip link del " + masterEnd_ + " 2> /dev/null");
+    created_ = false;
+  }
+
+ private:
+  static bool run(const std::string& command) { return std::system((command + " > /dev/null").c_str()) == 0; }
+
+  std::string masterEnd_;
+  std::string simulatorEnd_;
+  bool created_{false};
+};
+
+}  // namespace ecat_master